@@ -54,6 +54,28 @@ public:
     MRVer(const MemRegion* m, VERSION v, MSSADef* d) :
         mr(m), version(v), vid(totalVERNum++),def(d) {
     }
+    /// Constructor with an ID given by the caller
+    MRVer(const MemRegion* m, VERSION v, MRVERID id, MSSADef* d) :
+        mr(m), version(v), vid(id),def(d) {
+    }
+
+    /// Reserve num consecutive IDs and return the first one,
+    /// used to number the versions created by other threads in a fixed order
+    static inline MRVERID reserveIDs(u32_t num) {
+        MRVERID first = totalVERNum;
+        totalVERNum += num;
+        return first;
+    }
+
+    /// Get/set the version ID
+    //@{
+    inline MRVERID getID() const {
+        return vid;
+    }
+    inline void setID(MRVERID id) {
+        vid = id;
+    }
+    //@}
 
     /// Return the memory region
     inline const MemRegion* getMR() const {
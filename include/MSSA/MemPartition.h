@@ -61,6 +61,13 @@ private:
     /// Create memory regions for each points-to target.
     void createDistinctMR(const llvm::Function* func, const PointsTo& cpts);
 
+    /// Get the interned singleton cpts of an object
+    inline PtsID getSingletonCPts(NodeID id) {
+        PointsTo pts;
+        pts.set(id);
+        return internCPts(pts);
+    }
+
 };
 
 /*!
@@ -68,9 +75,9 @@ private:
  */
 class IntraDisjointMRG : public MRGenerator {
 public:
-    typedef std::map<PointsTo, PointsToList> PtsToSubPtsMap;
-    typedef std::map<const llvm::Function*, PtsToSubPtsMap> FunToPtsMap;
-    typedef std::map<const llvm::Function*, PointsToList> FunToInterMap;
+    /// Map an object to the disjoint cpts containing it
+    typedef llvm::DenseMap<NodeID, PtsID> ObjToInterMap;
+    typedef std::map<const llvm::Function*, ObjToInterMap> FunToInterMap;
 
     IntraDisjointMRG(BVDataPTAImpl* p) : MRGenerator(p)
     {}
@@ -90,37 +97,29 @@ protected:
      */
     virtual inline void getMRsForLoad(MRSet& aliasMRs, const PointsTo& cpts,
                                       const llvm::Function* fun) {
-        const PointsToList& inters = getIntersList(fun);
+        const ObjToInterMap& inters = getIntersList(fun);
         getMRsForLoadFromInterList(aliasMRs, cpts, inters);
     }
 
-    void getMRsForLoadFromInterList(MRSet& mrs, const PointsTo& cpts, const PointsToList& inters);
+    void getMRsForLoadFromInterList(MRSet& mrs, const PointsTo& cpts, const ObjToInterMap& inters);
 
     /// Get memory regions to be inserted at a load statement.
     virtual void getMRsForCallSiteRef(MRSet& aliasMRs, const PointsTo& cpts, const llvm::Function* fun);
 
     /// Create disjoint memory region
-    void createDisjointMR(const llvm::Function* func, const PointsTo& cpts);
+    void createDisjointMR(const llvm::Function* func, PtsID cpts);
 
-    /// Compute intersections between cpts and computed cpts intersections before.
-    void computeIntersections(const PointsTo& cpts, PointsToList& inters);
+    /// Partition the objects of a list of cpts into disjoint cpts.
+    void computeIntersections(const PtsIDSet& cptsList, ObjToInterMap& inters);
 
-private:
-    inline PtsToSubPtsMap& getPtsSubSetMap(const llvm::Function* func) {
-        return funcToPtsMap[func];
-    }
+    /// Collect the disjoint cpts covering cpts
+    void getIntersOfCPts(PtsIDSet& res, const PointsTo& cpts, const ObjToInterMap& inters) const;
 
-    inline PointsToList& getIntersList(const llvm::Function* func) {
+private:
+    inline ObjToInterMap& getIntersList(const llvm::Function* func) {
         return funcToInterMap[func];
     }
 
-    inline const PtsToSubPtsMap& getPtsSubSetMap(const llvm::Function* func) const {
-        FunToPtsMap::const_iterator it = funcToPtsMap.find(func);
-        assert(it != funcToPtsMap.end() && "can not find pts map for specified function");
-        return it->second;
-    }
-
-    FunToPtsMap funcToPtsMap;
     FunToInterMap funcToInterMap;
 };
 
@@ -150,7 +149,7 @@ protected:
     }
 
 private:
-    PointsToList inters;
+    ObjToInterMap inters;
 };
 
 #endif /* DISNCTMRGENERATOR_H_ */
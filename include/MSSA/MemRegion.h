@@ -35,6 +35,7 @@
 #include "Util/WorkList.h"
 
 #include <llvm/Support/raw_ostream.h>	// for output
+#include <deque>
 #include <set>
 
 typedef NodeID MRID;
@@ -88,28 +89,64 @@ public:
         return str;
     }
 
-    /// add the hash function here to sort elements and remove
-    /// and remove duplicated element in the set (binary tree comparision)
-    //@{
+    /// Order regions by their IDs, a region is created only once for a points-to set
     typedef struct {
         bool operator()(const MemRegion* lhs, const MemRegion* rhs) const {
-            return analysisUtil::cmpPts(lhs->getPointsTo(), rhs->getPointsTo());
+            return lhs->getMRID() < rhs->getMRID();
         }
     } equalMemRegion;
 
-    typedef struct {
-        bool operator()(const PointsTo& lhs, const PointsTo& rhs) const {
-            return analysisUtil::cmpPts(lhs, rhs);
-        }
-    } equalPointsTo;
-    //@}
-
     /// Return memory object number inside a region
     inline u32_t getRegionSize() const {
         return cptsSet.count();
     }
 };
 
+/*!
+ * Interning table of points-to sets.
+ * Each distinct points-to set gets a dense ID, it is hashed once when interned and found
+ * again by an open-addressing lookup, so that sets are compared only on hash collisions.
+ */
+class PtsTable {
+
+public:
+    typedef u32_t PtsID;
+    static const PtsID InvalidID = ~0U;
+
+    /// Constructor
+    PtsTable() {}
+
+    /// Return the ID of a points-to set, add it if it is new
+    PtsID intern(const PointsTo& pts);
+
+    /// Return the ID of a points-to set, InvalidID if it is not interned
+    PtsID find(const PointsTo& pts) const;
+
+    /// Return the points-to set of an ID, the reference stays valid when more sets are interned
+    inline const PointsTo& getPts(PtsID id) const {
+        assert(id < ptsList.size() && "points-to ID out of range");
+        return ptsList[id];
+    }
+
+    /// Number of interned points-to sets
+    inline u32_t size() const {
+        return ptsList.size();
+    }
+
+private:
+    static u64_t hash(const PointsTo& pts);
+
+    /// Slot of a points-to set, or the empty slot where it should be inserted
+    u32_t lookup(const PointsTo& pts, u64_t h) const;
+
+    /// Grow the slot array and re-insert all IDs
+    void rehash(u32_t numOfSlots);
+
+    std::deque<PointsTo> ptsList;
+    std::vector<u64_t> hashes;		///< hash of each points-to set
+    std::vector<u32_t> slots;		///< ID + 1 of each slot, 0 for an empty slot
+};
+
 /*!
  * Memory Region Partitioning
  */
@@ -124,9 +161,12 @@ public:
     ///Define mem region set
     typedef std::set<const MemRegion*, MemRegion::equalMemRegion> MRSet;
     typedef std::map<const PAGEdge*, const llvm::Function*> PAGEdgeToFunMap;
-    typedef std::set<PointsTo, MemRegion::equalPointsTo> PointsToList;
-    typedef std::map<const llvm::Function*, PointsToList > FunToPointsToMap;
-    typedef std::map<PointsTo, PointsTo, MemRegion::equalPointsTo > PtsToRepPtsSetMap;
+    /// Points-to sets are interned, a list of them is a set of their IDs
+    typedef PtsTable::PtsID PtsID;
+    typedef NodeBS PtsIDSet;
+    typedef std::map<const llvm::Function*, PtsIDSet> FunToPointsToMap;
+    typedef std::vector<PtsID> PtsIDToRepMap;
+    typedef std::vector<const MemRegion*> PtsIDToMRMap;
 
     /// Map a function to its region set
     typedef llvm::DenseMap<const llvm::Function*, MRSet> FunToMRsMap;
@@ -179,6 +219,8 @@ private:
     CallSiteToMRsMap callsiteToRefMRsMap;
     /// Map a callsite to its mods regions
     CallSiteToMRsMap callsiteToModMRsMap;
+    /// Regions of loads/stores/callsites without any region
+    const MRSet emptyMRSet;
     /// Map a load PAG Edge to its CPts set map
     LoadsToPointsToMap loadsToPointsToMap;
     /// Map a store PAG Edge to its CPts set map
@@ -213,14 +255,14 @@ private:
     /// Clean up memory
     void destroy();
 
-    /// Get superset cpts set
-    inline const PointsTo& getRepPointsTo(const PointsTo& cpts) const {
-        PtsToRepPtsSetMap::const_iterator it = cptsToRepCPtsMap.find(cpts);
-        assert(it!=cptsToRepCPtsMap.end() && "can not find superset of cpts??");
-        return it->second;
-    }
-    /// Get a memory region according to cpts
-    const MemRegion* getMR(const PointsTo& cpts) const;
+    /// Interned cpts sets
+    PtsTable ptsTable;
+    /// Map a cpts ID to its rep cpts ID (super set points-to), InvalidID if it has not been sorted
+    PtsIDToRepMap cptsToRepCPtsMap;
+    /// IDs of the cpts which have a rep
+    PtsIDSet sortedCPts;
+    /// Map a rep cpts ID to its memory region
+    PtsIDToMRMap repCPtsToMRMap;
 
     //Get all objects might pass into callee from a callsite
     void collectCallSitePts(llvm::CallSite cs);
@@ -250,11 +292,56 @@ protected:
 
     /// A set of All memory regions
     MRSet memRegSet;
+
+    /// Interned cpts sets
+    //@{
+    inline PtsID internCPts(const PointsTo& cpts) {
+        return ptsTable.intern(cpts);
+    }
+    inline PtsID getCPtsID(const PointsTo& cpts) const {
+        PtsID id = ptsTable.find(cpts);
+        assert(id != PtsTable::InvalidID && "cpts not interned!!");
+        return id;
+    }
+    inline const PointsTo& getCPts(PtsID id) const {
+        return ptsTable.getPts(id);
+    }
+    /// Get the IDs of a set of cpts sorted by analysisUtil::cmpPts (size, then objects), the order of the former std::set
+    void getCPtsInOrder(const PtsIDSet& ids, std::vector<PtsID>& ordered) const;
+    //@}
+
     /// Map a condition pts to its rep conditional pts (super set points-to)
-    PtsToRepPtsSetMap cptsToRepCPtsMap;
+    //@{
+    inline bool hasRepCPts(PtsID id) const {
+        return id < cptsToRepCPtsMap.size() && cptsToRepCPtsMap[id] != PtsTable::InvalidID;
+    }
+    inline PtsID getRepCPts(PtsID id) const {
+        assert(hasRepCPts(id) && "can not find superset of cpts??");
+        return cptsToRepCPtsMap[id];
+    }
+    inline void setRepCPts(PtsID id, PtsID rep) {
+        if (id >= cptsToRepCPtsMap.size())
+            cptsToRepCPtsMap.resize(ptsTable.size(), PtsTable::InvalidID);
+        cptsToRepCPtsMap[id] = rep;
+        sortedCPts.set(id);
+    }
+    //@}
 
     /// Generate a memory region and put in into functions which use it
-    void createMR(const llvm::Function* fun, const PointsTo& cpts);
+    //@{
+    void createMR(const llvm::Function* fun, PtsID cpts);
+    inline void createMR(const llvm::Function* fun, const PointsTo& cpts) {
+        createMR(fun, getCPtsID(cpts));
+    }
+    //@}
+
+    /// Get a memory region according to cpts
+    //@{
+    const MemRegion* getMR(PtsID cpts) const;
+    inline const MemRegion* getMR(const PointsTo& cpts) const {
+        return getMR(getCPtsID(cpts));
+    }
+    //@}
 
     /// Collect all global variables for later escape analysis
     void collectGlobals();
@@ -272,7 +359,7 @@ protected:
     virtual void updateAliasMRs();
 
     /// Given a condition pts, insert into cptsToRepCPtsMap for region generation
-    virtual void sortPointsTo(const PointsTo& cpts);
+    virtual void sortPointsTo(PtsID cpts);
 
     /// Whether a region is aliased with a conditional points-to
     virtual inline bool isAliasedMR(const PointsTo& cpts, const MemRegion* mr) {
@@ -305,26 +392,26 @@ protected:
     //@{
     inline void addCPtsToStore(PointsTo& cpts, const StorePE *st, const llvm::Function* fun) {
         storesToPointsToMap[st] = cpts;
-        funToPointsToMap[fun].insert(cpts);
+        funToPointsToMap[fun].set(internCPts(cpts));
         addModSideEffectOfFunction(fun,cpts);
     }
     inline void addCPtsToLoad(PointsTo& cpts, const LoadPE *ld, const llvm::Function* fun) {
         loadsToPointsToMap[ld] = cpts;
-        funToPointsToMap[fun].insert(cpts);
+        funToPointsToMap[fun].set(internCPts(cpts));
         addRefSideEffectOfFunction(fun,cpts);
     }
     inline void addCPtsToCallSiteRefs(PointsTo& cpts, llvm::CallSite cs) {
         callsiteToRefPointsToMap[cs] = cpts;
-        funToPointsToMap[cs.getCaller()].insert(cpts);
+        funToPointsToMap[cs.getCaller()].set(internCPts(cpts));
     }
     inline void addCPtsToCallSiteMods(PointsTo& cpts, llvm::CallSite cs) {
         callsiteToModPointsToMap[cs] = cpts;
-        funToPointsToMap[cs.getCaller()].insert(cpts);
+        funToPointsToMap[cs.getCaller()].set(internCPts(cpts));
     }
     inline bool hasCPtsList(const llvm::Function* fun) const {
         return funToPointsToMap.find(fun)!=funToPointsToMap.end();
     }
-    inline PointsToList& getPointsToList(const llvm::Function* fun) {
+    inline PtsIDSet& getPointsToList(const llvm::Function* fun) {
         return funToPointsToMap[fun];
     }
     inline FunToPointsToMap& getFunToPointsToList() {
@@ -392,23 +479,29 @@ public:
     inline MRSet& getFunMRSet(const llvm::Function* fun) {
         return funToMRsMap[fun];
     }
-    inline MRSet& getLoadMRSet(const LoadPE* load) {
-        return loadsToMRsMap[load];
+    /// The lookups of loads/stores/callsites do not change the maps,
+    /// so they can be used by multiple threads building memory SSA
+    inline const MRSet& getLoadMRSet(const LoadPE* load) const {
+        LoadsToMRsMap::const_iterator it = loadsToMRsMap.find(load);
+        return it != loadsToMRsMap.end() ? it->second : emptyMRSet;
     }
-    inline MRSet& getStoreMRSet(const StorePE* store) {
-        return storesToMRsMap[store];
+    inline const MRSet& getStoreMRSet(const StorePE* store) const {
+        StoresToMRsMap::const_iterator it = storesToMRsMap.find(store);
+        return it != storesToMRsMap.end() ? it->second : emptyMRSet;
     }
-    inline bool hasRefMRSet(llvm::CallSite cs) {
+    inline bool hasRefMRSet(llvm::CallSite cs) const {
         return callsiteToRefMRsMap.find(cs)!=callsiteToRefMRsMap.end();
     }
-    inline bool hasModMRSet(llvm::CallSite cs) {
+    inline bool hasModMRSet(llvm::CallSite cs) const {
         return callsiteToModMRsMap.find(cs)!=callsiteToModMRsMap.end();
     }
-    inline MRSet& getCallSiteRefMRSet(llvm::CallSite cs) {
-        return callsiteToRefMRsMap[cs];
+    inline const MRSet& getCallSiteRefMRSet(llvm::CallSite cs) const {
+        CallSiteToMRsMap::const_iterator it = callsiteToRefMRsMap.find(cs);
+        return it != callsiteToRefMRsMap.end() ? it->second : emptyMRSet;
     }
-    inline MRSet& getCallSiteModMRSet(llvm::CallSite cs) {
-        return callsiteToModMRsMap[cs];
+    inline const MRSet& getCallSiteModMRSet(llvm::CallSite cs) const {
+        CallSiteToMRsMap::const_iterator it = callsiteToModMRsMap.find(cs);
+        return it != callsiteToModMRsMap.end() ? it->second : emptyMRSet;
     }
     //@}
     /// Whether this instruction has PAG Edge
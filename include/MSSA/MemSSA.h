@@ -41,6 +41,22 @@
 
 class PointerAnalysis;
 class MemSSAStat;
+
+/*!
+ * Dominator frontier used in MSSA
+ */
+class MemSSADF : public llvm::DominanceFrontier {
+public:
+    MemSSADF() : llvm::DominanceFrontier()
+    {}
+
+    bool runOnDT(llvm::DominatorTree& dt) {
+        releaseMemory();
+        analyze(dt);
+        return false;
+    }
+};
+
 /*
  * Memory SSA implementation on top of partial SSA
  */
@@ -61,9 +77,17 @@ public:
     typedef MSSAPHI<Condition> PHI;
     typedef MSSADEF MDEF;
 
-    typedef std::set<MU*> MUSet;
-    typedef std::set<CHI*> CHISet;
-    typedef std::set<PHI*> PHISet;
+    /// Order mus/chis/phis by their regions, a statement has at most one of them for a region.
+    /// The order does not depend on where they are allocated, so it stays the same when functions are built in parallel.
+    template<class T>
+    struct cmpByMR {
+        bool operator()(const T* lhs, const T* rhs) const {
+            return lhs->getMR()->getMRID() < rhs->getMR()->getMRID();
+        }
+    };
+    typedef std::set<MU*, cmpByMR<MU> > MUSet;
+    typedef std::set<CHI*, cmpByMR<CHI> > CHISet;
+    typedef std::set<PHI*, cmpByMR<PHI> > PHISet;
 
     ///Define mem region set
     typedef MRGenerator::MRSet MRSet;
@@ -95,6 +119,8 @@ public:
 
     /// PAG edge list
     typedef PAG::PAGEdgeList PAGEdgeList;
+    /// Functions to build memory SSA for
+    typedef std::vector<llvm::Function*> FunctionVec;
 
     /// Statistics
     //@{
@@ -143,6 +169,23 @@ private:
     MRSet varKills;
     //@}
 
+    /// Memory SSA whose functions are built by this worker, NULL if this is not a worker
+    MemSSA* parent;
+    /// Versions created by this worker, in the order they are created
+    std::vector<MRVer*> workerVers;
+
+    /// Work shared by the threads building memory SSA
+    struct BuildSchedule;
+
+    /// Constructor of a worker which builds a function of the parent, it shares the regions of the parent
+    MemSSA(MemSSA* p);
+
+    /// Build memory SSA of the functions taken from the schedule, each into its own worker
+    void buildMemSSAInThread(BuildSchedule* schedule);
+
+    /// Move the mus/chis/phis of a worker into this memory SSA and number its versions
+    void mergeWorker(MemSSA* worker);
+
     /// Release the memory
     void destroy();
 
@@ -297,6 +340,10 @@ public:
     /// We start from here
     virtual void buildMemSSA(const llvm::Function& fun,llvm::DominanceFrontier*, llvm::DominatorTree*);
 
+    /// Build memory SSA of functions by multiple threads.
+    /// The results are merged in the order of funs, they are the same as building the functions one by one.
+    void buildMemSSAInParallel(const FunctionVec& funs, u32_t numOfThreads);
+
     /// Perform statistics
     void performStat();
 
@@ -400,6 +447,9 @@ public:
 
     /// Print Memory SSA
     void dumpMSSA(llvm::raw_ostream & Out = llvm::outs());
+
+    /// Print the ID of every memory SSA version (-dump-mrver-ids)
+    void dumpMRVerIDs(llvm::raw_ostream & Out = llvm::outs());
 };
 
 #endif /* MEMORYSSAPASS_H_ */
@@ -30,23 +30,8 @@
 #ifndef ANDERSENMEMSSA_H_
 #define ANDERSENMEMSSA_H_
 
+#include "MSSA/MemSSA.h"
 #include "MSSA/SVFGOPT.h"
-#include <llvm/Analysis/DominanceFrontier.h>
-
-/*!
- * Dominator frontier used in MSSA
- */
-class MemSSADF : public llvm::DominanceFrontier {
-public:
-    MemSSADF() : llvm::DominanceFrontier()
-    {}
-
-    bool runOnDT(llvm::DominatorTree& dt) {
-        releaseMemory();
-        analyze(dt);
-        return false;
-    }
-};
 
 /*!
  * SVFG Builder
@@ -0,0 +1,185 @@
+/*
+ * AccessPartition.h
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#ifndef ACCESSPARTITION_H_
+#define ACCESSPARTITION_H_
+
+#include "MemoryModel/PointerAnalysis.h"
+#include <llvm/IR/Instructions.h>
+#include <vector>
+#include <map>
+
+/*!
+ * A load or store which may take part in a data race, together with
+ * its summary computed once after pointer analysis
+ */
+class MTAAccess {
+public:
+    /// Handle of an interned set of shared objects, 0 is the empty set
+    typedef u32_t ObjsID;
+
+    /// Constructor
+    MTAAccess(const llvm::Instruction* i, const llvm::Value* p, bool w) :
+        inst(i), ptr(p), objsID(0), write(w), unknown(false) {
+    }
+    /// Get the accessing instruction
+    inline const llvm::Instruction* getInstruction() const {
+        return inst;
+    }
+    /// Get the accessed pointer
+    inline const llvm::Value* getPointer() const {
+        return ptr;
+    }
+    /// Get the handle of the shared objects it touches
+    inline ObjsID getObjsID() const {
+        return objsID;
+    }
+    /// Whether it is a store
+    inline bool isWrite() const {
+        return write;
+    }
+    /// Whether it touches at least one shared object
+    inline bool isShared() const {
+        return objsID != 0;
+    }
+    /// Whether its points-to set contains the black hole
+    inline bool isUnknown() const {
+        return unknown;
+    }
+    /// Fill in the summary
+    inline void setSummary(ObjsID id, bool u) {
+        objsID = id;
+        unknown = u;
+    }
+private:
+    const llvm::Instruction* inst;
+    const llvm::Value* ptr;
+    ObjsID objsID;
+    bool write;
+    bool unknown;
+};
+
+/*!
+ * Candidate pair generation for race detection.
+ *
+ * Every load/store is given a dense AccessID, and accesses are bucketed by the
+ * shared abstract objects (global, static and heap) in their points-to sets.
+ * Two accesses are a candidate pair only if they fall into a common bucket
+ * and at least one of them is a write, so the later MHP and lockset checks
+ * only see pairs which really alias instead of all N^2 pairs.
+ *
+ * Accesses whose points-to set contains the black hole object are treated
+ * as unknown; they are paired with every shared access.
+ *
+ * The per-access facts (sharing, touched objects) are computed
+ * once in run(). Sets of shared objects are interned, so accesses through the same
+ * pointer, or through pointers with equal sets, share one set and one partner cache.
+ */
+class AccessPartitioning {
+
+public:
+    typedef u32_t AccessID;
+    typedef MTAAccess::ObjsID ObjsID;
+    typedef std::vector<MTAAccess> AccessVec;
+
+    /*!
+     * Accesses touching one abstract object
+     */
+    struct Bucket {
+        NodeBS accesses;	///< all accesses of this object
+        NodeBS writes;		///< write accesses of this object
+    };
+    typedef std::map<NodeID, Bucket> ObjToBucketMap;
+
+    /*!
+     * An interned set of shared objects and the partners of accesses touching it
+     */
+    struct ObjsEntry {
+        PointsTo objs;			///< shared objects and their fields
+        NodeBS writePartners;	///< partners of a write, i.e., all accesses of the buckets
+        NodeBS readPartners;	///< partners of a read, i.e., writes of the buckets
+    };
+    typedef std::vector<ObjsEntry> ObjsTable;
+    typedef std::map<NodeID, ObjsID> PtrToObjsIDMap;
+    typedef std::multimap<size_t, ObjsID> HashToObjsIDMap;
+
+    /// Constructor
+    AccessPartitioning(PointerAnalysis* p) : pta(p) {
+    }
+
+    /// Collect all loads and stores of a module
+    void collectAccesses(llvm::Module& module);
+
+    /// Summarise the collected accesses and bucket them by their shared objects
+    void run();
+
+    /// Get candidate partners of an access.
+    /// Only partners with larger AccessIDs are returned so that each pair is visited once,
+    /// plus the access itself if it is a write, which races with itself when run by several threads.
+    void getCandidatePartners(AccessID id, NodeBS& partners) const;
+
+    /// Get access details
+    //@{
+    inline u32_t getNumOfAccesses() const {
+        return accesses.size();
+    }
+    inline const MTAAccess& getAccess(AccessID id) const {
+        return accesses[id];
+    }
+    inline const llvm::Instruction* getInstruction(AccessID id) const {
+        return accesses[id].getInstruction();
+    }
+    inline bool isWrite(AccessID id) const {
+        return accesses[id].isWrite();
+    }
+    /// Whether an access touches at least one shared object
+    inline bool isSharedAccess(AccessID id) const {
+        return accesses[id].isShared();
+    }
+    /// Whether an access may touch any object
+    inline bool isUnknownAccess(AccessID id) const {
+        return accesses[id].isUnknown();
+    }
+    //@}
+
+    /// Get the number of object buckets
+    inline u32_t getNumOfBuckets() const {
+        return objToBucket.size();
+    }
+    /// Get the number of distinct sets of shared objects
+    inline u32_t getNumOfObjsSets() const {
+        return objsTable.size() - 1;
+    }
+
+    /// Print partitioning statistics
+    void print() const;
+
+private:
+    /// Whether an object may be accessed by more than one thread
+    bool isSharedObj(NodeID obj) const;
+
+    /// Add an object and all its fields (if it is a base object) to objs
+    void addObjAndFields(NodeID obj, PointsTo& objs) const;
+
+    /// Compute (or look up) the interned set of shared objects pointed to by a pointer
+    ObjsID getObjsOfPointer(NodeID ptr);
+
+    /// Intern a set of shared objects
+    ObjsID internObjs(const PointsTo& objs);
+
+    PointerAnalysis* pta;		///< pointer analysis
+    AccessVec accesses;			///< AccessID -> access summary
+    ObjsTable objsTable;		///< ObjsID -> interned set of shared objects
+    PtrToObjsIDMap ptrToObjsID;	///< pointer node -> ObjsID
+    HashToObjsIDMap hashToObjsID;	///< hash of a set -> ObjsIDs
+    ObjToBucketMap objToBucket;	///< object -> accesses
+    NodeBS sharedAccesses;		///< accesses touching a shared object
+    NodeBS sharedWrites;		///< writes touching a shared object
+    NodeBS unknownAccesses;		///< accesses pointing to the black hole
+    NodeBS unknownWrites;		///< writes pointing to the black hole
+};
+
+#endif /* ACCESSPARTITION_H_ */
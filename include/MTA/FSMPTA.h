@@ -30,6 +30,9 @@ public:
     typedef NodeBS SVFGNodeIDSet;
     typedef std::set<const llvm::Instruction*> InstSet;
     typedef std::pair<NodeID,NodeID> NodeIDPair;
+    typedef llvm::DenseMap<NodeID, SVFGNodeIDSet> ObjToSVFGNodesMap;
+    typedef std::vector<std::pair<NodeIDPair, PointsTo> > RecordedEdgeVec;
+    typedef llvm::DenseMap<NodeIDPair, u32_t> EdgeToRecordMap;
 
     typedef std::pair<const StmtSVFGNode*, LockAnalysis::LockSpan> SVFGNodeLockSpanPair;
     typedef std::map<SVFGNodeLockSpanPair, bool> PairToBoolMap;
@@ -51,15 +54,19 @@ protected:
 
 private:
     /// Record edges
-    bool recordEdge(NodeID id1, NodeID id2, PointsTo pts);
-    bool recordAddingEdge(NodeID id1, NodeID id2, PointsTo pts);
-    bool recordRemovingEdge(NodeID id1, NodeID id2, PointsTo pts);
+    bool recordEdge(NodeID id1, NodeID id2, const PointsTo& pts);
+    bool recordAddingEdge(NodeID id1, NodeID id2, const PointsTo& pts);
+    bool recordRemovingEdge(NodeID id1, NodeID id2, const PointsTo& pts);
     /// perform adding/removing MHP Edges in value flow graph
     void performAddingMHPEdges();
     void performRemovingMHPEdges();
-    SVFGEdge* addTDEdges(NodeID srcId, NodeID dstId, PointsTo& pts);
+    SVFGEdge* addTDEdges(NodeID srcId, NodeID dstId, const PointsTo& pts);
     /// Connect MHP indirect value-flow edges for two nodes that may-happen-in-parallel
     void connectMHPEdges(PointerAnalysis* pta);
+    /// Check the stores and loads accessing a common object of each store
+    void connectMHPEdgesByObjects(PointerAnalysis* pta);
+    /// Check all pairs of stores and loads, for the models which do not filter pairs by alias
+    void connectMHPEdgesOfAllPairs(PointerAnalysis* pta);
 
     void handleStoreLoadNonSparse(const StmtSVFGNode* n1,const StmtSVFGNode* n2, PointerAnalysis* pta);
     void handleStoreStoreNonSparse(const StmtSVFGNode* n1,const StmtSVFGNode* n2, PointerAnalysis* pta);
@@ -77,25 +84,30 @@ private:
     SVFGNodeIDSet getSuccNodes(const StmtSVFGNode* n);
     SVFGNodeIDSet getSuccNodes(const StmtSVFGNode* n, NodeID o);
 
-    bool isHeadofSpan(const StmtSVFGNode* n, LockAnalysis::LockSpan lspan);
-    bool isTailofSpan(const StmtSVFGNode* n, LockAnalysis::LockSpan lspan);
+    bool isHeadofSpan(const StmtSVFGNode* n, const LockAnalysis::LockSpan& lspan);
+    bool isTailofSpan(const StmtSVFGNode* n, const LockAnalysis::LockSpan& lspan);
     bool isHeadofSpan(const StmtSVFGNode* n, InstSet mergespan);
     bool isTailofSpan(const StmtSVFGNode* n, InstSet mergespan);
     bool isHeadofSpan(const StmtSVFGNode* n);
     bool isTailofSpan(const StmtSVFGNode* n);
-    /// Collect all loads/stores SVFGNodes
-    void collectLoadStoreSVFGNodes();
+    /// Collect all loads/stores SVFGNodes and index them by the objects they access
+    void collectLoadStoreSVFGNodes(PointerAnalysis* pta);
 
     /// all stores/loads SVFGNodes
     SVFGNodeSet stnodeSet;
     SVFGNodeSet ldnodeSet;
 
+    /// object -> stores/loads SVFGNodes accessing it
+    ObjToSVFGNodesMap objToStores;
+    ObjToSVFGNodesMap objToLoads;
+
     /// MHP class
     MHP* mhp;
     LockAnalysis* lockana;
 
-    std::set<NodeIDPair> recordedges;
-    std::map<NodeIDPair, PointsTo> edge2pts;
+    /// edges to be added/removed in bulk, in the order they are first recorded
+    RecordedEdgeVec recordedges;
+    EdgeToRecordMap edgeToRecord;
 
 
     std::map<const StmtSVFGNode*, SVFGNodeIDSet> prevset;
@@ -35,31 +35,37 @@ public:
     typedef CxtStmt CxtLock;
     typedef CxtProc CxtLockProc;
 
+    /// Locksets are bitsets of dense lock IDs, i.e., LockSiteIDs for
+    /// intra-procedural locks and CxtLockIDs for context-sensitive locks
+    typedef NodeID LockSiteID;
+    typedef NodeID CxtLockID;
     typedef NodeBS LockSet;
+    typedef std::vector<LockSet> LockSetVec;
     typedef TCT::InstVec InstVec;
     typedef std::set<const llvm::Instruction*> InstSet;
     typedef InstSet CISpan;
     typedef std::map<const llvm::Instruction*, CISpan>CILockToSpan;
     typedef std::set<const llvm::Function*> FunSet;
     typedef std::map<const llvm::Instruction*, InstSet> InstToInstSetMap;
+    typedef std::map<const llvm::Instruction*, LockSet> InstToLockSetMap;
+    typedef std::map<const llvm::Instruction*, LockSiteID> LockSiteToIDMap;
     typedef std::map<const CxtStmt, ValDomain> CxtStmtToLockFlagMap;
     typedef FIFOWorkList<CxtStmt> CxtStmtWorkList;
     typedef std::set<CxtStmt> LockSpan;
     typedef std::set<CxtStmt> CxtStmtSet;
-    typedef std::set<CxtLock> CxtLockSet;
+    typedef std::vector<CxtLock> CxtLockVec;
+    typedef std::map<CxtLock, CxtLockID> CxtLockToIDMap;
 
     typedef std::map<CxtLock, LockSpan> CxtLockToSpan;
-    typedef std::map<CxtLock, NodeBS> CxtLockToLockSet;
-    typedef std::map<const llvm::Instruction*, NodeBS> LockSiteToLockSet;
     typedef std::map<const llvm::Instruction*, LockSpan> InstToCxtStmtSet;
-    typedef std::map<const CxtStmt, CxtLockSet> CxtStmtToCxtLockSet;
+    typedef std::map<const CxtStmt, LockSet> CxtStmtToLockSet;
     typedef FIFOWorkList<CxtLockProc> CxtLockProcVec;
     typedef set<CxtLockProc> CxtLockProcSet;
 
     typedef std::pair<const llvm::Function*,const llvm::Function*> FuncPair;
     typedef std::map<FuncPair, bool> FuncPairToBool;
 
-    LockAnalysis(TCT* t) : tct(t), lockTime(0),numOfTotalQueries(0), numOfLockedQueries(0), lockQueriesTime(0) {
+    LockAnalysis(TCT* t) : tct(t), numOfLockClasses(0), lockTime(0),numOfTotalQueries(0), numOfLockedQueries(0), lockQueriesTime(0) {
     }
 
     /// context-sensitive forward traversal from each lock site. Generate following results
@@ -76,6 +82,30 @@ public:
     void collectLockUnlocksites();
     void buildCandidateFuncSetforLock();
 
+    /// Number lock sites and group them into alias classes
+    void buildLockAliasClasses();
+    /// Compute the aliased context-sensitive locks of each context-sensitive lock
+    void buildCxtLockAliases();
+
+    /// Lock sites
+    //@{
+    inline u32_t getNumOfLockSites() const {
+        return lockSites.size();
+    }
+    inline LockSiteID getLockSiteID(const llvm::Instruction* lockSite) const {
+        LockSiteToIDMap::const_iterator it = lockSiteToID.find(lockSite);
+        assert(it != lockSiteToID.end() && "not a lock site?");
+        return it->second;
+    }
+    inline const llvm::Instruction* getLockSite(LockSiteID id) const {
+        assert(id < lockSites.size() && "lock site id out of range");
+        return lockSites[id];
+    }
+    inline u32_t getNumOfLockClasses() const {
+        return numOfLockClasses;
+    }
+    //@}
+
     /// Intraprocedural locks
     //@{
     /// Return true if the lock is an intra-procedural lock
@@ -86,8 +116,9 @@ public:
 
     /// Add intra-procedural lock
     inline void addIntraLock(const llvm::Instruction* lockSite, const InstSet& stmts) {
+        LockSiteID id = getLockSiteID(lockSite);
         for(InstSet::const_iterator it = stmts.begin(), eit = stmts.end(); it!=eit; ++it) {
-            instCILocksMap[*it].insert(lockSite);
+            instCILocksMap[*it].set(id);
             ciLocktoSpan[lockSite].insert(*it);
         }
     }
@@ -109,8 +140,9 @@ public:
         return instTocondCILocksMap.find(stmt)!=instTocondCILocksMap.end();
     }
 
-    inline const InstSet& getIntraLockSet(const llvm::Instruction* stmt) const {
-        InstToInstSetMap::const_iterator it = instCILocksMap.find(stmt);
+    /// Get the LockSiteIDs of the intra-procedural locks protecting a statement
+    inline const LockSet& getIntraLockSet(const llvm::Instruction* stmt) const {
+        InstToLockSetMap::const_iterator it = instCILocksMap.find(stmt);
         assert(it!=instCILocksMap.end() && "intralock not found!");
         return it->second;
     }
@@ -121,34 +153,31 @@ public:
     /// Add inter-procedural context-sensitive lock
     inline void addCxtLock(const CallStrCxt& cxt,const llvm::Instruction* inst) {
         CxtLock cxtlock(cxt,inst);
-        cxtLockset.insert(cxtlock);
+        if(cxtLockToID.insert(std::make_pair(cxtlock, (CxtLockID)cxtLocks.size())).second)
+            cxtLocks.push_back(cxtlock);
         DBOUT(DMTA, llvm::outs() << "LockAnalysis Process new lock "; cxtlock.dump());
     }
 
     /// Get context-sensitive lock
     inline bool hasCxtLock(const CxtLock& cxtLock) const {
-        return cxtLockset.find(cxtLock)!=cxtLockset.end();
+        return cxtLockToID.find(cxtLock)!=cxtLockToID.end();
     }
-
-    /// Return true if the intersection of two locksets is not empty
-    inline bool intersects(const CxtLockSet& lockset1,const CxtLockSet& lockset2) const {
-        for(CxtLockSet::const_iterator it = lockset1.begin(), eit = lockset2.end(); it!=eit; ++it) {
-            const CxtLock& lock = *it;
-            for(CxtLockSet::const_iterator lit = lockset1.begin(), elit = lockset2.end(); lit!=elit; ++lit) {
-                if(lock==*lit)
-                    return true;
-            }
-        }
-        return false;
+    inline CxtLockID getCxtLockID(const CxtLock& cxtLock) const {
+        CxtLockToIDMap::const_iterator it = cxtLockToID.find(cxtLock);
+        assert(it != cxtLockToID.end() && "context-sensitive lock not found!");
+        return it->second;
     }
-    /// Return true if two locksets has at least one alias lock
-    inline bool alias(const CxtLockSet& lockset1,const CxtLockSet& lockset2) {
-        for(CxtLockSet::const_iterator it = lockset1.begin(), eit = lockset1.end(); it!=eit; ++it) {
-            const CxtLock& lock = *it;
-            for(CxtLockSet::const_iterator lit = lockset2.begin(), elit = lockset2.end(); lit!=elit; ++lit) {
-                if(isAliasedLocks(lock,*lit))
-                    return true;
-            }
+    inline const CxtLock& getCxtLock(CxtLockID id) const {
+        assert(id < cxtLocks.size() && "context-sensitive lock id out of range");
+        return cxtLocks[id];
+    }
+
+    /// Return true if two locksets have at least one aliased lock.
+    /// Each lock of lockset1 costs one bitset intersection, no alias query is issued.
+    inline bool alias(const LockSet& lockset1,const LockSet& lockset2) const {
+        for(LockSet::iterator it = lockset1.begin(), eit = lockset1.end(); it!=eit; ++it) {
+            if(cxtLockAliases[*it].intersects(lockset2))
+                return true;
         }
         return false;
     }
@@ -161,48 +190,49 @@ public:
 
     /// Context-sensitive statement and lock spans
     //@{
-    /// Get LockSet and LockSpan
+    /// Get LockSet and LockSpan, the context-sensitive statements of an instruction are those of its region leader
     inline bool hasCxtStmtfromInst(const llvm::Instruction* inst) const {
-        InstToCxtStmtSet::const_iterator it = instToCxtStmtSet.find(inst);
+        InstToCxtStmtSet::const_iterator it = instToCxtStmtSet.find(tct->getRegionLeader(inst));
         return (it != instToCxtStmtSet.end());
     }
     inline const CxtStmtSet& getCxtStmtfromInst(const llvm::Instruction* inst) const {
-        InstToCxtStmtSet::const_iterator it = instToCxtStmtSet.find(inst);
+        InstToCxtStmtSet::const_iterator it = instToCxtStmtSet.find(tct->getRegionLeader(inst));
         assert(it != instToCxtStmtSet.end());
         return it->second;
     }
     inline bool hasCxtLockfromCxtStmt(const CxtStmt& cts) const {
-        CxtStmtToCxtLockSet::const_iterator it = cxtStmtToCxtLockSet.find(cts);
-        return (it != cxtStmtToCxtLockSet.end());
+        CxtStmtToLockSet::const_iterator it = cxtStmtToLockSet.find(cts);
+        return (it != cxtStmtToLockSet.end());
     }
-    inline const CxtLockSet& getCxtLockfromCxtStmt(const CxtStmt& cts) const {
-        CxtStmtToCxtLockSet::const_iterator it = cxtStmtToCxtLockSet.find(cts);
-        assert(it != cxtStmtToCxtLockSet.end());
+    inline const LockSet& getCxtLockfromCxtStmt(const CxtStmt& cts) const {
+        CxtStmtToLockSet::const_iterator it = cxtStmtToLockSet.find(cts);
+        assert(it != cxtStmtToLockSet.end());
         return it->second;
     }
-    inline CxtLockSet& getCxtLockfromCxtStmt(const CxtStmt& cts) {
-        CxtStmtToCxtLockSet::iterator it = cxtStmtToCxtLockSet.find(cts);
-        assert(it != cxtStmtToCxtLockSet.end());
+    inline LockSet& getCxtLockfromCxtStmt(const CxtStmt& cts) {
+        CxtStmtToLockSet::iterator it = cxtStmtToLockSet.find(cts);
+        assert(it != cxtStmtToLockSet.end());
         return it->second;
     }
     /// Add context-sensitive statement
-    inline bool addCxtStmtToSpan(const CxtStmt& cts, const CxtLock& cl) {
-        cxtLocktoSpan[cl].insert(cts);
-        return cxtStmtToCxtLockSet[cts].insert(cl).second;
+    inline bool addCxtStmtToSpan(const CxtStmt& cts, CxtLockID cl) {
+        cxtLocktoSpan[cxtLocks[cl]].insert(cts);
+        return cxtStmtToLockSet[cts].test_and_set(cl);
     }
     /// Add context-sensitive statement
-    inline bool removeCxtStmtToSpan(CxtStmt& cts, const CxtLock& cl) {
-        bool find = cxtStmtToCxtLockSet[cts].find(cl)!=cxtStmtToCxtLockSet[cts].end();
+    inline bool removeCxtStmtToSpan(CxtStmt& cts, CxtLockID cl) {
+        LockSet& lockset = cxtStmtToLockSet[cts];
+        bool find = lockset.test(cl);
         if(find) {
-            cxtStmtToCxtLockSet[cts].erase(cl);
-            cxtLocktoSpan[cl].erase(cts);
+            lockset.reset(cl);
+            cxtLocktoSpan[cxtLocks[cl]].erase(cts);
         }
         return find;
     }
 
     /// Touch this context statement
     inline void touchCxtStmt(CxtStmt& cts) {
-        cxtStmtToCxtLockSet[cts];
+        cxtStmtToLockSet[cts];
     }
     inline bool hasSpanfromCxtLock(const CxtLock& cl) {
         return cxtLocktoSpan.find(cl) != cxtLocktoSpan.end();
@@ -216,10 +246,10 @@ public:
 
 
     /// Check if one instruction's context stmt is in a lock span
-    inline bool hasOneCxtInLockSpan(const llvm::Instruction *I, LockSpan lspan) const {
+    inline bool hasOneCxtInLockSpan(const llvm::Instruction *I, const LockSpan& lspan) const {
         if(!hasCxtStmtfromInst(I))
             return false;
-        const LockSpan ctsset = getCxtStmtfromInst(I);
+        const LockSpan& ctsset = getCxtStmtfromInst(I);
         for (LockSpan::const_iterator cts = ctsset.begin(), ects = ctsset.end(); cts != ects; cts++) {
             if(lspan.find(*cts) != lspan.end()) {
                 return true;
@@ -228,10 +258,10 @@ public:
         return false;
     }
 
-    inline bool hasAllCxtInLockSpan(const llvm::Instruction *I, LockSpan lspan) const {
+    inline bool hasAllCxtInLockSpan(const llvm::Instruction *I, const LockSpan& lspan) const {
         if(!hasCxtStmtfromInst(I))
             return false;
-        const LockSpan ctsset = getCxtStmtfromInst(I);
+        const LockSpan& ctsset = getCxtStmtfromInst(I);
         for (LockSpan::const_iterator cts = ctsset.begin(), ects = ctsset.end(); cts != ects; cts++) {
             if (lspan.find(*cts) == lspan.end()) {
                 return false;
@@ -245,17 +275,21 @@ public:
     /// echo inst may have multiple cxt stmt
     /// we check whether every cxt stmt of instructions is protected by a common lock.
     bool isProtectedByCommonLock(const llvm::Instruction *i1, const llvm::Instruction *i2);
-    bool isProtectedByCommonCxtLock(const llvm::Instruction *i1, const llvm::Instruction *i2);
-    bool isProtectedByCommonCxtLock(const CxtStmt& cxtStmt1, const CxtStmt& cxtStmt2);
-    bool isProtectedByCommonCILock(const llvm::Instruction *i1, const llvm::Instruction *i2);
+    bool isProtectedByCommonCxtLock(const llvm::Instruction *i1, const llvm::Instruction *i2) const;
+    bool isProtectedByCommonCxtLock(const CxtStmt& cxtStmt1, const CxtStmt& cxtStmt2) const;
+    bool isProtectedByCommonCILock(const llvm::Instruction *i1, const llvm::Instruction *i2) const;
+
+    /// Read-only common lock query without statistics.
+    /// It is safe to be called by multiple threads after analyze() has finished.
+    bool isProtectedByCommonLockReadOnly(const llvm::Instruction *i1, const llvm::Instruction *i2) const;
 
     bool isInSameSpan(const llvm::Instruction *I1, const llvm::Instruction *I2);
     bool isInSameCSSpan(const llvm::Instruction *i1, const llvm::Instruction *i2) const;
     bool isInSameCSSpan(const CxtStmt& cxtStmt1, const CxtStmt& cxtStmt2) const;
     bool isInSameCISpan(const llvm::Instruction *i1, const llvm::Instruction *i2) const;
 
-    inline u32_t getNumOfCxtLocks() {
-        return cxtLockset.size();
+    inline u32_t getNumOfCxtLocks() const {
+        return cxtLocks.size();
     }
     /// Print locks and spans
     void printLocks(const CxtStmt& cts);
@@ -277,10 +311,7 @@ private:
     void handleCallRelation(CxtLockProc& clp, const PTACallGraphEdge* cgEdge, llvm::CallSite call);
 
     /// Return true it a lock matches an unlock
-    bool isAliasedLocks(const CxtLock& cl1, const CxtLock& cl2) {
-        return isAliasedLocks(cl1.getStmt(), cl2.getStmt());
-    }
-    bool isAliasedLocks(const llvm::Instruction* i1, const llvm::Instruction* i2) {
+    bool isAliasedLocks(const llvm::Instruction* i1, const llvm::Instruction* i2) const {
         /// todo: must alias
         return tct->getPTA()->alias(getLockVal(i1), getLockVal(i2));
     }
@@ -289,9 +320,9 @@ private:
     //@{
     /// Transfer function for marking context-sensitive statement
     void markCxtStmtFlag(const CxtStmt& tgr, const CxtStmt& src) {
-        const CxtLockSet& srclockset = getCxtLockfromCxtStmt(src);
+        const LockSet& srclockset = getCxtLockfromCxtStmt(src);
         if(hasCxtLockfromCxtStmt(tgr)== false) {
-            for(CxtLockSet::const_iterator it = srclockset.begin(), eit = srclockset.end(); it!=eit; ++it) {
+            for(LockSet::iterator it = srclockset.begin(), eit = srclockset.end(); it!=eit; ++it) {
                 addCxtStmtToSpan(tgr,*it);
             }
             pushToCTSWorkList(tgr);
@@ -301,18 +332,9 @@ private:
                 pushToCTSWorkList(tgr);
         }
     }
-    bool intersect(CxtLockSet& tgrlockset, const CxtLockSet& srclockset) {
-        CxtLockSet toBeDeleted;
-        for(CxtLockSet::const_iterator it = tgrlockset.begin(), eit = tgrlockset.end(); it!=eit; ++it) {
-            if(srclockset.find(*it)==srclockset.end())
-                toBeDeleted.insert(*it);
-        }
-        for(CxtLockSet::const_iterator it = toBeDeleted.begin(), eit = toBeDeleted.end(); it!=eit; ++it) {
-            tgrlockset.erase(*it);
-        }
-        if(!toBeDeleted.empty())
-            return true;
-        return false;
+    /// Intersect tgrlockset with srclockset, return true if tgrlockset is changed
+    inline bool intersect(LockSet& tgrlockset, const LockSet& srclockset) {
+        return tgrlockset &= srclockset;
     }
 
     /// Clear flags
@@ -398,7 +420,7 @@ private:
         return getTCG()->getThreadAPI()->isTDRelease(call);
     }
     /// Get lock value
-    inline const llvm::Value* getLockVal(const llvm::Instruction* call) {
+    inline const llvm::Value* getLockVal(const llvm::Instruction* call) const {
         return getTCG()->getThreadAPI()->getLockVal(call);
     }
     /// ThreadCallGraph
@@ -417,13 +439,17 @@ private:
 
 
     /// Context-sensitive locks
-    CxtLockSet cxtLockset;
+    //@{
+    CxtLockVec cxtLocks;			///< CxtLockID -> context-sensitive lock
+    CxtLockToIDMap cxtLockToID;		///< context-sensitive lock -> CxtLockID
+    LockSetVec cxtLockAliases;		///< CxtLockID -> CxtLockIDs of aliased locks
+    //@}
 
     /// Map a context-sensitive lock to its lock span statements
-    /// Map a context-sensitive statement to its context-sensitive lock
+    /// Map a context-sensitive statement to its context-sensitive locks
     //@{
     CxtLockToSpan cxtLocktoSpan;
-    CxtStmtToCxtLockSet cxtStmtToCxtLockSet;
+    CxtStmtToLockSet cxtStmtToLockSet;
     //@}
 
     /// Following data structures are used for collecting context-sensitive locks
@@ -438,6 +464,15 @@ private:
     InstSet unlocksites;
     //@}
 
+    /// Lock site numbering and alias classes
+    //@{
+    InstVec lockSites;				///< LockSiteID -> lock site
+    LockSiteToIDMap lockSiteToID;	///< lock site -> LockSiteID
+    std::vector<NodeID> lockSiteClass;	///< LockSiteID -> alias class
+    LockSetVec lockSiteAliases;		///< LockSiteID -> LockSiteIDs of aliased lock sites
+    u32_t numOfLockClasses;
+    //@}
+
     /// Candidate functions which relevant to locks/unlocks
     //@{
     FunSet lockcandidateFuncSet;
@@ -447,7 +482,7 @@ private:
     /// Used for context-insensitive intra-procedural locks
     //@{
     CILockToSpan ciLocktoSpan;
-    InstToInstSetMap instCILocksMap;
+    InstToLockSetMap instCILocksMap;
     InstToInstSetMap instTocondCILocksMap;
     //@}
 
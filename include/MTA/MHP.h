@@ -9,6 +9,7 @@
 #define MHP_H_
 
 #include "MTA/TCT.h"
+#include "MTA/MHPIndex.h"
 #include "Util/DataFlowUtil.h"
 #include <llvm/IR/Instructions.h>
 #include <set>
@@ -81,6 +82,10 @@ public:
     virtual bool mayHappenInParallelInst(const llvm::Instruction* i1, const llvm::Instruction* i2);
     virtual bool executedByTheSameThread(const llvm::Instruction* i1, const llvm::Instruction* i2);
 
+    /// Read-only MHP query without statistics and caching.
+    /// It is safe to be called by multiple threads after analyze() has finished.
+    bool mayHappenInParallelReadOnly(const llvm::Instruction* i1, const llvm::Instruction* i2) const;
+
     /// Get interleaving thread for statement inst
     //@{
     inline const NodeBS& getInterleavingThreads(const CxtThreadStmt& cts) {
@@ -89,26 +94,48 @@ public:
     inline bool hasInterleavingThreads(const CxtThreadStmt& cts) const {
         return threadStmtToTheadInterLeav.find(cts)!=threadStmtToTheadInterLeav.end();
     }
+    inline const NodeBS& getConstInterleavingThreads(const CxtThreadStmt& cts) const {
+        ThreadStmtToThreadInterleav::const_iterator it = threadStmtToTheadInterLeav.find(cts);
+        assert(it!=threadStmtToTheadInterLeav.end() && "no interleaving for this thread statement?");
+        return it->second;
+    }
     //@}
 
-    /// Get/has ThreadStmt
+    /// Get/has ThreadStmt, the statements of an instruction are those of its region leader
     //@{
     inline const CxtThreadStmtSet& getThreadStmtSet(const llvm::Instruction* inst) const {
-        InstToThreadStmtSetMap::const_iterator it = instToTSMap.find(inst);
+        InstToThreadStmtSetMap::const_iterator it = instToTSMap.find(getRegionLeader(inst));
         assert(it!=instToTSMap.end() && "no thread access the instruction?");
         return it->second;
     }
     inline bool hasThreadStmtSet(const llvm::Instruction* inst) const {
-        return instToTSMap.find(inst)!=instToTSMap.end();
+        return instToTSMap.find(getRegionLeader(inst))!=instToTSMap.end();
     }
     //@}
 
+    /// Get the instruction whose statements stand for inst.
+    /// All instructions of a non-candidate function share the statements of its entry when regions are used.
+    inline const llvm::Instruction* getRegionLeader(const llvm::Instruction* inst) const {
+        const llvm::Function* fun = inst->getParent()->getParent();
+        if (tct->useRegions() && !tct->isCandidateFun(fun))
+            return &(fun->getEntryBlock().front());
+        return tct->getRegionLeader(inst);
+    }
+
     /// Print interleaving results
     void printInterleaving();
 
+    /// Get the index answering read-only queries
+    inline const MHPIndex& getIndex() const {
+        return index;
+    }
+
 private:
+    /// Build the index from the thread statements once interleaving is analyzed
+    void buildIndex();
+
     /// Update non-candidate functions' interleaving.
-    /// Copy interleaving threads of the entry inst to other insts.
+    /// Copy interleaving threads of the entry inst to other insts, not needed when regions are used.
     void updateNonCandidateFunInterleaving();
 
     /// Handle non-candidate function
@@ -172,7 +199,7 @@ private:
     bool isMustJoin(const NodeID curTid, const llvm::Instruction* joinsite);
 
     /// A thread is a multiForked thread if it is in a loop or recursion
-    inline bool isMultiForkedThread(NodeID curTid) {
+    inline bool isMultiForkedThread(NodeID curTid) const {
         return tct->getTCTNode(curTid)->isMultiforked();
     }
 
@@ -223,6 +250,7 @@ private:
     CxtThreadStmtWorkList cxtStmtList;	///< CxtThreadStmt worklist
     ThreadStmtToThreadInterleav threadStmtToTheadInterLeav; /// Map a statement to its thread interleavings
     InstToThreadStmtSetMap instToTSMap; ///< Map an instruction to its ThreadStmtSet
+    MHPIndex index;						///< Flat copy of instToTSMap and interleavings for queries
     FuncPairToBool nonCandidateFuncMHPRelMap;
 
 
@@ -239,6 +267,7 @@ public:
  *
  */
 class ForkJoinAnalysis {
+    friend class MHPSummary;
 
 public:
     /// semilattice  Empty==>TDDead==>TDAlive
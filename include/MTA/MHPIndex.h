@@ -0,0 +1,124 @@
+/*
+ * MHPIndex.h
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#ifndef MHPINDEX_H_
+#define MHPINDEX_H_
+
+#include "Util/BasicTypes.h"
+#include <llvm/ADT/DenseMap.h>
+#include <llvm/IR/Instruction.h>
+#include <map>
+#include <vector>
+
+/*!
+ * Flat index of the MHP results for answering queries without allocation.
+ *
+ * Every instruction is mapped to its thread statements (owning thread and interleaving threads).
+ * Thread sets are kept as fixed-width bit rows of the thread count, identical rows are stored once.
+ * An instruction also has the rows of its owning threads and of the union of its interleaving threads,
+ * which rule out most pairs before its statements are compared.
+ *
+ * The index is immutable once built, so it can be queried by multiple threads.
+ */
+class MHPIndex {
+
+public:
+    /// Constructor
+    MHPIndex() : numOfThreads(0), numOfWords(0), multiForkedRow(0) {}
+
+    /// Start building the index for threads [0, threads), multiForked are the threads forked in loops or recursion
+    void init(u32_t threads, const NodeBS& multiForked);
+
+    /// Add the thread statements of an instruction, given as pairs of owning thread and interleaving threads
+    void addInst(const llvm::Instruction* inst, const std::vector<std::pair<NodeID, const NodeBS*> >& stmts);
+
+    /// Drop the row table used for sharing rows while building
+    void finish();
+
+    /// Whether an instruction is executed by any thread
+    inline bool hasInst(const llvm::Instruction* inst) const {
+        return instToEntry.find(inst) != instToEntry.end();
+    }
+
+    /// Whether two instructions may happen in parallel, same as MHP::mayHappenInParallelReadOnly
+    bool mayHappenInParallel(const llvm::Instruction* i1, const llvm::Instruction* i2) const;
+
+    /// Whether two instructions are only executed by one thread which is not multi-forked
+    bool executedByTheSameThread(const llvm::Instruction* i1, const llvm::Instruction* i2) const;
+
+    /// Number of distinct rows and of indexed statements
+    //@{
+    inline u32_t getNumOfRows() const {
+        return numOfWords ? rows.size() / numOfWords : 0;
+    }
+    inline u32_t getNumOfStmts() const {
+        return stmtTids.size();
+    }
+    //@}
+
+private:
+    static const u32_t NoThread = ~0U;
+
+    /// Thread statements of an instruction
+    struct InstEntry {
+        u32_t firstStmt;
+        u32_t numOfStmts;
+        u32_t ownerRow;		///< owning threads of the statements
+        u32_t unionRow;		///< union of the interleaving threads of the statements
+        u32_t singleOwner;	///< the owning thread if there is only one, NoThread otherwise
+    };
+
+    /// Add a row, reusing an identical one
+    u32_t addRow(const std::vector<u64_t>& row);
+
+    /// Row operations
+    //@{
+    inline const u64_t* getRow(u32_t row) const {
+        return &rows[row * numOfWords];
+    }
+    inline bool test(u32_t row, NodeID tid) const {
+        return (getRow(row)[tid / 64] >> (tid % 64)) & 1;
+    }
+    inline bool intersects(u32_t row1, u32_t row2) const {
+        const u64_t* r1 = getRow(row1);
+        const u64_t* r2 = getRow(row2);
+        for (u32_t i = 0; i < numOfWords; ++i) {
+            if (r1[i] & r2[i])
+                return true;
+        }
+        return false;
+    }
+    inline bool intersects(u32_t row1, u32_t row2, u32_t row3) const {
+        const u64_t* r1 = getRow(row1);
+        const u64_t* r2 = getRow(row2);
+        const u64_t* r3 = getRow(row3);
+        for (u32_t i = 0; i < numOfWords; ++i) {
+            if (r1[i] & r2[i] & r3[i])
+                return true;
+        }
+        return false;
+    }
+    //@}
+
+    inline const InstEntry* getEntry(const llvm::Instruction* inst) const {
+        llvm::DenseMap<const llvm::Instruction*, u32_t>::const_iterator it = instToEntry.find(inst);
+        if (it == instToEntry.end())
+            return NULL;
+        return &entries[it->second];
+    }
+
+    u32_t numOfThreads;
+    u32_t numOfWords;		///< words per row
+    u32_t multiForkedRow;
+    std::vector<u64_t> rows;
+    std::map<std::vector<u64_t>, u32_t> rowIds;	///< only used while building
+    std::vector<NodeID> stmtTids;	///< owning thread of each statement
+    std::vector<u32_t> stmtRows;	///< interleaving threads of each statement
+    std::vector<InstEntry> entries;
+    llvm::DenseMap<const llvm::Instruction*, u32_t> instToEntry;
+};
+
+#endif /* MHPINDEX_H_ */
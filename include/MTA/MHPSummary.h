@@ -0,0 +1,103 @@
+/*
+ * MHPSummary.h
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#ifndef MHPSUMMARY_H_
+#define MHPSUMMARY_H_
+
+#include "MTA/MHP.h"
+#include <istream>
+#include <string>
+
+/*!
+ * Persisted MHP results for incremental analysis.
+ *
+ * A summary stores the interleaving threads of every context-sensitive thread
+ * statement, keyed by stable names: a function by its name, an instruction by its
+ * index in its function, and a call site of a context by its caller, its index
+ * and its callee. Each TCT node is stored with a signature which hashes the
+ * structure of all functions reachable in the thread (ignoring debug metadata)
+ * and their call edges.
+ *
+ * A summary is reused only if the TCT and the fork/join results are unchanged.
+ * A thread is clean if its signature is unchanged, its ancestors are clean and all
+ * contexts of its statements can be resolved in the new program. The results of
+ * clean threads are restored before MHP::analyzeInterleaving, so that propagation
+ * stops at their statements immediately and only dirty threads are re-analysed.
+ */
+class MHPSummary {
+
+public:
+    typedef MHP::ThreadStmtToThreadInterleav ThreadStmtToThreadInterleav;
+    typedef MHP::InstToThreadStmtSetMap InstToThreadStmtSetMap;
+
+    /// Constructor, compute the signatures of the current program
+    MHPSummary(TCT* t, const ForkJoinAnalysis* f);
+
+    /// Load a summary, return false if it cannot be reused at all
+    bool load(const std::string& filename);
+
+    /// Restore the interleavings of clean threads, return the number of restored statements
+    u32_t restore(ThreadStmtToThreadInterleav& interleav, InstToThreadStmtSetMap& instToTS) const;
+
+    /// Write the results of the current program
+    void save(const std::string& filename, const ThreadStmtToThreadInterleav& interleav,
+              const InstToThreadStmtSetMap& instToTS);
+
+    /// Threads whose results are restored
+    inline const NodeBS& getCleanThreads() const {
+        return cleanThreads;
+    }
+
+private:
+    typedef std::vector<const llvm::Instruction*> InstVec;
+    typedef std::map<const llvm::Function*, InstVec> FunToInstsMap;
+    typedef llvm::DenseMap<const llvm::Instruction*, u32_t> InstToIndexMap;
+    typedef std::map<const llvm::Function*, u64_t> FunToHashMap;
+
+    /// A record of the file whose contexts are resolved
+    struct Record {
+        NodeID tid;
+        const llvm::Instruction* inst;
+        CallStrCxt cxt;
+        NodeBS interleav;
+    };
+    typedef std::vector<Record> RecordVec;
+
+    /// Stable keys
+    //@{
+    void numberInsts();
+    u32_t getInstIndex(const llvm::Instruction* inst) const;
+    const llvm::Instruction* getInst(const std::string& fun, u32_t idx) const;
+    std::string getInstKey(const llvm::Instruction* inst) const;
+    std::string getCallSiteKey(CallSiteID cs) const;
+    std::string getCxtKey(const CallStrCxt& cxt) const;
+    //@}
+
+    /// Read the records of a summary file, return false if it is malformed
+    bool readRecords(std::istream& F);
+
+    /// Signatures
+    //@{
+    u64_t getFunctionHash(const llvm::Function* fun);
+    u64_t computeThreadSignature(NodeID tid);
+    u64_t computeTCTHash() const;
+    u64_t computeFJAHash() const;
+    //@}
+
+    TCT* tct;
+    const ForkJoinAnalysis* fja;
+    ThreadCallGraph* tcg;
+    FunToInstsMap funToInsts;		///< function -> instructions in order
+    InstToIndexMap instToIndex;		///< instruction -> index in its function
+    FunToHashMap funToHash;			///< function -> structural hash
+    std::vector<u64_t> threadSigs;	///< tid -> signature
+    u64_t tctHash;
+    u64_t fjaHash;
+    NodeBS cleanThreads;			///< threads whose loaded records are valid
+    RecordVec records;				///< loaded records of clean threads
+};
+
+#endif /* MHPSUMMARY_H_ */
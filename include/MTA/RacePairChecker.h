@@ -0,0 +1,109 @@
+/*
+ * RacePairChecker.h
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#ifndef RACEPAIRCHECKER_H_
+#define RACEPAIRCHECKER_H_
+
+#include "MTA/AccessPartition.h"
+#include <mutex>
+#include <atomic>
+#include <vector>
+
+class MHP;
+class LockAnalysis;
+class RaceReport;
+
+/*!
+ * Multi-threaded race pair checking engine.
+ *
+ * The candidate pairs handed out by AccessPartitioning are independent, so they
+ * are sharded across a pool of workers by AccessID. Every worker owns a range of
+ * AccessIDs and takes small chunks from its front; an idle worker steals the back
+ * half of the largest remaining range of another worker.
+ *
+ * Workers only use the read-only queries of MHP and LockAnalysis. Query counters
+ * are kept per worker and added to the analyses' statistics after all workers finish.
+ */
+class RacePairChecker {
+
+public:
+    typedef AccessPartitioning::AccessID AccessID;
+    typedef std::pair<AccessID, AccessID> AccessPair;
+    typedef std::vector<AccessPair> AccessPairVec;
+
+    /// Number of accesses taken by a worker at a time
+    static const u32_t ChunkSize = 32;
+
+    /// Constructor
+    RacePairChecker(const AccessPartitioning* p, MHP* m, LockAnalysis* l, u32_t threads);
+
+    /// Destructor
+    ~RacePairChecker();
+
+    /// Stream racy pairs to a report as soon as they are confirmed instead of collecting them
+    inline void setReport(RaceReport* r) {
+        report = r;
+    }
+
+    /// Check all candidate pairs. Racy pairs are returned ordered by their AccessIDs,
+    /// so the result does not depend on the number of workers.
+    /// If a report is set, racy pairs are written to it and not returned.
+    void check(AccessPairVec& racyPairs);
+
+    /// Statistics
+    //@{
+    u32_t numOfCandidatePairs;	///< Number of checked candidate pairs
+    u32_t numOfStolenChunks;	///< Number of successful steals
+    //@}
+
+private:
+    /// AccessIDs [begin,end) owned by a worker
+    struct WorkRange {
+        std::mutex mtx;
+        AccessID begin;
+        AccessID end;
+    };
+
+    /// Per-worker results and query counters
+    struct WorkerResult {
+        WorkerResult() : numOfCandidatePairs(0), numOfMHPQueries(0), numOfMHPPairs(0),
+            numOfLockQueries(0), numOfLockedPairs(0), numOfStolenChunks(0) {
+        }
+        AccessPairVec racyPairs;
+        u32_t numOfCandidatePairs;
+        u32_t numOfMHPQueries;
+        u32_t numOfMHPPairs;
+        u32_t numOfLockQueries;
+        u32_t numOfLockedPairs;
+        u32_t numOfStolenChunks;
+    };
+
+    /// Main loop of a worker
+    void runWorker(u32_t wid);
+
+    /// Take the next chunk of worker wid's own range
+    bool popChunk(u32_t wid, AccessID& begin, AccessID& end);
+
+    /// Move half of the largest remaining range of another worker to worker wid
+    bool steal(u32_t wid);
+
+    /// Check all candidate pairs of one access
+    void checkAccess(AccessID id, NodeBS& partners, WorkerResult& res) const;
+
+    /// Report progress (done by worker 0 only)
+    void reportProgress(u32_t done) const;
+
+    const AccessPartitioning* partition;
+    MHP* mhp;
+    LockAnalysis* lsa;
+    RaceReport* report;
+    u32_t numOfThreads;
+    WorkRange* ranges;
+    std::vector<WorkerResult> results;
+    std::atomic<u32_t> numOfDoneAccesses;
+};
+
+#endif /* RACEPAIRCHECKER_H_ */
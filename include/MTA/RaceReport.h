@@ -0,0 +1,173 @@
+/*
+ * RaceReport.h
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#ifndef RACEREPORT_H_
+#define RACEREPORT_H_
+
+#include "MTA/AccessPartition.h"
+#include <llvm/ADT/DenseMap.h>
+#include <llvm/Support/raw_ostream.h>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <map>
+
+/*!
+ * Sink of detected data races.
+ *
+ * The source location (file and line) of every access is looked up once when
+ * the report is created. A race is reported once per pair of source lines;
+ * racy pairs without debug information are dropped. A race is written and
+ * flushed as soon as it is confirmed, so the report can be consumed while the
+ * checker runs; its order and the accesses shown for a pair of lines follow
+ * the arrival order of the workers.
+ *
+ * If a sorted report is requested, the races are also merged per pair of lines
+ * and written sorted by location to a separate file when the report is
+ * finished. The merge does not depend on arrival order: a write-write pair is
+ * preferred to a read-write one, then the pair of smallest access IDs, so the
+ * sorted report is the same whatever the number of threads.
+ *
+ * Every race carries a stable ID computed from its two source locations.
+ *
+ * Supported formats:
+ *   Text   line and file of both accesses on four lines (the legacy output.txt layout)
+ *   JSONL  one JSON object per race
+ *   SARIF  a SARIF 2.1.0 log with one result per race
+ */
+class RaceReport {
+
+public:
+    typedef AccessPartitioning::AccessID AccessID;
+    /// Handle of a (file, line) pair, 0 means no debug location
+    typedef u32_t LocID;
+
+    enum Format {
+        Text,
+        JSONL,
+        SARIF
+    };
+
+    /// Source location of an access
+    struct SourceLoc {
+        SourceLoc(const std::string& f, u32_t l) : file(f), line(l) {
+        }
+        std::string file;
+        u32_t line;
+    };
+
+    /// Constructor, open the report and build the location table of all accesses.
+    /// Races are also written sorted to sortedPath if it is not empty.
+    RaceReport(const AccessPartitioning* p, const std::string& path, Format f, const std::string& sortedPath = "");
+
+    /// Destructor
+    ~RaceReport();
+
+    /// Whether the report file is opened successfully
+    inline bool isOpen() const {
+        return os != NULL;
+    }
+
+    /// Report a racy pair, it may be called by multiple threads.
+    /// Return true if it has debug locations and its lines are not reported yet,
+    /// in which case it is written to the report before returning.
+    bool addRace(AccessID id1, AccessID id2);
+
+    /// Write the trailer and close the report, then write the sorted report if requested
+    void finish();
+
+    /// Source locations
+    //@{
+    inline LocID getLocID(AccessID id) const {
+        return accessLocs[id];
+    }
+    inline const SourceLoc& getLoc(LocID id) const {
+        assert(id != 0 && id < locs.size() && "no such source location");
+        return locs[id];
+    }
+    //@}
+
+    /// Statistics
+    //@{
+    inline u32_t getNumOfRaces() const {
+        return numOfRaces;
+    }
+    inline u32_t getNumOfDuplicates() const {
+        return numOfDuplicates;
+    }
+    //@}
+
+private:
+    typedef std::map<std::pair<std::string, u32_t>, LocID> LocToIDMap;
+    /// The race kept for a pair of source lines, loc1 is ordered before loc2
+    struct RaceRecord {
+        RaceRecord(LocID l1, AccessID a1, bool w1, LocID l2, AccessID a2, bool w2) :
+            loc1(l1), loc2(l2), id1(a1), id2(a2), write1(w1), write2(w2) {
+        }
+        /// Whether this race is preferred to another one between the same lines
+        bool isPreferredTo(const RaceRecord& rhs) const;
+
+        LocID loc1;
+        LocID loc2;
+        AccessID id1;
+        AccessID id2;
+        bool write1;
+        bool write2;
+    };
+    typedef llvm::DenseMap<std::pair<LocID, LocID>, u32_t> LocPairToRaceMap;
+
+    /// Look up the source locations of all accesses
+    void buildLocTable();
+
+    /// Intern the source location of an instruction
+    LocID getLocOfInst(const llvm::Instruction* inst);
+
+    /// Write the header/trailer of a report
+    //@{
+    void writeHeader(llvm::raw_ostream& out);
+    void writeTrailer(llvm::raw_ostream& out);
+    //@}
+
+    /// Write the merged races sorted by location to a file
+    void writeSorted(const std::string& path);
+
+    /// Whether a source location is ordered before another one
+    inline bool lessLoc(LocID lhs, LocID rhs) const {
+        const SourceLoc& l = locs[lhs];
+        const SourceLoc& r = locs[rhs];
+        return l.file < r.file || (l.file == r.file && l.line < r.line);
+    }
+
+    /// Write one race whose locations are ordered, index is its position in the report
+    void writeRace(llvm::raw_ostream& out, u32_t index, const RaceRecord& race);
+
+    /// Write a JSON string literal
+    static void writeJSONString(llvm::raw_ostream& out, llvm::StringRef str);
+
+    /// Write a SARIF physical location
+    static void writeSARIFLocation(llvm::raw_ostream& out, const SourceLoc& loc);
+
+    /// Kind of a race, from whether each access writes
+    static const char* getKind(bool write1, bool write2);
+
+    /// Stable ID of a race between two source locations
+    static u64_t getStableID(const SourceLoc& loc1, const SourceLoc& loc2);
+
+    const AccessPartitioning* partition;
+    Format format;
+    llvm::raw_fd_ostream* os;
+    std::vector<SourceLoc> locs;	///< LocID -> source location
+    LocToIDMap locToID;				///< source location -> LocID
+    std::vector<LocID> accessLocs;	///< AccessID -> LocID
+    std::string sortedPath;			///< file of the sorted report, empty if not requested
+    std::vector<RaceRecord> races;	///< merged race of each pair of lines, kept for the sorted report only
+    LocPairToRaceMap raceOfLocs;	///< (loc1, loc2) -> index in races
+    std::mutex mtx;					///< guards the report stream, races, raceOfLocs and the statistics
+    u32_t numOfRaces;
+    u32_t numOfDuplicates;
+};
+
+#endif /* RACEREPORT_H_ */
@@ -12,6 +12,7 @@
 #include "Util/AnalysisUtil.h"
 #include "Util/ThreadCallGraph.h"
 #include "Util/CxtStmt.h"
+#include <llvm/ADT/DenseMap.h>
 #include <llvm/Analysis/LoopInfo.h>
 #include <llvm/IR/InstIterator.h>
 #include <set>
@@ -110,6 +111,7 @@ public:
     typedef std::map<const CxtThread,CallStrCxt> CxtThreadToForkCxt;
     typedef std::map<const CxtThread,const llvm::Function*> CxtThreadToFun;
     typedef std::map<const llvm::Instruction*, const llvm::Loop*> InstToLoopMap;
+    typedef llvm::DenseMap<const llvm::Instruction*, const llvm::Instruction*> InstToInstMap;
     typedef FIFOWorkList<CxtThreadProc> CxtThreadProcVec;
     typedef set<CxtThreadProc> CxtThreadProcSet;
     typedef SCCDetection<PTACallGraph*> ThreadCallGraphSCC;
@@ -290,6 +292,20 @@ public:
 
     /// Get the next instructions following control flow
     void getNextInsts(const llvm::Instruction* inst, InstVec& instSet);
+
+    /// Sync-free regions.
+    /// A region is a maximal run of instructions in a basic block without thread or lock operations,
+    /// returns and calls of non-external functions, each of which is a region of its own.
+    /// Interleavings and locksets do not change inside a region, so with -mta-region MHP and
+    /// LockAnalysis only propagate facts to the first instruction (leader) of each region.
+    //@{
+    bool useRegions() const;
+    bool isRegionBoundary(const llvm::Instruction* inst) const;
+    /// The leader of the region of an instruction, the instruction itself without -mta-region
+    const llvm::Instruction* getRegionLeader(const llvm::Instruction* inst) const;
+    /// The last instruction of the region led by leader, the leader itself without -mta-region
+    const llvm::Instruction* getRegionEnd(const llvm::Instruction* leader) const;
+    //@}
     /// Push calling context
     void pushCxt(CallStrCxt& cxt, const llvm::Instruction* call, const llvm::Function* callee);
     /// Match context
@@ -349,6 +365,9 @@ private:
     /// Get entry functions that are neither called by other functions nor extern functions
     void collectEntryFunInCallGraph();
 
+    /// Map the instructions of every region to its leader and its leader to its last instruction
+    void buildRegions();
+
     /// Collect multi-forked threads whose 1, cxt is in loop or recursion;
     /// 2, parent thread is a multi-forked thread.
     void collectMultiForkedThreads();
@@ -454,6 +473,8 @@ private:
     PTACFInfoBuilder loopInfoBuilder; ///< LoopInfo
     InstToLoopMap joinSiteToLoopMap; ///< map an inloop join to its loop class
     InstSet inRecurJoinSites;	///< Fork or Join sites in recursions
+    InstToInstMap instToRegionLeader;	///< map an instruction to the leader of its region, leaders are not recorded
+    InstToInstMap regionLeaderToEnd;	///< map a leader to the last instruction of its region, single-instruction regions are not recorded
 };
 
 
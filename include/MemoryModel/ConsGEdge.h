@@ -78,6 +78,8 @@ public:
     }
     /// Constraint edge type
     typedef GenericNode<ConstraintNode,ConstraintEdge>::GEdgeSetTy ConstraintEdgeSetTy;
+    /// Sorted vector of constraint edges used for the per-kind edges of a node
+    typedef GEdgeVectorSet<ConstraintEdge> ConstraintEdgeVectorSetTy;
 
 };
 
@@ -39,22 +39,25 @@ class ConstraintNode : public GenericConsNodeTy {
 public:
     typedef ConstraintEdge::ConstraintEdgeSetTy::iterator iterator;
     typedef ConstraintEdge::ConstraintEdgeSetTy::const_iterator const_iterator;
+    /// Iterators of the address/load/store edges, which are kept in sorted vectors
+    typedef ConstraintEdge::ConstraintEdgeVectorSetTy::const_iterator const_edge_iterator;
 private:
     bool _isPWCNode;
 
-    ConstraintEdge::ConstraintEdgeSetTy loadInEdges; ///< all incoming load edge of this node
-    ConstraintEdge::ConstraintEdgeSetTy loadOutEdges; ///< all outgoing load edge of this node
+    ConstraintEdge::ConstraintEdgeVectorSetTy loadInEdges; ///< all incoming load edge of this node
+    ConstraintEdge::ConstraintEdgeVectorSetTy loadOutEdges; ///< all outgoing load edge of this node
 
-    ConstraintEdge::ConstraintEdgeSetTy storeInEdges; ///< all incoming store edge of this node
-    ConstraintEdge::ConstraintEdgeSetTy storeOutEdges; ///< all outgoing store edge of this node
+    ConstraintEdge::ConstraintEdgeVectorSetTy storeInEdges; ///< all incoming store edge of this node
+    ConstraintEdge::ConstraintEdgeVectorSetTy storeOutEdges; ///< all outgoing store edge of this node
 
     /// Copy/call/ret/gep incoming edge of this node,
     /// To be noted: this set is only used when SCC detection, and node merges
+    /// They stay in tree sets since SCC detection iterates them through the GenericNode iterators
     ConstraintEdge::ConstraintEdgeSetTy directInEdges;
     ConstraintEdge::ConstraintEdgeSetTy directOutEdges;
 
-    ConstraintEdge::ConstraintEdgeSetTy addressInEdges; ///< all incoming address edge of this node
-    ConstraintEdge::ConstraintEdgeSetTy addressOutEdges; ///< all outgoing address edge of this node
+    ConstraintEdge::ConstraintEdgeVectorSetTy addressInEdges; ///< all incoming address edge of this node
+    ConstraintEdge::ConstraintEdgeVectorSetTy addressOutEdges; ///< all outgoing address edge of this node
 
 public:
 
@@ -108,49 +111,49 @@ public:
         return directInEdges.end();
     }
 
-    ConstraintEdge::ConstraintEdgeSetTy& incomingAddrEdges() {
+    ConstraintEdge::ConstraintEdgeVectorSetTy& incomingAddrEdges() {
         return addressInEdges;
     }
-    ConstraintEdge::ConstraintEdgeSetTy& outgoingAddrEdges() {
+    ConstraintEdge::ConstraintEdgeVectorSetTy& outgoingAddrEdges() {
         return addressOutEdges;
     }
 
-    inline const_iterator outgoingAddrsBegin() const {
+    inline const_edge_iterator outgoingAddrsBegin() const {
         return addressOutEdges.begin();
     }
-    inline const_iterator outgoingAddrsEnd() const {
+    inline const_edge_iterator outgoingAddrsEnd() const {
         return addressOutEdges.end();
     }
-    inline const_iterator incomingAddrsBegin() const {
+    inline const_edge_iterator incomingAddrsBegin() const {
         return addressInEdges.begin();
     }
-    inline const_iterator incomingAddrsEnd() const {
+    inline const_edge_iterator incomingAddrsEnd() const {
         return addressInEdges.end();
     }
 
-    inline const_iterator outgoingLoadsBegin() const {
+    inline const_edge_iterator outgoingLoadsBegin() const {
         return loadOutEdges.begin();
     }
-    inline const_iterator outgoingLoadsEnd() const {
+    inline const_edge_iterator outgoingLoadsEnd() const {
         return loadOutEdges.end();
     }
-    inline const_iterator incomingLoadsBegin() const {
+    inline const_edge_iterator incomingLoadsBegin() const {
         return loadInEdges.begin();
     }
-    inline const_iterator incomingLoadsEnd() const {
+    inline const_edge_iterator incomingLoadsEnd() const {
         return loadInEdges.end();
     }
 
-    inline const_iterator outgoingStoresBegin() const {
+    inline const_edge_iterator outgoingStoresBegin() const {
         return storeOutEdges.begin();
     }
-    inline const_iterator outgoingStoresEnd() const {
+    inline const_edge_iterator outgoingStoresEnd() const {
         return storeOutEdges.end();
     }
-    inline const_iterator incomingStoresBegin() const {
+    inline const_edge_iterator incomingStoresBegin() const {
         return storeInEdges.begin();
     }
-    inline const_iterator incomingStoresEnd() const {
+    inline const_edge_iterator incomingStoresEnd() const {
         return storeInEdges.end();
     }
     //@}
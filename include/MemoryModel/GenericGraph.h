@@ -33,6 +33,8 @@
 #include "Util/BasicTypes.h"
 #include <llvm/ADT/GraphTraits.h>
 #include <llvm/ADT/STLExtras.h>			// for mapped_iter
+#include <algorithm>
+#include <vector>
 
 
 /*!
@@ -110,6 +112,81 @@ protected:
 };
 
 
+/*!
+ * Edge set kept in a vector sorted by equalGEdge.
+ * It provides the set interface used by graph nodes (insert/erase/find/iteration in the same order),
+ * but stores edges contiguously, which is smaller and faster to scan than a tree
+ * for the few edges a node usually has of each kind.
+ * Iterators are read-only and are invalidated by insert/erase.
+ */
+template<class EdgeTy>
+class GEdgeVectorSet {
+
+public:
+    typedef EdgeTy* value_type;
+    typedef typename EdgeTy::equalGEdge Compare;
+    typedef std::vector<EdgeTy*> EdgeVectorTy;
+    typedef typename EdgeVectorTy::const_iterator iterator;
+    typedef typename EdgeVectorTy::const_iterator const_iterator;
+
+private:
+    EdgeVectorTy edges;
+
+    /// First position whose edge is not ordered before edge
+    inline typename EdgeVectorTy::iterator lowerBound(EdgeTy* edge) {
+        return std::lower_bound(edges.begin(), edges.end(), edge, Compare());
+    }
+
+public:
+    /// Iterators
+    //@{
+    inline const_iterator begin() const {
+        return edges.begin();
+    }
+    inline const_iterator end() const {
+        return edges.end();
+    }
+    //@}
+
+    inline Size_t size() const {
+        return edges.size();
+    }
+    inline bool empty() const {
+        return edges.empty();
+    }
+
+    /// Find an edge with the same kind, src and dst
+    inline const_iterator find(EdgeTy* edge) const {
+        const_iterator it = std::lower_bound(edges.begin(), edges.end(), edge, Compare());
+        if (it != edges.end() && !Compare()(edge, *it))
+            return it;
+        return edges.end();
+    }
+
+    /// Insert an edge, return false as second if an equal edge is already in the set
+    inline std::pair<const_iterator, bool> insert(EdgeTy* edge) {
+        typename EdgeVectorTy::iterator it = lowerBound(edge);
+        if (it != edges.end() && !Compare()(edge, *it))
+            return std::make_pair(const_iterator(it), false);
+        it = edges.insert(it, edge);
+        return std::make_pair(const_iterator(it), true);
+    }
+
+    /// Erase an edge, return the number of edges removed
+    inline Size_t erase(EdgeTy* edge) {
+        typename EdgeVectorTy::iterator it = lowerBound(edge);
+        if (it == edges.end() || Compare()(edge, *it))
+            return 0;
+        edges.erase(it);
+        return 1;
+    }
+
+    inline void clear() {
+        edges.clear();
+    }
+};
+
+
 /*!
  * Generic node on the graph as base class
  */
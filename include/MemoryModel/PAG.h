@@ -505,6 +505,10 @@ public:
     //@{
     NodeBS& getAllFieldsObjNode(const MemObj* obj);
     NodeBS& getAllFieldsObjNode(NodeID id);
+    /// Whether a base object has field objects (read-only, never creates an entry)
+    inline bool hasAllFieldsObjNode(NodeID base) const {
+        return memToFieldsMap.find(base) != memToFieldsMap.end();
+    }
     NodeBS getFieldsAfterCollapse(NodeID id);
     //@}
 
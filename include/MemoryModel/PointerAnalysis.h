@@ -37,6 +37,7 @@
 #include "Util/SCC.h"
 #include "Util/PathCondAllocator.h"
 #include "MemoryModel/PointsToDFDS.h"
+#include "MemoryModel/PointsToFile.h"
 
 #include <llvm/Analysis/AliasAnalysis.h>
 #include <llvm/Analysis/CallGraph.h>	// call graph
@@ -416,22 +417,39 @@ public:
     inline void destroy() {
         delete ptD;
         ptD = NULL;
+        delete ptsFile;
+        ptsFile = NULL;
     }
 
     /// Get points-to and reverse points-to
+    /// Results loaded from a binary points-to file are decoded on first access.
     ///@{
     virtual inline PointsTo& getPts(NodeID id) {
+        if (ptsFile) {
+            if (PointsTo* pts = ptsFile->findPts(id))
+                return *pts;
+        }
         return ptD->getPts(id);
     }
     virtual inline PointsTo& getRevPts(NodeID nodeId) {
         return ptD->getRevPts(nodeId);
     }
+    /// Read-only points-to query which never creates a new entry (safe for concurrent queries)
+    virtual inline const PointsTo& getConstPts(NodeID id) const {
+        if (ptsFile) {
+            if (const PointsTo* pts = ptsFile->findPts(id))
+                return *pts;
+        }
+        return ptD->getConstPts(id);
+    }
     //@}
 
     /// Expand FI objects
     void expandFIObjs(const PointsTo& pts, PointsTo& expandedPts);
 
     /// Interface for analysis result storage on filesystem.
+    /// Results are stored in the binary format of PointsToFile unless -pts-text-file is set,
+    /// both formats can be read.
     //@{
     virtual void writeToFile(const std::string& filename);
     virtual bool readFromFile(const std::string& filename);
@@ -439,6 +457,13 @@ public:
 
 protected:
 
+    /// Store/load points-to results in the text or binary format
+    //@{
+    void writeTextPts(llvm::raw_fd_ostream& os);
+    void writeBinaryPts(llvm::raw_fd_ostream& os);
+    bool readBinaryPts(const std::string& filename);
+    //@}
+
     /// Update callgraph. This should be implemented by its subclass.
     virtual inline bool updateCallGraph(const CallSiteToFunPtrMap& callsites) {
         assert(false && "Virtual function not implemented!");
@@ -481,6 +506,8 @@ protected:
 private:
     /// Points-to data
     PTDataTy* ptD;
+    /// Points-to results mapped from a binary file (NULL if not loaded from one)
+    PointsToFile* ptsFile;
 
 public:
     /// Interface expose to users of our pointer analysis, given Location infos
@@ -491,7 +518,9 @@ public:
     virtual llvm::AliasResult alias(const llvm::Value* V1,
                                     const llvm::Value* V2);
 
-    /// Interface expose to users of our pointer analysis, given PAGNodeID
+    /// Interface expose to users of our pointer analysis, given PAGNodeID.
+    /// Alias queries only read the points-to data, so they can be issued
+    /// by multiple threads once the analysis has finished.
     virtual llvm::AliasResult alias(NodeID node1, NodeID node2);
 
     /// Interface expose to users of our pointer analysis, given two pts
@@ -34,6 +34,9 @@
 
 #include "MemoryModel/ConditionalPT.h"
 #include "Util/AnalysisUtil.h"
+#include <llvm/ADT/DenseMap.h>
+#include <llvm/ADT/Hashing.h>
+#include <deque>
 
 /// Overloading operator << for dumping conditional variable
 //@{
@@ -44,6 +47,253 @@ llvm::raw_ostream& operator<< (llvm::raw_ostream &o, const CondVar<Cond> &cvar)
 }
 //@}
 
+/*!
+ * Hash-consed (interned) points-to sets.
+ * Equal sets are stored once and identified by an integer PtsID (0 is the empty set),
+ * so set equality is an ID comparison, and union/intersection/difference results are memoized.
+ * Holders retain/release the sets they keep. A set is freed when its last holder releases
+ * it; results of intern and of the set operations which are not retained are valid until the
+ * next assign, which sweeps them once the number of live sets has doubled. Freed IDs are reused
+ * by new sets, so the table only grows with the number of retained sets. Every ID has a generation which is bumped when it is freed; a memoized result
+ * records the generations of its operands and result and is dropped once any of them changed.
+ *
+ * Only the propagated sets of DiffPTData are kept here. The points-to, diff and cached maps
+ * are updated in place by the solvers through the references PTData returns, which a shared
+ * set does not allow.
+ */
+template<class Data>
+class PointsToTable {
+public:
+    typedef u32_t PtsID;
+    typedef std::pair<PtsID, PtsID> PtsIDPair;
+    /// A memoized result and the generations of the IDs it was computed from
+    struct CachedResult {
+        PtsID res;
+        u32_t lhsGen;
+        u32_t rhsGen;
+        u32_t resGen;
+    };
+    typedef llvm::DenseMap<PtsIDPair, CachedResult> OpCache;
+    typedef std::multimap<size_t, PtsID> HashToPtsIDMap;
+
+    /// Constructor
+    PointsToTable(): numOfLiveSets(0), numOfLiveSetsAfterSweep(0), numOfOpCacheHits(0) {
+        entries.push_back(Entry());
+        entries.back().live = true;
+    }
+
+    /// Intern a set and return its ID, the set is not retained
+    PtsID intern(const Data& data) {
+        if(data.empty())
+            return 0;
+        size_t hash = hashData(data);
+        std::pair<typename HashToPtsIDMap::iterator, typename HashToPtsIDMap::iterator> range = hashToPtsID.equal_range(hash);
+        for(typename HashToPtsIDMap::iterator it = range.first; it!=range.second; ++it) {
+            if(entries[it->second].data == data)
+                return it->second;
+        }
+        PtsID id;
+        if(freeIDs.empty()) {
+            id = entries.size();
+            entries.push_back(Entry());
+        }
+        else {
+            id = freeIDs.back();
+            freeIDs.pop_back();
+        }
+        Entry& entry = entries[id];
+        entry.data = data;
+        entry.hash = hash;
+        entry.live = true;
+        hashToPtsID.insert(std::make_pair(hash,id));
+        numOfLiveSets++;
+        return id;
+    }
+
+    /// Get the set of an ID
+    inline const Data& getPts(PtsID id) const {
+        assert(entries[id].live && "set has been released?");
+        return entries[id].data;
+    }
+
+    /// Reference counting
+    //@{
+    inline void retain(PtsID id) {
+        if(id)
+            entries[id].refCount++;
+    }
+    inline void release(PtsID id) {
+        if(id==0)
+            return;
+        Entry& entry = entries[id];
+        assert(entry.refCount > 0 && "release a set which is not retained?");
+        if(--entry.refCount == 0)
+            freeEntry(id);
+    }
+    /// Let holder keep set id instead of its current one, then sweep unretained sets if they piled up
+    inline void assign(PtsID& holder, PtsID id) {
+        retain(id);
+        release(holder);
+        holder = id;
+        if(numOfLiveSets >= MinSweepSize && numOfLiveSets >= 2 * numOfLiveSetsAfterSweep)
+            sweep();
+    }
+    //@}
+
+    /// Memoized set operations, results are not retained
+    //@{
+    PtsID unionPts(PtsID a, PtsID b) {
+        if(a==b || b==0)
+            return a;
+        if(a==0)
+            return b;
+        PtsIDPair key = a < b ? std::make_pair(a,b) : std::make_pair(b,a);
+        PtsID res;
+        if(lookupCache(unionCache, key, res))
+            return res;
+        Data data = getPts(a);
+        data |= getPts(b);
+        return cacheResult(unionCache, key, intern(data));
+    }
+    PtsID intersectPts(PtsID a, PtsID b) {
+        if(a==b)
+            return a;
+        if(a==0 || b==0)
+            return 0;
+        PtsIDPair key = a < b ? std::make_pair(a,b) : std::make_pair(b,a);
+        PtsID res;
+        if(lookupCache(intersectCache, key, res))
+            return res;
+        Data data = getPts(a);
+        data &= getPts(b);
+        return cacheResult(intersectCache, key, intern(data));
+    }
+    /// a - b
+    PtsID complementPts(PtsID a, PtsID b) {
+        if(a==b || a==0)
+            return 0;
+        if(b==0)
+            return a;
+        PtsIDPair key = std::make_pair(a,b);
+        PtsID res;
+        if(lookupCache(complementCache, key, res))
+            return res;
+        Data data;
+        data.intersectWithComplement(getPts(a), getPts(b));
+        return cacheResult(complementCache, key, intern(data));
+    }
+    //@}
+
+    /// Statistics
+    //@{
+    inline u32_t getNumOfLiveSets() const {
+        return numOfLiveSets;
+    }
+    inline u32_t getNumOfOpCacheHits() const {
+        return numOfOpCacheHits;
+    }
+    /// Number of IDs ever handed out, live or free
+    inline u32_t getNumOfIDs() const {
+        return entries.size();
+    }
+    //@}
+
+    /// Drop all memoized results
+    inline void clearOpCaches() {
+        unionCache.clear();
+        intersectCache.clear();
+        complementCache.clear();
+    }
+
+private:
+    struct Entry {
+        Entry(): hash(0), refCount(0), gen(0), live(false) {
+        }
+        Data data;
+        size_t hash;
+        u32_t refCount;
+        u32_t gen;	///< bumped every time the ID is freed
+        bool live;
+    };
+
+    inline size_t hashData(const Data& data) const {
+        size_t hash = 0;
+        for(typename Data::iterator it = data.begin(), eit = data.end(); it!=eit; ++it)
+            hash = llvm::hash_combine(hash, *it);
+        return hash;
+    }
+
+    /// Each operation cache holds at most OpCacheSizePerSet entries per live set (at least MinOpCacheSize),
+    /// it is cleared when it is full so that it never outgrows the sets it saves
+    static const u32_t MinOpCacheSize = 4096;
+    static const u32_t OpCacheSizePerSet = 4;
+    /// Unretained sets are not swept before there are this many live sets
+    static const u32_t MinSweepSize = 1024;
+
+    inline PtsID cacheResult(OpCache& cache, const PtsIDPair& key, PtsID res) {
+        u32_t maxSize = OpCacheSizePerSet * numOfLiveSets;
+        if(maxSize < MinOpCacheSize)
+            maxSize = MinOpCacheSize;
+        if(cache.size() >= maxSize)
+            cache.clear();
+        CachedResult& cached = cache[key];
+        cached.res = res;
+        cached.lhsGen = entries[key.first].gen;
+        cached.rhsGen = entries[key.second].gen;
+        cached.resGen = entries[res].gen;
+        return res;
+    }
+
+    /// A cached result is only usable while none of its IDs has been freed since it was computed
+    inline bool lookupCache(const OpCache& cache, const PtsIDPair& key, PtsID& res) {
+        typename OpCache::const_iterator it = cache.find(key);
+        if(it==cache.end())
+            return false;
+        const CachedResult& cached = it->second;
+        if(entries[key.first].gen != cached.lhsGen || entries[key.second].gen != cached.rhsGen
+                || !entries[cached.res].live || entries[cached.res].gen != cached.resGen)
+            return false;
+        numOfOpCacheHits++;
+        res = cached.res;
+        return true;
+    }
+
+    void freeEntry(PtsID id) {
+        Entry& entry = entries[id];
+        std::pair<typename HashToPtsIDMap::iterator, typename HashToPtsIDMap::iterator> range = hashToPtsID.equal_range(entry.hash);
+        for(typename HashToPtsIDMap::iterator it = range.first; it!=range.second; ++it) {
+            if(it->second == id) {
+                hashToPtsID.erase(it);
+                break;
+            }
+        }
+        entry.data.clear();
+        entry.live = false;
+        entry.gen++;
+        freeIDs.push_back(id);
+        numOfLiveSets--;
+    }
+
+    std::deque<Entry> entries;	///< PtsID -> set, a deque never copies sets when growing
+    /// Free all live sets which no holder retains
+    void sweep() {
+        for(PtsID id = 1; id < entries.size(); ++id) {
+            if(entries[id].live && entries[id].refCount == 0)
+                freeEntry(id);
+        }
+        numOfLiveSetsAfterSweep = numOfLiveSets;
+    }
+
+    std::vector<PtsID> freeIDs;	///< freed IDs to be reused
+    HashToPtsIDMap hashToPtsID;	///< hash -> live sets with this hash
+    OpCache unionCache;
+    OpCache intersectCache;
+    OpCache complementCache;
+    u32_t numOfLiveSets;
+    u32_t numOfLiveSetsAfterSweep;
+    u32_t numOfOpCacheHits;
+};
+
 /*!
  * Basic points-to data structure
  * Given a key (variable/condition variable), return its points-to data (pts/condition pts)
@@ -102,6 +352,15 @@ public:
         return revPtsMap[var];
     }
 
+    /// Get points-to set of the pointer without creating a new entry.
+    /// It never modifies the maps, so it can be queried by multiple threads once solving has finished
+    inline const Data& getConstPts(const Key& var) const {
+        PtsMapConstIter it = ptsMap.find(var);
+        if(it==ptsMap.end())
+            return emptyData;
+        return it->second;
+    }
+
     /// Union/add points-to, used internally
     //@{
     inline bool addPts(const Key &dstKey, const Key& srcKey) {
@@ -120,6 +379,7 @@ public:
 protected:
     PtsMap ptsMap;
     PtsMap revPtsMap;
+    Data emptyData;	///< returned by getConstPts for pointers without points-to entry
 
 private:
     /// Union/add points-to
@@ -176,6 +436,9 @@ public:
     typedef typename PTData<Key,Data>::PtsMap PtsMap;
     typedef typename PTData<CacheKey,Data>::PtsMap CahcePtsMap;
     typedef typename PTData<Key,Data>::PTDataTY PTDataTy;
+    typedef PointsToTable<Data> PtsTable;
+    typedef typename PtsTable::PtsID PtsID;
+    typedef std::map<const Key, PtsID> PropaPtsMap;
     /// Constructor
     DiffPTData(PTDataTy ty = (PTData<Key,Data>::DiffPTD)): PTData<Key,Data>(ty) {
     }
@@ -188,23 +451,27 @@ public:
         return diffPtsMap[var];
     }
     /// Get propagated points to.
-    inline Data & getPropaPts(Key& var) {
-        return propaPtsMap[var];
+    inline const Data & getPropaPts(Key& var) {
+        return propaPtsTable.getPts(propaPtsMap[var]);
     }
 
     /**
      * Compute diff points to. Return TRUE if diff is not empty.
      * 1. calculate diff by: diff = all - propa;
      * 2. update propagated pts: propa = all.
+     * Propagated sets are interned, nodes which propagated the same set share one copy.
      */
     inline bool computeDiffPts(Key& var, Data& all) {
         /// clear diff pts.
         Data& diff = getDiffPts(var);
         diff.clear();
         /// get all pts
-        Data& propa = getPropaPts(var);
-        diff.intersectWithComplement(all, propa);
-        propa = all;
+        PtsID& propa = propaPtsMap[var];
+        const Data& propaData = propaPtsTable.getPts(propa);
+        diff.intersectWithComplement(all, propaData);
+        if (diff.empty() && propaData == all)
+            return false;
+        propaPtsTable.assign(propa, propaPtsTable.intern(all));
         return (diff.empty() == false);
     }
 
@@ -213,14 +480,19 @@ public:
      * The final result is the intersection of these two sets.
      */
     inline void updatePropaPtsMap(Key& src, Key&dst) {
-        Data& srcPropa = getPropaPts(src);
-        Data& dstPropa = getPropaPts(dst);
-        dstPropa &= srcPropa;
+        PtsID srcPropa = propaPtsMap[src];
+        PtsID& dstPropa = propaPtsMap[dst];
+        propaPtsTable.assign(dstPropa, propaPtsTable.intersectPts(dstPropa, srcPropa));
     }
 
     /// Clear propagated pts
     inline void clearPropaPts(Key& var) {
-        getPropaPts(var).clear();
+        propaPtsTable.assign(propaPtsMap[var], 0);
+    }
+
+    /// Get the table of interned propagated points-to sets
+    inline const PtsTable& getPropaPtsTable() const {
+        return propaPtsTable;
     }
 
     /// Get cached points-to
@@ -245,7 +517,8 @@ public:
 
 private:
     PtsMap diffPtsMap;	///< diff points-to to be propagated
-    PtsMap propaPtsMap;	///< points-to already propagated
+    PropaPtsMap propaPtsMap;	///< points-to already propagated (interned)
+    PtsTable propaPtsTable;	///< interned propagated points-to sets
 
     CahcePtsMap CacheMap;	///< points-to processed at load/store edge
 };
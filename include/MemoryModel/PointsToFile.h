@@ -0,0 +1,150 @@
+//===- PointsToFile.h -- Binary on-disk points-to results --------------------//
+//
+//                     SVF: Static Value-Flow Analysis
+//
+// Copyright (C) <2013-2017>  <Yulei Sui>
+//
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+
+/*
+ * PointsToFile.h
+ *
+ *  Binary, memory-mapped file of pointer analysis results
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#ifndef POINTSTOFILE_H_
+#define POINTSTOFILE_H_
+
+#include "Util/BasicTypes.h"
+#include <llvm/ADT/DenseMap.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/raw_ostream.h>
+#include <atomic>
+#include <memory>
+
+/*!
+ * Layout of a points-to file (all integers are little endian)
+ *
+ *   Header   magic "SVFPTS\0\0", version, #vars, #gep objects, reserved,
+ *            offsets of the index, gep and payload sections (u64 each)
+ *   Payload  one compressed bitset per var:
+ *            ULEB128 #words, then (ULEB128 word index delta, u64 word) per non-zero word
+ *   Index    (u32 var, u32 reserved, u64 payload offset) per var, sorted by var
+ *   Gep      (u32 gep object, u32 base object, s64 offset) per gep object node
+ */
+namespace PointsToFileFormat {
+const char Magic[8] = {'S', 'V', 'F', 'P', 'T', 'S', '\0', '\0'};
+const u32_t Version = 1;
+const u32_t HeaderSize = 48;
+const u32_t IndexEntrySize = 16;
+const u32_t GepEntrySize = 16;
+}
+
+/*!
+ * Write points-to results in the binary format.
+ * Payloads are streamed out directly, only the index is kept in memory.
+ */
+class PointsToFileWriter {
+public:
+    /// Constructor, the output must support seeking as the header is written last
+    PointsToFileWriter(llvm::raw_fd_ostream& o);
+
+    /// Add the points-to set of a var, vars must be added in ascending order
+    void addPts(NodeID var, const PointsTo& pts);
+
+    /// Add a gep object node created during solving
+    void addGepObj(NodeID id, NodeID base, Size_t offset);
+
+    /// Write the index, the gep section and the header
+    void finish();
+
+private:
+    llvm::raw_fd_ostream& os;
+    std::vector<std::pair<NodeID, u64_t> > index;	///< var -> payload offset
+    std::vector<std::pair<NodeID, std::pair<NodeID, Size_t> > > gepObjs;	///< gep object -> (base, offset)
+    u64_t payloadSize;
+};
+
+/*!
+ * A points-to file opened for lazy reading.
+ * The file is memory mapped; a points-to set is decoded when it is queried
+ * for the first time, so only the pages of queried sets are faulted in.
+ * Decoding is thread-safe.
+ */
+class PointsToFile {
+public:
+    /// Whether a file is in the binary format
+    static bool isPointsToFile(const std::string& filename);
+
+    /// Open a file, return NULL if it is not a valid points-to file or if
+    /// its header, section bounds or index are inconsistent with its size
+    static PointsToFile* open(const std::string& filename);
+
+    /// Destructor
+    ~PointsToFile();
+
+    /// Vars with points-to sets
+    //@{
+    inline u32_t getNumOfVars() const {
+        return numOfVars;
+    }
+    NodeID getVar(u32_t slot) const;
+    inline bool hasPts(NodeID var) const {
+        return varToSlot.count(var);
+    }
+    //@}
+
+    /// Get the points-to set of a var in the file, decode it on first access.
+    /// A corrupt payload is a fatal error.
+    //@{
+    PointsTo& getPts(NodeID var);
+    /// Return NULL if the var is not in the file
+    PointsTo* findPts(NodeID var);
+    //@}
+
+    /// Gep object nodes
+    //@{
+    inline u32_t getNumOfGepObjs() const {
+        return numOfGepObjs;
+    }
+    void getGepObj(u32_t i, NodeID& id, NodeID& base, Size_t& offset) const;
+    //@}
+
+private:
+    /// Constructor
+    PointsToFile(std::unique_ptr<llvm::MemoryBuffer> buf);
+
+    /// Get the points-to set of an index slot, decode it on first access
+    PointsTo& getPtsOfSlot(u32_t slot);
+
+    /// Decode a payload, return false if it is corrupt
+    bool decode(u32_t slot, PointsTo& pts) const;
+
+    std::unique_ptr<llvm::MemoryBuffer> buffer;	///< mapped file
+    const char* index;
+    const char* gepObjs;
+    const char* payload;
+    const char* payloadEnd;	///< end of the payload section (start of the index)
+    u32_t numOfVars;
+    u32_t numOfGepObjs;
+    llvm::DenseMap<NodeID, u32_t> varToSlot;	///< var -> index slot, built once when the file is opened
+    std::atomic<PointsTo*>* decoded;	///< slot -> decoded points-to set
+};
+
+#endif /* POINTSTOFILE_H_ */
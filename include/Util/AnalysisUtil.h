@@ -519,6 +519,10 @@ std::string  getSourceLoc(const llvm::Value *val);
 std::string  getSourceLocOfFunction(const llvm::Function *F);
 //@}
 
+/// 64-bit FNV-1a hash of a string, which is stable across runs and platforms.
+/// Pass the previous result as hash to hash a sequence of strings.
+u64_t getStableHash(llvm::StringRef str, u64_t hash = 14695981039346656037ULL);
+
 /// Dump sparse bitvector set
 void dumpSet(llvm::SparseBitVector<> To, llvm::raw_ostream & O = llvm::outs());
 
@@ -33,6 +33,7 @@
 #include <llvm/ADT/SmallVector.h>		// for small vector
 #include <llvm/ADT/DenseSet.h>		// for dense map, set
 #include <llvm/ADT/SparseBitVector.h>	// for points-to
+#include <chrono>
 #include <vector>
 #include <list>
 #include <set>
@@ -48,6 +49,7 @@ typedef unsigned ThreadID;
 typedef unsigned u32_t;
 typedef unsigned long long u64_t;
 typedef signed s32_t;
+typedef signed long long s64_t;
 typedef signed long Size_t;
 
 typedef llvm::SparseBitVector<> PointsTo;
@@ -93,11 +95,12 @@ typedef SmallVector16 CallStrCxt;
 #define DMTA "mta"
 
 /*
- * Number of clock ticks per second. A clock tick is the unit by which
- * processor time is measured and is returned by 'clock'.
+ * Number of milliseconds per second.
+ * Timers read the wall clock, since the CPU time returned by 'clock' adds up
+ * all threads of the process and overstates phases running on several threads.
  */
 #define TIMEINTERVAL 1000
-#define CLOCK_IN_MS() (clock() / (CLOCKS_PER_SEC / TIMEINTERVAL))
+#define CLOCK_IN_MS() (std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count())
 
 class BddCond;
 
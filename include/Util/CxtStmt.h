@@ -31,6 +31,163 @@
 #define INCLUDE_UTIL_CXTSTMT_H_
 
 #include "Util/BasicTypes.h"
+#include "Util/WorkList.h"
+#include <llvm/ADT/Hashing.h>
+#include <llvm/ADT/DenseMap.h>
+#include <llvm/Support/MathExtras.h>
+#include <atomic>
+#include <mutex>
+
+typedef u32_t CxtID;
+
+/*!
+ * Interning table of calling contexts.
+ * Contexts form a trie of call site IDs. Each trie node is a context identified
+ * by a 32-bit CxtID (0 is the empty context), so that contexts are copied,
+ * compared and hashed as integers. Context strings are kept for reporting and
+ * for the push/match operations of the analyses.
+ *
+ * Contexts are created from several analysis threads (e.g., by the CxtStmt
+ * constructors), so creating or looking up a context by its call string takes
+ * a mutex. Reading a context by its CxtID (getCxt, pop, top) is lock-free:
+ * contexts are appended to buckets which never move once allocated, and an
+ * entry is published before its ID is handed out.
+ * The table is released once the last analysis holding CxtIDs is destroyed.
+ */
+class CallStrCxtTable {
+public:
+    typedef llvm::DenseMap<std::pair<CxtID, u32_t>, CxtID> ChildMap;
+
+    /// Singleton
+    //@{
+    static inline CallStrCxtTable* getTable() {
+        CallStrCxtTable* t = table.load(std::memory_order_acquire);
+        if (t == NULL) {
+            std::lock_guard<std::mutex> guard(tableMutex);
+            t = table.load(std::memory_order_relaxed);
+            if (t == NULL) {
+                t = new CallStrCxtTable();
+                table.store(t, std::memory_order_release);
+            }
+        }
+        return t;
+    }
+    /// Release the table, no CxtID obtained before may be used afterwards
+    static inline void releaseTable() {
+        std::lock_guard<std::mutex> guard(tableMutex);
+        delete table.load(std::memory_order_relaxed);
+        table.store(NULL, std::memory_order_release);
+    }
+    //@}
+
+    /// Destructor
+    ~CallStrCxtTable() {
+        for (u32_t b = 0; b < NumOfBuckets; ++b)
+            delete[] buckets[b].load(std::memory_order_relaxed);
+    }
+
+    /// Get the ID of a context, create it if it is new
+    inline CxtID getCxtID(const CallStrCxt& cxt) {
+        std::lock_guard<std::mutex> guard(mutex);
+        CxtID id = 0;
+        for (CallStrCxt::const_iterator it = cxt.begin(), eit = cxt.end(); it != eit; ++it)
+            id = pushLocked(id, *it);
+        return id;
+    }
+
+    /// Context of a CxtID, the reference stays valid when new contexts are added
+    inline const CallStrCxt& getCxt(CxtID id) const {
+        return getEntry(id).cxt;
+    }
+
+    /// Push/pop a call site
+    //@{
+    inline CxtID push(CxtID parent, u32_t cs) {
+        std::lock_guard<std::mutex> guard(mutex);
+        return pushLocked(parent, cs);
+    }
+    inline CxtID pop(CxtID id) const {
+        assert(id != 0 && "pop an empty context");
+        return getEntry(id).parent;
+    }
+    inline u32_t top(CxtID id) const {
+        assert(id != 0 && "empty context has no top");
+        return getEntry(id).cxt.back();
+    }
+    //@}
+
+    /// Number of contexts
+    inline u32_t getNumOfCxts() const {
+        return numOfCxts.load(std::memory_order_acquire);
+    }
+
+private:
+    /// A context and its parent (the context without its last call site)
+    struct CxtEntry {
+        CallStrCxt cxt;
+        CxtID parent;
+    };
+
+    /// Bucket b holds the 2^(b+FirstBucketBits) entries following those of bucket b-1
+    //@{
+    static const u32_t FirstBucketBits = 8;
+    static const u32_t NumOfBuckets = 33 - FirstBucketBits;
+    static inline u32_t getBucket(CxtID id) {
+        return llvm::Log2_64((u64_t)id + (1 << FirstBucketBits)) - FirstBucketBits;
+    }
+    static inline u64_t getBucketStart(u32_t b) {
+        return ((u64_t)1 << (b + FirstBucketBits)) - (1 << FirstBucketBits);
+    }
+    //@}
+
+    /// Constructor
+    CallStrCxtTable() : numOfCxts(0) {
+        for (u32_t b = 0; b < NumOfBuckets; ++b)
+            buckets[b].store(NULL, std::memory_order_relaxed);
+        append(CallStrCxt(), 0);
+    }
+
+    /// Entry of a CxtID, which must have been handed out by getCxtID or push
+    inline const CxtEntry& getEntry(CxtID id) const {
+        assert(id < numOfCxts.load(std::memory_order_acquire) && "unknown context");
+        u32_t b = getBucket(id);
+        return buckets[b].load(std::memory_order_acquire)[id - getBucketStart(b)];
+    }
+
+    /// Append a context and publish it, the caller holds the mutex
+    inline CxtID append(const CallStrCxt& cxt, CxtID parent) {
+        CxtID id = numOfCxts.load(std::memory_order_relaxed);
+        u32_t b = getBucket(id);
+        CxtEntry* bucket = buckets[b].load(std::memory_order_relaxed);
+        if (bucket == NULL) {
+            bucket = new CxtEntry[(u64_t)1 << (b + FirstBucketBits)];
+            buckets[b].store(bucket, std::memory_order_release);
+        }
+        CxtEntry& entry = bucket[id - getBucketStart(b)];
+        entry.cxt = cxt;
+        entry.parent = parent;
+        numOfCxts.store(id + 1, std::memory_order_release);
+        return id;
+    }
+
+    /// Push a call site, the caller holds the mutex
+    inline CxtID pushLocked(CxtID parent, u32_t cs) {
+        std::pair<ChildMap::iterator, bool> res = children.insert(std::make_pair(std::make_pair(parent, cs), getNumOfCxts()));
+        if (res.second) {
+            CallStrCxt cxt = getCxt(parent);
+            cxt.push_back(cs);
+            append(cxt, parent);
+        }
+        return res.first->second;
+    }
+
+    std::mutex mutex;	///< guards children and appending to the buckets
+    std::atomic<CxtEntry*> buckets[NumOfBuckets];	///< CxtID -> entry, allocated on demand and never moved
+    std::atomic<u32_t> numOfCxts;	///< number of published entries
+    ChildMap children;			///< (CxtID, call site) -> CxtID
+    static std::atomic<CallStrCxtTable*> table;
+    static std::mutex tableMutex;	///< guards creation and release of the singleton
+};
 
 /*!
  * Context-sensitive thread statement <c,s>
@@ -38,41 +195,32 @@
 class CxtStmt  {
 public:
     /// Constructor
-    CxtStmt(const CallStrCxt& c, const llvm::Instruction* f) :cxt(c), inst(f) {
-    }
-    /// Copy constructor
-    CxtStmt(const CxtStmt& ctm) : cxt(ctm.getContext()),inst(ctm.getStmt()) {
+    CxtStmt(const CallStrCxt& c, const llvm::Instruction* f) :cxtID(CallStrCxtTable::getTable()->getCxtID(c)), inst(f) {
     }
-    /// Destructor
-    virtual ~CxtStmt() {
+    CxtStmt(CxtID c, const llvm::Instruction* f) :cxtID(c), inst(f) {
     }
     /// Return current context
     inline const CallStrCxt& getContext() const {
-        return cxt;
+        return CallStrCxtTable::getTable()->getCxt(cxtID);
+    }
+    /// Return ID of the current context
+    inline CxtID getCxtID() const {
+        return cxtID;
     }
     /// Return current statement
     inline const llvm::Instruction* getStmt() const {
         return inst;
     }
     /// Enable compare operator to avoid duplicated item insertion in map or set
-    /// to be noted that two vectors can also overload operator()
     inline bool operator< (const CxtStmt& rhs) const {
         if(inst!=rhs.getStmt())
             return inst < rhs.getStmt();
         else
-            return cxt < rhs.getContext();
-    }
-    /// Overloading operator=
-    inline CxtStmt& operator= (const CxtStmt& rhs) {
-        if(*this!=rhs) {
-            inst = rhs.getStmt();
-            cxt = rhs.getContext();
-        }
-        return *this;
+            return cxtID < rhs.getCxtID();
     }
     /// Overloading operator==
     inline bool operator== (const CxtStmt& rhs) const {
-        return (inst == rhs.getStmt() && cxt == rhs.getContext());
+        return (inst == rhs.getStmt() && cxtID == rhs.getCxtID());
     }
     /// Overloading operator==
     inline bool operator!= (const CxtStmt& rhs) const {
@@ -83,6 +231,7 @@ public:
         std::string str;
         llvm::raw_string_ostream rawstr(str);
         rawstr << "[:";
+        const CallStrCxt& cxt = getContext();
         for(CallStrCxt::const_iterator it = cxt.begin(), eit = cxt.end(); it!=eit; ++it) {
             rawstr << *it << " ";
         }
@@ -95,7 +244,7 @@ public:
     }
 
 protected:
-    CallStrCxt cxt;
+    CxtID cxtID;
     const llvm::Instruction* inst;
 };
 
@@ -108,37 +257,24 @@ public:
     /// Constructor
     CxtThreadStmt(NodeID t, const CallStrCxt& c, const llvm::Instruction* f) :CxtStmt(c,f), tid(t) {
     }
-    /// Copy constructor
-    CxtThreadStmt(const CxtThreadStmt& ctm) :CxtStmt(ctm), tid(ctm.getTid()) {
-    }
-    /// Destructor
-    virtual ~CxtThreadStmt() {
+    CxtThreadStmt(NodeID t, CxtID c, const llvm::Instruction* f) :CxtStmt(c,f), tid(t) {
     }
     /// Return current context
     inline NodeID getTid() const {
         return tid;
     }
     /// Enable compare operator to avoid duplicated item insertion in map or set
-    /// to be noted that two vectors can also overload operator()
     inline bool operator< (const CxtThreadStmt& rhs) const {
         if (tid != rhs.getTid())
             return tid < rhs.getTid();
         else if(inst!=rhs.getStmt())
             return inst < rhs.getStmt();
         else
-            return cxt < rhs.getContext();
-    }
-    /// Overloading operator=
-    inline CxtThreadStmt& operator= (const CxtThreadStmt& rhs) {
-        if(*this!=rhs) {
-            CxtStmt::operator=(rhs);
-            tid = rhs.getTid();
-        }
-        return *this;
+            return cxtID < rhs.getCxtID();
     }
     /// Overloading operator==
     inline bool operator== (const CxtThreadStmt& rhs) const {
-        return (tid == rhs.getTid() && inst == rhs.getStmt() && cxt == rhs.getContext());
+        return (tid == rhs.getTid() && inst == rhs.getStmt() && cxtID == rhs.getCxtID());
     }
     /// Overloading operator==
     inline bool operator!= (const CxtThreadStmt& rhs) const {
@@ -160,42 +296,33 @@ private:
 class CxtThread {
 public:
     /// Constructor
-    CxtThread(const CallStrCxt& c, const llvm::CallInst* fork) : cxt(c), forksite(fork), inloop(false), incycle(false)  {
+    CxtThread(const CallStrCxt& c, const llvm::CallInst* fork) :
+        cxtID(CallStrCxtTable::getTable()->getCxtID(c)), forksite(fork), inloop(false), incycle(false)  {
     }
-    /// Copy constructor
-    CxtThread(const CxtThread& ct) :
-        cxt(ct.getContext()), forksite(ct.getThread()), inloop(ct.isInloop()), incycle(ct.isIncycle())  {
-    }
-    /// Destructor
-    virtual ~CxtThread() {
+    CxtThread(CxtID c, const llvm::CallInst* fork) : cxtID(c), forksite(fork), inloop(false), incycle(false)  {
     }
     /// Return context of the thread
     inline const CallStrCxt& getContext() const {
-        return cxt;
+        return CallStrCxtTable::getTable()->getCxt(cxtID);
+    }
+    /// Return ID of the context of the thread
+    inline CxtID getCxtID() const {
+        return cxtID;
     }
     /// Return forksite
     inline const llvm::CallInst* getThread() const {
         return forksite;
     }
     /// Enable compare operator to avoid duplicated item insertion in map or set
-    /// to be noted that two vectors can also overload operator()
     inline bool operator< (const CxtThread& rhs) const {
         if (forksite != rhs.getThread())
             return forksite < rhs.getThread();
         else
-            return cxt < rhs.getContext();
-    }
-    /// Overloading operator=
-    inline CxtThread& operator= (const CxtThread& rhs) {
-        if(*this!=rhs) {
-            forksite = rhs.getThread();
-            cxt = rhs.getContext();
-        }
-        return *this;
+            return cxtID < rhs.getCxtID();
     }
     /// Overloading operator==
     inline bool operator== (const CxtThread& rhs) const {
-        return (forksite == rhs.getThread() && cxt == rhs.getContext());
+        return (forksite == rhs.getThread() && cxtID == rhs.getCxtID());
     }
     /// Overloading operator==
     inline bool operator!= (const CxtThread& rhs) const {
@@ -206,6 +333,7 @@ public:
         std::string str;
         llvm::raw_string_ostream rawstr(str);
         rawstr << "[:";
+        const CallStrCxt& cxt = getContext();
         for(CallStrCxt::const_iterator it = cxt.begin(), eit = cxt.end(); it!=eit; ++it) {
             rawstr << *it << " ";
         }
@@ -242,7 +370,7 @@ public:
                          << loop << cycle <<"  ]\n";
     }
 protected:
-    CallStrCxt cxt;
+    CxtID cxtID;
     const llvm::CallInst* forksite;
     bool inloop;
     bool incycle;
@@ -258,14 +386,9 @@ class CxtProc {
 public:
     /// Constructor
     CxtProc(const CallStrCxt& c, const llvm::Function* f) :
-        cxt(c), fun(f) {
+        cxtID(CallStrCxtTable::getTable()->getCxtID(c)), fun(f) {
     }
-    /// Copy constructor
-    CxtProc(const CxtProc& ctm) :
-        cxt(ctm.getContext()), fun(ctm.getProc()) {
-    }
-    /// Destructor
-    virtual ~CxtProc() {
+    CxtProc(CxtID c, const llvm::Function* f) : cxtID(c), fun(f) {
     }
     /// Return current procedure
     inline const llvm::Function* getProc() const {
@@ -273,27 +396,22 @@ public:
     }
     /// Return current context
     inline const CallStrCxt& getContext() const {
-        return cxt;
+        return CallStrCxtTable::getTable()->getCxt(cxtID);
+    }
+    /// Return ID of the current context
+    inline CxtID getCxtID() const {
+        return cxtID;
     }
     /// Enable compare operator to avoid duplicated item insertion in map or set
-    /// to be noted that two vectors can also overload operator()
     inline bool operator<(const CxtProc& rhs) const {
         if (fun != rhs.getProc())
             return fun < rhs.getProc();
         else
-            return cxt < rhs.getContext();
-    }
-    /// Overloading operator=
-    inline CxtProc& operator=(const CxtProc& rhs) {
-        if (*this != rhs) {
-            fun = rhs.getProc();
-            cxt = rhs.getContext();
-        }
-        return *this;
+            return cxtID < rhs.getCxtID();
     }
     /// Overloading operator==
     inline bool operator==(const CxtProc& rhs) const {
-        return (fun == rhs.getProc() && cxt == rhs.getContext());
+        return (fun == rhs.getProc() && cxtID == rhs.getCxtID());
     }
     /// Overloading operator==
     inline bool operator!=(const CxtProc& rhs) const {
@@ -304,6 +422,7 @@ public:
         std::string str;
         llvm::raw_string_ostream rawstr(str);
         rawstr << "[:";
+        const CallStrCxt& cxt = getContext();
         for (CallStrCxt::const_iterator it = cxt.begin(), eit = cxt.end(); it != eit; ++it) {
             rawstr << *it << " ";
         }
@@ -316,7 +435,7 @@ public:
     }
 
 protected:
-    CallStrCxt cxt;
+    CxtID cxtID;
     const llvm::Function* fun;
 };
 
@@ -332,38 +451,24 @@ public:
     /// Constructor
     CxtThreadProc(NodeID t, const CallStrCxt& c, const llvm::Function* f) :CxtProc(c,f),tid(t) {
     }
-    /// Copy constructor
-    CxtThreadProc(const CxtThreadProc& ctm) : CxtProc(ctm.getContext(),ctm.getProc()), tid(ctm.getTid()) {
-    }
-    /// Destructor
-    virtual ~CxtThreadProc() {
+    CxtThreadProc(NodeID t, CxtID c, const llvm::Function* f) :CxtProc(c,f),tid(t) {
     }
     /// Return current thread id
     inline NodeID getTid() const {
         return tid;
     }
     /// Enable compare operator to avoid duplicated item insertion in map or set
-    /// to be noted that two vectors can also overload operator()
     inline bool operator< (const CxtThreadProc& rhs) const {
         if (tid != rhs.getTid())
             return tid < rhs.getTid();
         else if(fun!=rhs.getProc())
             return fun < rhs.getProc();
         else
-            return cxt < rhs.getContext();
-    }
-    /// Overloading operator=
-    inline CxtThreadProc& operator= (const CxtThreadProc& rhs) {
-        if(*this!=rhs) {
-            tid = rhs.getTid();
-            fun = rhs.getProc();
-            cxt = rhs.getContext();
-        }
-        return *this;
+            return cxtID < rhs.getCxtID();
     }
     /// Overloading operator==
     inline bool operator== (const CxtThreadProc& rhs) const {
-        return (tid == rhs.getTid() && fun == rhs.getProc() && cxt == rhs.getContext());
+        return (tid == rhs.getTid() && fun == rhs.getProc() && cxtID == rhs.getCxtID());
     }
     /// Overloading operator==
     inline bool operator!= (const CxtThreadProc& rhs) const {
@@ -378,4 +483,48 @@ private:
     NodeID tid;
 };
 
+/*!
+ * Hash functions of context-sensitive items, so that worklists of them
+ * use a hash set instead of an ordered set for membership
+ */
+//@{
+struct CxtStmtHash {
+    inline size_t operator()(const CxtStmt& cs) const {
+        return llvm::hash_combine(cs.getStmt(), cs.getCxtID());
+    }
+};
+struct CxtThreadStmtHash {
+    inline size_t operator()(const CxtThreadStmt& cts) const {
+        return llvm::hash_combine(cts.getTid(), cts.getStmt(), cts.getCxtID());
+    }
+};
+struct CxtProcHash {
+    inline size_t operator()(const CxtProc& cp) const {
+        return llvm::hash_combine(cp.getProc(), cp.getCxtID());
+    }
+};
+struct CxtThreadProcHash {
+    inline size_t operator()(const CxtThreadProc& ctp) const {
+        return llvm::hash_combine(ctp.getTid(), ctp.getProc(), ctp.getCxtID());
+    }
+};
+
+template<>
+struct WorkListTraits<CxtStmt> {
+    typedef HashMemberSet<CxtStmt, CxtStmtHash> MemberSet;
+};
+template<>
+struct WorkListTraits<CxtThreadStmt> {
+    typedef HashMemberSet<CxtThreadStmt, CxtThreadStmtHash> MemberSet;
+};
+template<>
+struct WorkListTraits<CxtProc> {
+    typedef HashMemberSet<CxtProc, CxtProcHash> MemberSet;
+};
+template<>
+struct WorkListTraits<CxtThreadProc> {
+    typedef HashMemberSet<CxtThreadProc, CxtThreadProcHash> MemberSet;
+};
+//@}
+
 #endif /* INCLUDE_UTIL_CXTSTMT_H_ */
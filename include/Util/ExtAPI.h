@@ -33,8 +33,10 @@
 #ifndef __ExtAPI_H
 #define __ExtAPI_H
 
+#include <llvm/ADT/DenseMap.h>
 #include <llvm/ADT/StringMap.h>
 #include <llvm/IR/Function.h>
+#include <llvm/IR/Module.h>
 #include <map>
 #include <set>
 #include <string>
@@ -84,19 +86,31 @@ private:
     //Each llvm::Function name is mapped to its extf_t
     //  (hash_map and map are much slower).
     llvm::StringMap<extf_t> info;
-    //A cache of is_ext results for all llvm::Function*'s (hash_map is fastest).
-    std::map<const llvm::Function*, bool> isext_cache;
+
+    //Kind of every llvm::Function of the classified modules, filled once by
+    //  classifyModule() so that lookups neither build names nor write.
+    struct FunKind {
+        extf_t type;
+        bool isExt;
+    };
+    llvm::DenseMap<const llvm::Function*, FunKind> funKinds;
 
     void init();                          //fill in the map (see ExtAPI.cpp)
 
     ExtAPI() {
         init();
-        isext_cache.clear();
+        funKinds.clear();
     }
 
     // Singleton pattern here to enable instance of PAG can only be created once.
     static ExtAPI* extAPI;
 
+    //Look (F) up in the name map.
+    extf_t compute_type(const llvm::Function *F) const;
+
+    //Compute whether (F) is external.
+    bool compute_is_ext(const llvm::Function *F) const;
+
 public:
 
     /// Singleton design here to make sure we only have one instance during whole analysis
@@ -107,18 +121,19 @@ public:
         return extAPI;
     }
 
+    //Classify all functions of (M) once.
+    //  Functions of modules not classified are looked up by name on every query.
+    void classifyModule(const llvm::Module &M);
+
     //Return the extf_t of (F).
     extf_t get_type(const llvm::Function *F) const {
         assert(F);
-        std::string funName = F->getName().str();
-        if(F->isIntrinsic()) {
-            funName = "llvm." + F->getName().split('.').second.split('.').first.str();
-        }
-        llvm::StringMap<extf_t>::const_iterator it= info.find(funName);
-        if(it == info.end() || !F->isDeclaration())
+        if(!F->isDeclaration())
             return EFT_OTHER;
-        else
-            return it->second;
+        llvm::DenseMap<const llvm::Function*, FunKind>::const_iterator it= funKinds.find(F);
+        if(it != funKinds.end())
+            return it->second.type;
+        return compute_type(F);
     }
 
     //Does (F) have a static var X (unavailable to us) that its return points to?
@@ -180,23 +195,12 @@ public:
     }
     //Should (F) be considered "external" (either not defined in the program
     //  or a user-defined version of a known alloc or no-op)?
-    bool is_ext(const llvm::Function *F) {
+    bool is_ext(const llvm::Function *F) const {
         assert(F);
-        //Check the cache first; everything below is slower.
-        std::map<const llvm::Function*, bool>::iterator i_iec= isext_cache.find(F);
-        if(i_iec != isext_cache.end())
-            return i_iec->second;
-
-        bool res;
-        if(F->isDeclaration() || F->isIntrinsic()) {
-            res= 1;
-        } else {
-            extf_t t= get_type(F);
-            res= t==EFT_ALLOC || t==EFT_REALLOC || t==EFT_NOSTRUCT_ALLOC
-                 || t==EFT_NOOP || t==EFT_FREE;
-        }
-        isext_cache[F]= res;
-        return res;
+        llvm::DenseMap<const llvm::Function*, FunKind>::const_iterator it= funKinds.find(F);
+        if(it != funKinds.end())
+            return it->second.isExt;
+        return compute_is_ext(F);
     }
 };
 
@@ -0,0 +1,88 @@
+/*
+ * PhaseProfiler.h
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#ifndef PHASEPROFILER_H_
+#define PHASEPROFILER_H_
+
+#include "Util/BasicTypes.h"
+#include <string>
+#include <vector>
+
+/*!
+ * Hierarchical profiler of analysis phases.
+ *
+ * A PhaseScope measures the wall time, the CPU time of its thread and the growth of
+ * the resident and peak resident set size between its construction and destruction.
+ * Scopes nest per thread, a phase is identified by the path of the scopes enclosing it.
+ *
+ * Profiling is off unless -phase-profile=<file> is given. The phases are then written to
+ * the file in the Chrome trace event format when the process exits (it can be loaded in
+ * chrome://tracing or Perfetto, or compared by scripts across runs), and
+ * -phase-profile-summary also prints the aggregated tree of phases.
+ */
+class PhaseProfiler {
+
+public:
+    /// A finished phase
+    struct Phase {
+        std::string path;	///< names of the enclosing phases and this one, separated by '/'
+        const char* name;
+        u32_t tid;			///< profiler's number of the thread, 0 for the first one
+        u32_t depth;		///< number of enclosing phases of the thread
+        double startUs;		///< wall-clock start, relative to the first phase
+        double wallUs;
+        double cpuUs;		///< CPU time of the thread
+        s64_t rssDeltaKB;	///< change of the resident set size
+        s64_t peakDeltaKB;	///< growth of the peak resident set size
+        u64_t peakKB;		///< peak resident set size at the end of the phase
+    };
+
+    /// Whether phases are recorded
+    static bool isEnabled();
+
+    /// Record a finished phase, thread-safe
+    static void addPhase(const Phase& phase);
+
+    /// Write the recorded phases to the trace file and print the summary if requested.
+    /// It is called at exit, and may be called earlier to get results of a run which does not exit normally.
+    static void dump();
+
+    /// Resource counters of the calling thread/process
+    //@{
+    static double getWallUs();
+    static double getThreadCpuUs();
+    static u64_t getRssKB();
+    static u64_t getPeakRssKB();
+    //@}
+
+private:
+    static void writeTrace(const std::vector<Phase>& phases, const std::string& filename);
+    static void printSummary(const std::vector<Phase>& phases);
+};
+
+/*!
+ * RAII scope of a phase, does nothing if profiling is off.
+ * The name must outlive the profiler, i.e., be a string literal.
+ */
+class PhaseScope {
+
+public:
+    explicit PhaseScope(const char* name);
+    ~PhaseScope();
+
+private:
+    const char* name;
+    bool enabled;
+    double wallStart;
+    double cpuStart;
+    u64_t rssStart;
+    u64_t peakStart;
+
+    PhaseScope(const PhaseScope&);
+    void operator=(const PhaseScope&);
+};
+
+#endif /* PHASEPROFILER_H_ */
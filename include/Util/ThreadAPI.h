@@ -31,8 +31,10 @@
 #define THREADAPI_H_
 
 #include "Util/BasicTypes.h"
+#include <llvm/ADT/DenseMap.h>
 #include <llvm/ADT/StringMap.h>
 #include <llvm/IR/Function.h>
+#include <llvm/IR/Module.h>
 #include <llvm/IR/CallSite.h>
 
 /*
@@ -64,11 +66,15 @@ public:
     };
 
     typedef llvm::StringMap<TD_TYPE> TDAPIMap;
+    typedef llvm::DenseMap<const llvm::Function*, TD_TYPE> FunToTypeMap;
 
 private:
     /// API map, from a string to threadAPI type
     TDAPIMap tdAPIMap;
 
+    /// Type of every function of the classified modules
+    FunToTypeMap funToTypeMap;
+
     /// Constructor
     ThreadAPI () {
         init();
@@ -83,7 +89,10 @@ private:
     /// Get the function type if it is a threadAPI function
     inline TD_TYPE getType(const llvm::Function* F) const {
         if(F) {
-            TDAPIMap::const_iterator it= tdAPIMap.find(F->getName().str());
+            FunToTypeMap::const_iterator fit = funToTypeMap.find(F);
+            if(fit != funToTypeMap.end())
+                return fit->second;
+            TDAPIMap::const_iterator it= tdAPIMap.find(F->getName());
             if(it != tdAPIMap.end())
                 return it->second;
         }
@@ -99,6 +108,9 @@ public:
         return tdAPI;
     }
 
+    /// Classify all functions of a module once, later queries of them do not look up names
+    void classifyModule(const llvm::Module& module);
+
     /// Return the callee/callsite/func
     //@{
     const llvm::Function* getCallee(const llvm::Instruction *inst) const;
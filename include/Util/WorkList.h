@@ -41,6 +41,100 @@
 #include <vector>
 #include <deque>
 #include <set>
+#include <unordered_set>
+#include <functional>
+#include <algorithm>
+
+/**
+ * Membership sets which keep the elements of a worklist unique.
+ * They all provide insert (returning false if the data is already there), erase, find and clear.
+ */
+//@{
+/// Ordered set for keys which only provide operator<
+template<class Data>
+class OrderedMemberSet {
+public:
+    inline bool insert(const Data& data) {
+        return data_set.insert(data).second;
+    }
+    inline void erase(const Data& data) {
+        data_set.erase(data);
+    }
+    inline bool find(const Data& data) const {
+        return data_set.find(data) != data_set.end();
+    }
+    inline void clear() {
+        data_set.clear();
+    }
+private:
+    std::set<Data> data_set;
+};
+
+/// Hash set for pointers and hashable composite keys
+template<class Data, class Hash = std::hash<Data> >
+class HashMemberSet {
+public:
+    inline bool insert(const Data& data) {
+        return data_set.insert(data).second;
+    }
+    inline void erase(const Data& data) {
+        data_set.erase(data);
+    }
+    inline bool find(const Data& data) const {
+        return data_set.find(data) != data_set.end();
+    }
+    inline void clear() {
+        data_set.clear();
+    }
+private:
+    std::unordered_set<Data, Hash> data_set;
+};
+
+/// Bitmap for dense integer IDs (e.g., NodeID), it grows with the largest ID pushed
+class DenseIDMemberSet {
+public:
+    inline bool insert(unsigned id) {
+        if (id >= bits.size())
+            bits.resize(std::max<size_t>(id + 1, bits.size() * 2), false);
+        if (bits[id])
+            return false;
+        bits[id] = true;
+        return true;
+    }
+    inline void erase(unsigned id) {
+        assert(id < bits.size() && "id is not in the set");
+        bits[id] = false;
+    }
+    inline bool find(unsigned id) const {
+        return id < bits.size() && bits[id];
+    }
+    inline void clear() {
+        std::fill(bits.begin(), bits.end(), false);
+    }
+private:
+    std::vector<bool> bits;
+};
+//@}
+
+/**
+ * Choose the membership set of a worklist by its data type.
+ * Dense IDs use a bitmap, pointers a hash set and other keys an ordered set.
+ * Composite keys can be specialised to use HashMemberSet with their own hash.
+ */
+//@{
+template<class Data>
+struct WorkListTraits {
+    typedef OrderedMemberSet<Data> MemberSet;
+};
+template<>
+struct WorkListTraits<unsigned> {
+    typedef DenseIDMemberSet MemberSet;
+};
+template<class T>
+struct WorkListTraits<T*> {
+    typedef HashMemberSet<T*> MemberSet;
+};
+//@}
 
 /**
  * Worlist with "first come first go" order.
@@ -117,32 +211,34 @@ private:
 /**
  * Worlist with "first in first out" order.
  * New nodes will be pushed at back and popped from front.
- * Elements in the list are unique as they're recorded by std::set.
+ * Elements are kept in a ring buffer and are unique as they're recorded by
+ * the membership set chosen by WorkListTraits.
  */
-template<class Data>
+template<class Data, class MemberSet = typename WorkListTraits<Data>::MemberSet>
 class FIFOWorkList {
-    typedef std::set<Data> DataSet;
-    typedef std::deque<Data> DataDeque;
+    typedef std::vector<Data> DataVector;
 public:
-    FIFOWorkList() {}
+    FIFOWorkList() : head(0), count(0) {}
 
     ~FIFOWorkList() {}
 
     inline bool empty() const {
-        return data_list.empty();
+        return count == 0;
     }
 
     inline bool find(Data data) const {
-        return (data_set.find(data) == data_set.end() ? false : true);
+        return data_set.find(data);
     }
 
     /**
      * Push a data into the work list.
      */
     inline bool push(Data data) {
-        if (data_set.find(data) == data_set.end()) {
-            data_list.push_back(data);
-            data_set.insert(data);
+        if (data_set.insert(data)) {
+            if (count == data_list.size())
+                grow(data);
+            data_list[(head + count) & (data_list.size() - 1)] = data;
+            count++;
             return true;
         }
         else
@@ -150,12 +246,13 @@ public:
     }
 
     /**
-     * Pop a data from the END of work list.
+     * Pop a data from the FRONT of work list.
      */
     inline Data pop() {
         assert(!empty() && "work list is empty");
-        Data data = data_list.front();
-        data_list.pop_front();
+        Data data = data_list[head];
+        head = (head + 1) & (data_list.size() - 1);
+        count--;
         data_set.erase(data);
         return data;
     }
@@ -166,21 +263,37 @@ public:
     inline void clear() {
         data_list.clear();
         data_set.clear();
+        head = 0;
+        count = 0;
     }
 
 private:
-    DataSet data_set;	///< store all data in the work list.
-    DataDeque data_list;	///< work list using std::vector.
+    /// Double the ring buffer (its capacity is always a power of two).
+    /// Free slots are filled with a copy of data as Data may not be default constructible.
+    void grow(const Data& data) {
+        size_t capacity = data_list.empty() ? 16 : data_list.size() * 2;
+        DataVector newList;
+        newList.reserve(capacity);
+        for (size_t i = 0; i < count; ++i)
+            newList.push_back(data_list[(head + i) & (data_list.size() - 1)]);
+        newList.resize(capacity, data);
+        data_list.swap(newList);
+        head = 0;
+    }
+
+    MemberSet data_set;	///< store all data in the work list.
+    DataVector data_list;	///< ring buffer of the work list.
+    size_t head;	///< position of the front element
+    size_t count;	///< number of elements in the work list
 };
 
 /**
  * Worlist with "first in last out" order.
  * New nodes will be pushed at back and popped from back.
- * Elements in the list are unique as they're recorded by std::set.
+ * Elements in the list are unique as they're recorded by the membership set chosen by WorkListTraits.
  */
-template<class Data>
+template<class Data, class MemberSet = typename WorkListTraits<Data>::MemberSet>
 class FILOWorkList {
-    typedef std::set<Data> DataSet;
     typedef std::vector<Data> DataVector;
 public:
     FILOWorkList() {}
@@ -192,16 +305,15 @@ public:
     }
 
     inline bool find(Data data) const {
-        return (data_set.find(data) == data_set.end() ? false : true);
+        return data_set.find(data);
     }
 
     /**
      * Push a data into the work list.
      */
     inline bool push(Data data) {
-        if (data_set.find(data) == data_set.end()) {
+        if (data_set.insert(data)) {
             data_list.push_back(data);
-            data_set.insert(data);
             return true;
         }
         else
@@ -228,7 +340,7 @@ public:
     }
 
 private:
-    DataSet data_set;	///< store all data in the work list.
+    MemberSet data_set;	///< store all data in the work list.
     DataVector data_list;	///< work list using std::vector.
 };
 
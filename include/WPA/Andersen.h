@@ -36,6 +36,7 @@
 #include "MemoryModel/ConsG.h"
 #include <llvm/PassAnalysisSupport.h>	// analysis usage
 #include <llvm/Support/Debug.h>		// DEBUG TYPE
+#include <vector>
 
 class PTAType;
 /*!
@@ -149,7 +150,11 @@ public:
 
     /// Get points-to set
     virtual inline PointsTo& getPts(NodeID id) {
-        return getPTDataTy()->getPts(sccRepNode(id));
+        return BVDataPTAImpl::getPts(sccRepNode(id));
+    }
+    /// Get points-to set without creating a new entry
+    virtual inline const PointsTo& getConstPts(NodeID id) const {
+        return BVDataPTAImpl::getConstPts(sccRepNode(id));
     }
 
     /// Get constraint graph
@@ -179,6 +184,8 @@ protected:
     virtual void processGep(NodeID node, const GepCGEdge* edge);
 
     virtual void processGepPts(PointsTo& pts, const GepCGEdge* edge);
+
+    void computeGepPts(PointsTo& pts, const GepCGEdge* edge, PointsTo& tmpDstPts);
     //@}
 
     /// Add copy edge on constraint graph
@@ -288,6 +295,25 @@ private:
 
     static AndersenWaveDiff* diffWave; // static instance
 
+    /*!
+     * Points-to sets to be unioned into their destination nodes.
+     * Copy/gep edges of consecutive nodes in topological order are collected here
+     * as long as no collected edge targets the next node, so that the unions can be
+     * done by multiple threads and still give the results of the sequential solver.
+     */
+    struct PtsBatch {
+        struct Contribution {
+            NodeID dst;
+            const PointsTo* pts;
+            bool changed;
+        };
+        std::vector<Contribution> contributions;	///< unions in the order of the sequential solver
+        std::vector<PointsTo*> gepPts;	///< points-to sets computed for gep edges, owned by the batch
+        NodeBS dsts;	///< destinations of the contributions
+    };
+
+    PtsBatch batch;
+
     PointsTo & getCachePts(const ConstraintEdge* edge) {
         EdgeID edgeId = edge->getEdgeID();
         return getDiffPTDataTy()->getCachePts(edgeId);
@@ -319,7 +345,12 @@ private:
     //@}
 
 public:
-    AndersenWaveDiff(PTATY type = AndersenWaveDiff_WPA): AndersenWave(type) {}
+    AndersenWaveDiff(PTATY type = AndersenWaveDiff_WPA): AndersenWave(type), workers(NULL) {}
+
+    /// Destructor
+    virtual ~AndersenWaveDiff() {
+        stopBatchWorkers();
+    }
 
     /// Create an singleton instance directly instead of invoking llvm pass manager
     static AndersenWaveDiff* createAndersenWaveDiff(llvm::Module& module) {
@@ -345,7 +376,43 @@ public:
 
     virtual bool updateCallGraph(const CallSiteToFunPtrMap& callsites);
 
+    /// Set the number of threads used to propagate points-to sets in the topological pass.
+    /// More than one thread is experimental.
+    static inline void setNumOfThreads(u32_t n) {
+        numOfThreads = n;
+    }
+
 protected:
+    /// Number of threads propagating points-to sets, 1 for the sequential solver
+    static u32_t numOfThreads;
+
+    /// Constraint solving, the topological pass is batched if multiple threads are used
+    virtual void solve();
+
+    /// Finalize analysis, the batch workers are no longer needed
+    virtual inline void finalize() {
+        stopBatchWorkers();
+        AndersenWave::finalize();
+    }
+
+    /// Batched propagation
+    //@{
+    void processNodeInBatch(NodeID nodeId);
+    void addToBatch(NodeID dst, const PointsTo* pts);
+    void propagateBatch();
+    struct BatchSchedule;
+    void propagateBatchInThread(BatchSchedule* schedule, u32_t worker);
+    //@}
+
+    /// Helper threads of the batched propagation, kept from the first batch until finalize()
+    //@{
+    struct BatchWorkers;
+    BatchWorkers* workers;
+    void startBatchWorkers();
+    void stopBatchWorkers();
+    void runBatchWorker(u32_t worker);
+    //@}
+
     virtual void mergeNodeToRep(NodeID nodeId,NodeID newRepId);
 
     virtual inline bool addCopyEdge(NodeID src, NodeID dst) {
@@ -26,11 +26,12 @@ void BoundsInstrumentor::instrument() {
 }
 
 /*!
- *
+ * malloc and free are renamed to __dvf_malloc and __dvf_free, which
+ * add and remove the metadata of the allocation in the runtime
  */
 bool BoundsInstrumentor::isInterestedTransFun(Function* fun) {
     if (analysisUtil::isExtCall(fun)) {
-        if (fun->getName() == "malloc")
+        if (fun->getName() == "malloc" || fun->getName() == "free")
             return true;
     }
 
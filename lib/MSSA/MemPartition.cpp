@@ -45,8 +45,8 @@ void DistinctMRG::partitionMRs()
         const Function* fun = it->first;
         /// Collect all points-to target in a function scope.
         PointsTo mergePts;
-        for(PointsToList::iterator cit = it->second.begin(), ecit = it->second.end(); cit!=ecit; ++cit) {
-            const PointsTo& pts = *cit;
+        for(PtsIDSet::iterator cit = it->second.begin(), ecit = it->second.end(); cit!=ecit; ++cit) {
+            const PointsTo& pts = getCPts(*cit);
             mergePts |= pts;
         }
         createDistinctMR(fun, mergePts);
@@ -65,13 +65,11 @@ void DistinctMRG::createDistinctMR(const llvm::Function* func, const PointsTo& p
     PointsTo::iterator ptsIt = pts.begin();
     PointsTo::iterator ptsEit = pts.end();
     for (; ptsIt != ptsEit; ++ptsIt) {
-        NodeID id = *ptsIt;
-        // create new conditional points-to set with this single element.
-        PointsTo newPts;
-        newPts.set(id);
+        // conditional points-to set with this single element.
+        PtsID newPts = getSingletonCPts(*ptsIt);
 
         // set the rep cpts as itself.
-        cptsToRepCPtsMap[newPts] = newPts;
+        setRepCPts(newPts, newPts);
 
         // add memory region for this points-to target.
         createMR(func, newPts);
@@ -91,15 +89,7 @@ void DistinctMRG::getMRsForLoad(MRSet& mrs, const PointsTo& pts, const Function*
     PointsTo::iterator ptsIt = pts.begin();
     PointsTo::iterator ptsEit = pts.end();
     for (; ptsIt != ptsEit; ++ptsIt) {
-        NodeID id = *ptsIt;
-        // create new conditional points-to set with this single element.
-        PointsTo newPts;
-        newPts.set(id);
-
-        MemRegion mr(newPts);
-        MRSet::iterator mit = memRegSet.find(&mr);
-        assert(mit!=memRegSet.end() && "memory region not found!!");
-        mrs.insert(*mit);
+        mrs.insert(getMR(getSingletonCPts(*ptsIt)));
     }
 }
 
@@ -120,120 +110,93 @@ void IntraDisjointMRG::partitionMRs()
             eit = getFunToPointsToList().end(); it!=eit; ++it) {
         const Function* fun = it->first;
 
-        for(PointsToList::iterator cit = it->second.begin(), ecit = it->second.end();
-                cit!=ecit; ++cit) {
-            const PointsTo& cpts = *cit;
-
-            PointsToList& inters = getIntersList(fun);
-            computeIntersections(cpts, inters);
-        }
+        ObjToInterMap& inters = getIntersList(fun);
+        computeIntersections(it->second, inters);
 
         /// Create memory regions.
-        const PointsToList& inters = getIntersList(fun);
-        for (PointsToList::const_iterator interIt = inters.begin(), interEit = inters.end();
-                interIt != interEit; ++interIt) {
-            const PointsTo& inter = *interIt;
-            createDisjointMR(fun, inter);
-        }
+        PtsIDSet disjointCPts;
+        for (ObjToInterMap::const_iterator interIt = inters.begin(), interEit = inters.end();
+                interIt != interEit; ++interIt)
+            disjointCPts.set(interIt->second);
+        for (PtsIDSet::iterator cit = disjointCPts.begin(), ecit = disjointCPts.end(); cit != ecit; ++cit)
+            createDisjointMR(fun, *cit);
     }
 }
 
 /**
- * Compute intersections between cpts and computed cpts intersections before.
+ * Partition the objects of a list of cpts by refinement.
+ * Objects are in the same class iff they are contained by the same cpts of the list,
+ * every cpts splits the classes of its objects into the part inside it and the part outside it.
+ * The classes are the coarsest disjoint cpts whose unions make up each cpts of the list.
  */
-void IntraDisjointMRG::computeIntersections(const PointsTo& cpts, PointsToList& inters)
+void IntraDisjointMRG::computeIntersections(const PtsIDSet& cptsList, ObjToInterMap& inters)
 {
-    if (inters.find(cpts) != inters.end()) {
-        // Skip this cpts if it is already in the map.
-        return;
-    }
-    else if (cpts.count() == 1) {
-        // If this cpts has only one element, it will not intersect with any cpts in inters,
-        // just add it into intersection set.
-        inters.insert(cpts);
-        return;
-    }
-    else {
-        PointsToList toBeDeleted;
-        PointsToList newInters;
-
-        PointsTo cpts_copy = cpts;	// make a copy since cpts may be changed.
-
-        // check intersections with existing cpts in subSetMap
-        for (PointsToList::const_iterator interIt = inters.begin(), interEit = inters.end();
-                interIt != interEit; ++interIt) {
-            const PointsTo& inter = *interIt;
-
-            if (cpts_copy.intersects(inter)) {
-                // compute intersection between cpts and inter
-                PointsTo new_inter = inter;
-                new_inter &= cpts_copy;
-
-                // remove old intersection and add new one if possible
-                if (new_inter != inter) {
-                    toBeDeleted.insert(inter);
-                    newInters.insert(new_inter);
-
-                    // compute complement after intersection
-                    PointsTo complement = inter;
-                    complement.intersectWithComplement(new_inter);
-                    if (complement.empty() == false) {
-                        newInters.insert(complement);
-                    }
-                }
-
-                cpts_copy.intersectWithComplement(new_inter);
-
-                if (cpts_copy.empty())
-                    break;
-            }
+    /// class 0 means the object is not in any cpts yet
+    llvm::DenseMap<NodeID, u32_t> objToClass;
+    u32_t numOfClasses = 1;
+
+    for (PtsIDSet::iterator it = cptsList.begin(), eit = cptsList.end(); it != eit; ++it) {
+        const PointsTo& cpts = getCPts(*it);
+        // old class -> the new class of its objects inside cpts
+        llvm::DenseMap<u32_t, u32_t> splits;
+        for (PointsTo::iterator oit = cpts.begin(), eoit = cpts.end(); oit != eoit; ++oit) {
+            u32_t& cls = objToClass[*oit];
+            std::pair<llvm::DenseMap<u32_t, u32_t>::iterator, bool> split =
+                splits.insert(std::make_pair(cls, numOfClasses));
+            if (split.second)
+                numOfClasses++;
+            cls = split.first->second;
         }
+    }
 
-        // remove old intersections
-        for (PointsToList::const_iterator it = toBeDeleted.begin(), eit = toBeDeleted.end();
-                it != eit; ++it) {
-            const PointsTo& temp_cpts = *it;
-            inters.erase(temp_cpts);
-        }
+    /// Intern the classes as disjoint cpts
+    std::vector<PointsTo> classes(numOfClasses);
+    for (llvm::DenseMap<NodeID, u32_t>::const_iterator it = objToClass.begin(), eit = objToClass.end(); it != eit; ++it)
+        classes[it->second].set(it->first);
 
-        // add new intersections
-        for (PointsToList::const_iterator it = newInters.begin(), eit = newInters.end();
-                it != eit; ++it) {
-            const PointsTo& temp_cpts = *it;
-            inters.insert(temp_cpts);
-        }
+    std::vector<PtsID> classToCPts(numOfClasses, PtsTable::InvalidID);
+    for (u32_t cls = 1; cls < numOfClasses; ++cls) {
+        if (!classes[cls].empty())
+            classToCPts[cls] = internCPts(classes[cls]);
+    }
 
-        // add remaining set into inters
-        if (cpts_copy.empty() == false)
-            inters.insert(cpts_copy);
+    for (llvm::DenseMap<NodeID, u32_t>::const_iterator it = objToClass.begin(), eit = objToClass.end(); it != eit; ++it)
+        inters[it->first] = classToCPts[it->second];
+}
+
+/**
+ * Collect the disjoint cpts of the objects in cpts.
+ */
+void IntraDisjointMRG::getIntersOfCPts(PtsIDSet& res, const PointsTo& cpts, const ObjToInterMap& inters) const
+{
+    for (PointsTo::iterator it = cpts.begin(), eit = cpts.end(); it != eit; ++it) {
+        ObjToInterMap::const_iterator iit = inters.find(*it);
+        assert(iit != inters.end() && "object not partitioned!!");
+        res.set(iit->second);
     }
 }
 
 /**
  * Create memory regions for each points-to target.
  */
-void IntraDisjointMRG::createDisjointMR(const llvm::Function* func, const PointsTo& cpts)
+void IntraDisjointMRG::createDisjointMR(const llvm::Function* func, PtsID cpts)
 {
     // set the rep cpts as itself.
-    cptsToRepCPtsMap[cpts] = cpts;
+    setRepCPts(cpts, cpts);
 
     // add memory region for this points-to target.
     createMR(func, cpts);
 }
 
-void IntraDisjointMRG::getMRsForLoadFromInterList(MRSet& mrs, const PointsTo& cpts, const PointsToList& inters)
+/**
+ * A cpts of the partitioned list is the union of the disjoint cpts of its objects.
+ */
+void IntraDisjointMRG::getMRsForLoadFromInterList(MRSet& mrs, const PointsTo& cpts, const ObjToInterMap& inters)
 {
-    PointsToList::const_iterator it = inters.begin();
-    PointsToList::const_iterator eit = inters.end();
-    for (; it != eit; ++it) {
-        const PointsTo& inter = *it;
-        if (cpts.contains(inter)) {
-            MemRegion mr(inter);
-            MRSet::iterator mit = memRegSet.find(&mr);
-            assert(mit!=memRegSet.end() && "memory region not found!!");
-            mrs.insert(*mit);
-        }
-    }
+    PtsIDSet disjointCPts;
+    getIntersOfCPts(disjointCPts, cpts, inters);
+    for (PtsIDSet::iterator it = disjointCPts.begin(), eit = disjointCPts.end(); it != eit; ++it)
+        mrs.insert(getMR(*it));
 }
 
 /**
@@ -250,31 +213,23 @@ void IntraDisjointMRG::getMRsForCallSiteRef(MRSet& aliasMRs, const PointsTo& cpt
 void InterDisjointMRG::partitionMRs()
 {
     /// Generate disjoint cpts.
+    PtsIDSet allCPts;
     for(FunToPointsToMap::iterator it = getFunToPointsToList().begin(),
-            eit = getFunToPointsToList().end(); it!=eit; ++it) {
-        for(PointsToList::iterator cit = it->second.begin(), ecit = it->second.end();
-                cit!=ecit; ++cit) {
-            const PointsTo& cpts = *cit;
-
-            computeIntersections(cpts, inters);
-        }
-    }
+            eit = getFunToPointsToList().end(); it!=eit; ++it)
+        allCPts |= it->second;
+    computeIntersections(allCPts, inters);
 
     /// Create memory regions.
     for(FunToPointsToMap::iterator it = getFunToPointsToList().begin(),
             eit = getFunToPointsToList().end(); it!=eit; ++it) {
         const Function* fun = it->first;
 
-        for(PointsToList::iterator cit = it->second.begin(), ecit = it->second.end();
-                cit!=ecit; ++cit) {
-            const PointsTo& cpts = *cit;
+        PtsIDSet disjointCPts;
+        for(PtsIDSet::iterator cit = it->second.begin(), ecit = it->second.end();
+                cit!=ecit; ++cit)
+            getIntersOfCPts(disjointCPts, getCPts(*cit), inters);
 
-            for (PointsToList::const_iterator interIt = inters.begin(), interEit = inters.end();
-                    interIt != interEit; ++interIt) {
-                const PointsTo& inter = *interIt;
-                if (cpts.contains(inter))
-                    createDisjointMR(fun, inter);
-            }
-        }
+        for (PtsIDSet::iterator cit = disjointCPts.begin(), ecit = disjointCPts.end(); cit != ecit; ++cit)
+            createDisjointMR(fun, *cit);
     }
 }
@@ -33,12 +33,14 @@
 
 #include <llvm/Support/raw_ostream.h>	// for output
 #include <llvm/Support/CommandLine.h>	// for cl::opt
+#include <algorithm>
 
 using namespace llvm;
 using namespace analysisUtil;
 
 Size_t MemRegion::totalMRNum = 0;
 Size_t MRVer::totalVERNum = 0;
+const PtsTable::PtsID PtsTable::InvalidID;
 
 static cl::opt<bool> IgnoreDeadFun("mssa-ignoreDeadFun", cl::init(false),
                                    cl::desc("Don't construct memory SSA for deadfunction"));
@@ -62,33 +64,97 @@ void MRGenerator::destroy() {
 /*!
  * Generate a memory region and put in into functions which use it
  */
-void MRGenerator::createMR(const Function* fun, const PointsTo& cpts) {
-    const PointsTo& repCPts = getRepPointsTo(cpts);
-    MemRegion mr(repCPts);
-    MRSet::const_iterator mit = memRegSet.find(&mr);
-    if(mit!=memRegSet.end()) {
-        const MemRegion* mr = *mit;
-        MRSet& mrs = funToMRsMap[fun];
-        if(mrs.find(mr)==mrs.end())
-            mrs.insert(mr);
+void MRGenerator::createMR(const Function* fun, PtsID cpts) {
+    PtsID repCPts = getRepCPts(cpts);
+    if (repCPts >= repCPtsToMRMap.size())
+        repCPtsToMRMap.resize(ptsTable.size(), NULL);
+    const MemRegion*& mr = repCPtsToMRMap[repCPts];
+    if (mr == NULL) {
+        mr = new MemRegion(getCPts(repCPts));
+        memRegSet.insert(mr);
     }
-    else {
-        MemRegion* m = new MemRegion(repCPts);
-        memRegSet.insert(m);
-        funToMRsMap[fun].insert(m);
+    funToMRsMap[fun].insert(mr);
+}
+
+/*!
+ * Get the memory region of a cpts
+ */
+const MemRegion* MRGenerator::getMR(PtsID cpts) const {
+    PtsID repCPts = getRepCPts(cpts);
+    assert(repCPts < repCPtsToMRMap.size() && repCPtsToMRMap[repCPts] && "memory region not found!!");
+    return repCPtsToMRMap[repCPts];
+}
+
+/*!
+ * Hash the elements of a points-to set
+ */
+u64_t PtsTable::hash(const PointsTo& pts) {
+    u64_t h = 0xcbf29ce484222325ULL;
+    for (PointsTo::iterator it = pts.begin(), eit = pts.end(); it != eit; ++it) {
+        h ^= *it;
+        h *= 0x100000001b3ULL;
+        h ^= h >> 29;
     }
+    return h;
 }
 
 /*!
- * Generate a memory region and put in into functions which use it
+ * Linear probing from the slot of the hash
  */
-const MemRegion* MRGenerator::getMR(const PointsTo& cpts) const {
-    MemRegion mr(getRepPointsTo(cpts));
-    MRSet::iterator mit = memRegSet.find(&mr);
-    assert(mit!=memRegSet.end() && "memory region not found!!");
-    return *mit;
+u32_t PtsTable::lookup(const PointsTo& pts, u64_t h) const {
+    u32_t mask = slots.size() - 1;
+    u32_t slot = h & mask;
+    while (slots[slot] != 0) {
+        PtsID id = slots[slot] - 1;
+        if (hashes[id] == h && ptsList[id] == pts)
+            return slot;
+        slot = (slot + 1) & mask;
+    }
+    return slot;
 }
 
+/*!
+ * Grow the slot array, its size is a power of two
+ */
+void PtsTable::rehash(u32_t numOfSlots) {
+    slots.assign(numOfSlots, 0);
+    u32_t mask = numOfSlots - 1;
+    for (PtsID id = 0; id < hashes.size(); ++id) {
+        u32_t slot = hashes[id] & mask;
+        while (slots[slot] != 0)
+            slot = (slot + 1) & mask;
+        slots[slot] = id + 1;
+    }
+}
+
+/*!
+ * Intern a points-to set, the table is kept at most half full
+ */
+PtsTable::PtsID PtsTable::intern(const PointsTo& pts) {
+    if (2 * (ptsList.size() + 1) > slots.size())
+        rehash(slots.empty() ? 64 : 2 * slots.size());
+
+    u64_t h = hash(pts);
+    u32_t slot = lookup(pts, h);
+    if (slots[slot] != 0)
+        return slots[slot] - 1;
+
+    PtsID id = ptsList.size();
+    ptsList.push_back(pts);
+    hashes.push_back(h);
+    slots[slot] = id + 1;
+    return id;
+}
+
+/*!
+ * Find an interned points-to set
+ */
+PtsTable::PtsID PtsTable::find(const PointsTo& pts) const {
+    if (slots.empty())
+        return InvalidID;
+    u32_t slot = lookup(pts, hash(pts));
+    return slots[slot] ? slots[slot] - 1 : InvalidID;
+}
 
 /*!
  * Collect globals for escape analysis
@@ -229,35 +295,51 @@ void MRGenerator::collectModRefForCall() {
     }
 }
 
+/*!
+ * Get the IDs of a set of cpts sorted by analysisUtil::cmpPts
+ */
+void MRGenerator::getCPtsInOrder(const PtsIDSet& ids, std::vector<PtsID>& ordered) const {
+    ordered.clear();
+    for(PtsIDSet::iterator it = ids.begin(), eit = ids.end(); it!=eit; ++it)
+        ordered.push_back(*it);
+    std::sort(ordered.begin(), ordered.end(), [this](PtsID lhs, PtsID rhs) {
+        return analysisUtil::cmpPts(getCPts(lhs), getCPts(rhs));
+    });
+}
+
 /*!
  * Given a condition pts, insert into cptsToRepCPtsMap
  * Always map it to its superset(rep) cpts according to existing items
  * 1) map cpts to its superset(rep) which exists in the map, otherwise its superset is itself
  * 2) adjust existing items in the map if their supersets are cpts
+ * Among several existing supersets, the rep of the greatest item in cmpPts order is taken,
+ * as when the items were kept in a std::set ordered by cmpPts.
  */
-void MRGenerator::sortPointsTo(const PointsTo& cpts) {
+void MRGenerator::sortPointsTo(PtsID cpts) {
 
-    if(cptsToRepCPtsMap.find(cpts)!=cptsToRepCPtsMap.end())
+    if(hasRepCPts(cpts))
         return;
 
-    PointsToList subSetList;
-    PointsTo repCPts = cpts;
-    for(PtsToRepPtsSetMap::iterator it = cptsToRepCPtsMap.begin(),
-            eit = cptsToRepCPtsMap.end(); it!=eit; ++it) {
-        PointsTo& existCPts = it->second;
-        if(cpts.contains(existCPts)) {
-            subSetList.insert(it->first);
+    const PointsTo& cptsSet = getCPts(cpts);
+    PtsIDSet subSetList;
+    PtsID superSetItem = PtsTable::InvalidID;
+    for(PtsIDSet::iterator it = sortedCPts.begin(), eit = sortedCPts.end(); it!=eit; ++it) {
+        const PointsTo& existCPts = getCPts(getRepCPts(*it));
+        if(cptsSet.contains(existCPts)) {
+            subSetList.set(*it);
         }
-        else if(existCPts.contains(cpts)) {
-            repCPts = existCPts;
+        else if(existCPts.contains(cptsSet)) {
+            if(superSetItem == PtsTable::InvalidID || analysisUtil::cmpPts(getCPts(superSetItem), getCPts(*it)))
+                superSetItem = *it;
         }
     }
+    PtsID repCPts = superSetItem == PtsTable::InvalidID ? cpts : getRepCPts(superSetItem);
 
-    for(PointsToList::iterator it = subSetList.begin(), eit = subSetList.end(); it!=eit; ++it) {
-        cptsToRepCPtsMap[*it] = cpts;
+    for(PtsIDSet::iterator it = subSetList.begin(), eit = subSetList.end(); it!=eit; ++it) {
+        setRepCPts(*it, cpts);
     }
 
-    cptsToRepCPtsMap[cpts] = repCPts;
+    setRepCPts(cpts, repCPts);
 }
 
 /*!
@@ -269,9 +351,12 @@ void MRGenerator::partitionMRs() {
     /// TODO: we may need some refined region partitioning algorithm here
     /// For now, we just collapse all refs/mods objects at callsites into one region
     /// Consider modularly partition memory regions to speed up analysis (only partition regions within function scope)
+    /// The cpts of each function are processed in cmpPts order, which decides the reps
+    std::vector<PtsID> orderedCPts;
     for(FunToPointsToMap::iterator it = getFunToPointsToList().begin(), eit = getFunToPointsToList().end();
             it!=eit; ++it) {
-        for(PointsToList::iterator cit = it->second.begin(), ecit = it->second.end(); cit!=ecit; ++cit) {
+        getCPtsInOrder(it->second, orderedCPts);
+        for(std::vector<PtsID>::iterator cit = orderedCPts.begin(), ecit = orderedCPts.end(); cit!=ecit; ++cit) {
             sortPointsTo(*cit);
         }
     }
@@ -279,7 +364,8 @@ void MRGenerator::partitionMRs() {
     for(FunToPointsToMap::iterator it = getFunToPointsToList().begin(), eit = getFunToPointsToList().end();
             it!=eit; ++it) {
         const Function* fun = it->first;
-        for(PointsToList::iterator cit = it->second.begin(), ecit = it->second.end(); cit!=ecit; ++cit) {
+        getCPtsInOrder(it->second, orderedCPts);
+        for(std::vector<PtsID>::iterator cit = orderedCPts.begin(), ecit = orderedCPts.end(); cit!=ecit; ++cit) {
             createMR(fun,*cit);
         }
     }
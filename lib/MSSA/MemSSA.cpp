@@ -31,6 +31,7 @@
 #include "MSSA/MemSSA.h"
 #include "Util/AnalysisUtil.h"
 #include "MSSA/SVFGStat.h"
+#include "Util/PhaseProfiler.h"
 
 #include <llvm/Analysis/DominanceFrontier.h>
 #include <llvm/IR/InstIterator.h>	// for inst iteration
@@ -39,12 +40,18 @@
 #include <llvm/Support/raw_ostream.h>	// for output
 #include <llvm/Support/CommandLine.h>
 
+#include <atomic>
+#include <mutex>
+#include <thread>
+
 using namespace llvm;
 using namespace analysisUtil;
 
 
 static cl::opt<bool> DumpMSSA("dump-mssa", cl::init(false),
                               cl::desc("Dump memory SSA"));
+static cl::opt<bool> DumpMRVerIDs("dump-mrver-ids", cl::init(false), cl::Hidden,
+                                  cl::desc("Dump the ID of every memory SSA version (e.g. to compare -mssa-threads runs)"));
 static cl::opt<string> MSSAFun("mssafun",  cl::init(""),
                                cl::desc("Please specify which function needs to be dumped"));
 
@@ -63,7 +70,7 @@ double MemSSA::timeOfSSARenaming  = 0;	///< Time for SSA rename
 /*!
  * Constructor
  */
-MemSSA::MemSSA(BVDataPTAImpl* p) : df(NULL),dt(NULL) {
+MemSSA::MemSSA(BVDataPTAImpl* p) : df(NULL),dt(NULL),parent(NULL) {
     pta = p;
     assert((pta->getAnalysisTy()!=PointerAnalysis::Default_PTA)
            && "please specify a pointer analysis");
@@ -92,6 +99,12 @@ MemSSA::MemSSA(BVDataPTAImpl* p) : df(NULL),dt(NULL) {
     timeOfGeneratingMemRegions += (mrEnd - mrStart)/TIMEINTERVAL;
 }
 
+/*!
+ * Constructor of a worker
+ */
+MemSSA::MemSSA(MemSSA* p) : pta(p->pta), mrGen(p->mrGen), df(NULL), dt(NULL), stat(NULL), parent(p) {
+}
+
 /*!
  * Set DF/DT
  */
@@ -134,6 +147,111 @@ void MemSSA::buildMemSSA(const Function& fun, DominanceFrontier* f, DominatorTre
 
 }
 
+/*!
+ * Work shared by the threads building memory SSA
+ */
+struct MemSSA::BuildSchedule {
+    const FunctionVec* funs;
+    std::vector<MemSSA*> workers;	///< worker of each function
+    std::atomic<u32_t> nextFun;
+    std::mutex timeMutex;
+};
+
+/*!
+ * Build memory SSA of functions by multiple threads.
+ * A function is built by its own worker, which shares the regions of this memory SSA,
+ * has its own version stacks and counters and creates mus/chis/phis only for this function.
+ * Workers are merged in the order of funs, their versions are numbered then,
+ * so the results do not depend on which thread builds which function.
+ */
+void MemSSA::buildMemSSAInParallel(const FunctionVec& funs, u32_t numOfThreads) {
+
+    BuildSchedule schedule;
+    schedule.funs = &funs;
+    schedule.workers.resize(funs.size(), NULL);
+    schedule.nextFun = 0;
+
+    std::vector<std::thread> threads;
+    for (u32_t i = 0; i < numOfThreads; ++i)
+        threads.push_back(std::thread(&MemSSA::buildMemSSAInThread, this, &schedule));
+    for (u32_t i = 0; i < threads.size(); ++i)
+        threads[i].join();
+
+    for (u32_t i = 0; i < schedule.workers.size(); ++i) {
+        mergeWorker(schedule.workers[i]);
+        delete schedule.workers[i];
+    }
+}
+
+/*!
+ * Build memory SSA of the functions taken from the schedule.
+ * The time of each phase is the CPU time of the threads spent on it.
+ */
+void MemSSA::buildMemSSAInThread(BuildSchedule* schedule) {
+
+    DominatorTree dt;
+    MemSSADF df;
+    double muchiTime = 0, phiTime = 0, renameTime = 0;
+
+    const FunctionVec& funs = *schedule->funs;
+    for (u32_t i = schedule->nextFun++; i < funs.size(); i = schedule->nextFun++) {
+        Function& fun = *funs[i];
+        assert(!isExtCall(&fun) && "we do not build memory ssa for external functions");
+
+        dt.recalculate(fun);
+        df.runOnDT(dt);
+
+        MemSSA* worker = new MemSSA(this);
+        worker->setCurrentDFDT(&df, &dt);
+
+        double start = PhaseProfiler::getThreadCpuUs();
+        worker->createMUCHI(fun);
+        double muchiEnd = PhaseProfiler::getThreadCpuUs();
+        worker->insertPHI(fun);
+        double phiEnd = PhaseProfiler::getThreadCpuUs();
+        worker->SSARename(fun);
+        double renameEnd = PhaseProfiler::getThreadCpuUs();
+
+        muchiTime += muchiEnd - start;
+        phiTime += phiEnd - muchiEnd;
+        renameTime += renameEnd - phiEnd;
+        worker->setCurrentDFDT(NULL, NULL);
+        schedule->workers[i] = worker;
+    }
+
+    std::lock_guard<std::mutex> lock(schedule->timeMutex);
+    timeOfCreateMUCHI += muchiTime / 1000000;
+    timeOfInsertingPHI += phiTime / 1000000;
+    timeOfSSARenaming += renameTime / 1000000;
+}
+
+/*!
+ * Move the mus/chis/phis of a worker into this memory SSA.
+ * A worker only has the statements of its function, so no entry is already in the maps.
+ */
+void MemSSA::mergeWorker(MemSSA* worker) {
+
+    MRVERID firstID = MRVer::reserveIDs(worker->workerVers.size());
+    for (u32_t i = 0; i < worker->workerVers.size(); ++i)
+        worker->workerVers[i]->setID(firstID + i);
+    worker->workerVers.clear();
+
+    for (LoadToMUSetMap::iterator it = worker->load2MuSetMap.begin(), eit = worker->load2MuSetMap.end(); it != eit; ++it)
+        load2MuSetMap[it->first].swap(it->second);
+    for (StoreToChiSetMap::iterator it = worker->store2ChiSetMap.begin(), eit = worker->store2ChiSetMap.end(); it != eit; ++it)
+        store2ChiSetMap[it->first].swap(it->second);
+    for (CallSiteToMUSetMap::iterator it = worker->callsiteToMuSetMap.begin(), eit = worker->callsiteToMuSetMap.end(); it != eit; ++it)
+        callsiteToMuSetMap[it->first].swap(it->second);
+    for (CallSiteToCHISetMap::iterator it = worker->callsiteToChiSetMap.begin(), eit = worker->callsiteToChiSetMap.end(); it != eit; ++it)
+        callsiteToChiSetMap[it->first].swap(it->second);
+    for (BBToPhiSetMap::iterator it = worker->bb2PhiSetMap.begin(), eit = worker->bb2PhiSetMap.end(); it != eit; ++it)
+        bb2PhiSetMap[it->first].swap(it->second);
+    for (FunToEntryChiSetMap::iterator it = worker->funToEntryChiSetMap.begin(), eit = worker->funToEntryChiSetMap.end(); it != eit; ++it)
+        funToEntryChiSetMap[it->first].swap(it->second);
+    for (FunToReturnMuSetMap::iterator it = worker->funToReturnMuSetMap.begin(), eit = worker->funToReturnMuSetMap.end(); it != eit; ++it)
+        funToReturnMuSetMap[it->first].swap(it->second);
+}
+
 /*!
  * Create mu/chi according to memory regions
  * collect used mrs in usedRegs and construction map from region to BB for prune SSA phi insertion
@@ -358,7 +476,14 @@ MRVer* MemSSA::newSSAName(const MemRegion* mr, MSSADEF* def) {
 
     VERSION version = mr2CounterMap[mr];
     mr2CounterMap[mr] = version + 1;
-    MRVer* mrVer = new MRVer(mr, version, def);
+    MRVer* mrVer;
+    /// a worker's versions are numbered when it is merged
+    if (parent) {
+        mrVer = new MRVer(mr, version, 0, def);
+        workerVers.push_back(mrVer);
+    }
+    else
+        mrVer = new MRVer(mr, version, def);
     mr2VerStackMap[mr].push_back(mrVer);
     return mrVer;
 }
@@ -440,9 +565,12 @@ void MemSSA::destroy() {
         }
     }
 
-    delete mrGen;
+    /// a worker shares the regions of its parent
+    if (parent == NULL) {
+        delete mrGen;
+        delete stat;
+    }
     mrGen = NULL;
-    delete stat;
     stat = NULL;
     pta = NULL;
 }
@@ -679,3 +807,105 @@ void MemSSA::dumpMSSA(llvm::raw_ostream& Out) {
         }
     }
 }
+
+/*!
+ * Print a memory SSA version with its ID
+ */
+static void dumpMRVer(llvm::raw_ostream& Out, const MRVer* ver) {
+    Out << " MR_" << ver->getMR()->getMRID() << "V_" << ver->getSSAVersion() << "#" << ver->getID();
+}
+
+/*!
+ * Print the ID of every memory SSA version, function by function in module order.
+ * Mus, chis and phis are visited in the order of dumpMSSA, so that the output
+ * only depends on the IDs given to the versions.
+ */
+void MemSSA::dumpMRVerIDs(llvm::raw_ostream& Out) {
+    if (!DumpMRVerIDs)
+        return;
+
+    for (Module::iterator fit = pta->getModule()->begin(), efit = pta->getModule()->end();
+            fit != efit; ++fit) {
+        Function& fun = *fit;
+        Out << "FUNCTION: " << fun.getName() << "\n";
+        if (hasFuncEntryChi(&fun)) {
+            CHISet& entryChis = getFuncEntryChiSet(&fun);
+            for (CHISet::iterator it = entryChis.begin(), eit = entryChis.end(); it != eit; ++it) {
+                Out << "ENCHI";
+                dumpMRVer(Out, (*it)->getResVer());
+                dumpMRVer(Out, (*it)->getOpVer());
+                Out << "\n";
+            }
+        }
+
+        for (Function::iterator bit = fun.begin(), ebit = fun.end(); bit != ebit; ++bit) {
+            BasicBlock& bb = *bit;
+            if (hasPHISet(&bb)) {
+                PHISet& phiSet = getPHISet(&bb);
+                for (PHISet::iterator pi = phiSet.begin(), epi = phiSet.end(); pi != epi; ++pi) {
+                    Out << "PHI";
+                    dumpMRVer(Out, (*pi)->getResVer());
+                    std::map<u32_t, const MRVer*> ops((*pi)->opVerBegin(), (*pi)->opVerEnd());
+                    for (std::map<u32_t, const MRVer*>::const_iterator it = ops.begin(), eit = ops.end(); it != eit; ++it)
+                        dumpMRVer(Out, it->second);
+                    Out << "\n";
+                }
+            }
+
+            for (BasicBlock::iterator it = bb.begin(), eit = bb.end(); it != eit; ++it) {
+                Instruction& inst = *it;
+                if (isCallSite(&inst) && isExtCall(&inst)==false) {
+                    CallSite cs = analysisUtil::getLLVMCallSite(&inst);
+                    if (hasMU(cs)) {
+                        MUSet& muSet = getMUSet(cs);
+                        for (MUSet::iterator mit = muSet.begin(), emit = muSet.end(); mit != emit; ++mit) {
+                            Out << "CALMU";
+                            dumpMRVer(Out, (*mit)->getVer());
+                            Out << "\n";
+                        }
+                    }
+                    if (hasCHI(cs)) {
+                        CHISet& chiSet = getCHISet(cs);
+                        for (CHISet::iterator cit = chiSet.begin(), ecit = chiSet.end(); cit != ecit; ++cit) {
+                            Out << "CALCHI";
+                            dumpMRVer(Out, (*cit)->getResVer());
+                            dumpMRVer(Out, (*cit)->getOpVer());
+                            Out << "\n";
+                        }
+                    }
+                }
+                else {
+                    PAGEdgeList& pagEdgeList = mrGen->getPAGEdgesFromInst(&inst);
+                    for (PAGEdgeList::const_iterator eit = pagEdgeList.begin(), eeit = pagEdgeList.end(); eit != eeit; ++eit) {
+                        if (const LoadPE* load = dyn_cast<LoadPE>(*eit)) {
+                            MUSet& muSet = getMUSet(load);
+                            for (MUSet::iterator mit = muSet.begin(), emit = muSet.end(); mit != emit; ++mit) {
+                                Out << "LDMU";
+                                dumpMRVer(Out, (*mit)->getVer());
+                                Out << "\n";
+                            }
+                        }
+                        else if (const StorePE* store = dyn_cast<StorePE>(*eit)) {
+                            CHISet& chiSet = getCHISet(store);
+                            for (CHISet::iterator cit = chiSet.begin(), ecit = chiSet.end(); cit != ecit; ++cit) {
+                                Out << "STCHI";
+                                dumpMRVer(Out, (*cit)->getResVer());
+                                dumpMRVer(Out, (*cit)->getOpVer());
+                                Out << "\n";
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+        if (hasReturnMu(&fun)) {
+            MUSet& returnMus = getReturnMuSet(&fun);
+            for (MUSet::iterator it = returnMus.begin(), eit = returnMus.end(); it != eit; ++it) {
+                Out << "RETMU";
+                dumpMRVer(Out, (*it)->getVer());
+                Out << "\n";
+            }
+        }
+    }
+}
@@ -30,6 +30,7 @@
 #include "MSSA/SVFG.h"
 #include "MSSA/SVFGBuilder.h"
 #include "WPA/Andersen.h"
+#include "Util/PhaseProfiler.h"
 
 using namespace llvm;
 using namespace analysisUtil;
@@ -40,6 +41,9 @@ static cl::opt<bool> SVFGWithIndirectCall("svfgWithIndCall", cl::init(false),
 static cl::opt<bool> SingleVFG("singleVFG", cl::init(false),
                                cl::desc("Create a single VFG shared by multiple analysis"));
 
+static cl::opt<unsigned> MSSAThreads("mssa-threads", cl::init(1),
+                                     cl::desc("Number of threads used to build memory SSA of functions"));
+
 SVFGOPT* SVFGBuilder::globalSvfg = NULL;
 
 /*!
@@ -89,28 +93,46 @@ bool SVFGBuilder::build(SVFG* graph,BVDataPTAImpl* pta) {
 
     DBOUT(DGENERAL, outs() << pasMsg("Build Memory SSA \n"));
 
-    DominatorTree dt;
-    MemSSADF df;
+    {
+        PhaseScope phase("MemSSA build");
+        if (MSSAThreads > 1) {
+            MemSSA::FunctionVec funs;
+            for (llvm::Module::iterator iter = pta->getModule()->begin(), eiter = pta->getModule()->end();
+                    iter != eiter; ++iter) {
+                if (!analysisUtil::isExtCall(&*iter))
+                    funs.push_back(&*iter);
+            }
+            mssa->buildMemSSAInParallel(funs, MSSAThreads);
+        }
+        else {
+            DominatorTree dt;
+            MemSSADF df;
 
-    for (llvm::Module::iterator iter = pta->getModule()->begin(), eiter = pta->getModule()->end();
-            iter != eiter; ++iter) {
+            for (llvm::Module::iterator iter = pta->getModule()->begin(), eiter = pta->getModule()->end();
+                    iter != eiter; ++iter) {
 
-        llvm::Function& fun = *iter;
-        if (analysisUtil::isExtCall(&fun))
-            continue;
+                llvm::Function& fun = *iter;
+                if (analysisUtil::isExtCall(&fun))
+                    continue;
 
-        dt.recalculate(fun);
-        df.runOnDT(dt);
+                dt.recalculate(fun);
+                df.runOnDT(dt);
 
-        mssa->buildMemSSA(fun, &df, &dt);
+                mssa->buildMemSSA(fun, &df, &dt);
+            }
+        }
     }
 
     mssa->performStat();
     mssa->dumpMSSA();
+    mssa->dumpMRVerIDs();
 
     DBOUT(DGENERAL, outs() << pasMsg("Build Sparse Value-Flow Graph \n"));
 
-    createSVFG(mssa, graph);
+    {
+        PhaseScope phase("SVFG build");
+        createSVFG(mssa, graph);
+    }
 
     if(SVFGWithIndirectCall || SVFGWithIndCall)
         updateCallGraph(mssa->getPTA());
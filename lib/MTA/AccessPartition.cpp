@@ -0,0 +1,198 @@
+/*
+ * AccessPartition.cpp
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#include "MTA/AccessPartition.h"
+#include "Util/AnalysisUtil.h"
+#include <llvm/IR/InstIterator.h>	// for inst iteration
+#include <llvm/ADT/Hashing.h>
+
+using namespace llvm;
+using namespace analysisUtil;
+
+
+/*!
+ * Collect all loads and stores of a module
+ */
+void AccessPartitioning::collectAccesses(llvm::Module& module) {
+    for (Module::iterator F = module.begin(), E = module.end(); F != E; ++F) {
+        for (inst_iterator II = inst_begin(&*F), EE = inst_end(&*F); II != EE; ++II) {
+            const Instruction *inst = &*II;
+            if (const StoreInst *st = dyn_cast<StoreInst>(inst)) {
+                accesses.push_back(MTAAccess(st, st->getPointerOperand(), true));
+            }
+            else if (const LoadInst *ld = dyn_cast<LoadInst>(inst)) {
+                accesses.push_back(MTAAccess(ld, ld->getPointerOperand(), false));
+            }
+        }
+    }
+}
+
+/*!
+ * Whether an object may be accessed by more than one thread
+ */
+bool AccessPartitioning::isSharedObj(NodeID obj) const {
+    const MemObj* mem = pta->getPAG()->getObject(obj);
+    if (mem == NULL)
+        return false;
+    return mem->isGlobalObj() || mem->isStaticObj() || mem->isHeap();
+}
+
+/*!
+ * Add an object and all its fields (if it is a base object) to objs.
+ * This mirrors the field expansion performed by BVDataPTAImpl::alias.
+ */
+void AccessPartitioning::addObjAndFields(NodeID obj, PointsTo& objs) const {
+    PAG* pag = pta->getPAG();
+    objs.set(obj);
+    if (pag->getBaseObjNode(obj) == obj)
+        objs |= pag->getAllFieldsObjNode(obj);
+}
+
+/*!
+ * Intern a set of shared objects, equal sets get the same ObjsID
+ */
+AccessPartitioning::ObjsID AccessPartitioning::internObjs(const PointsTo& objs) {
+    if (objs.empty())
+        return 0;
+
+    size_t hash = 0;
+    for (PointsTo::iterator it = objs.begin(), eit = objs.end(); it != eit; ++it)
+        hash = hash_combine(hash, *it);
+
+    std::pair<HashToObjsIDMap::iterator, HashToObjsIDMap::iterator> range = hashToObjsID.equal_range(hash);
+    for (HashToObjsIDMap::iterator it = range.first; it != range.second; ++it) {
+        if (objsTable[it->second].objs == objs)
+            return it->second;
+    }
+
+    ObjsID id = objsTable.size();
+    objsTable.push_back(ObjsEntry());
+    objsTable.back().objs = objs;
+    hashToObjsID.insert(std::make_pair(hash, id));
+    return id;
+}
+
+/*!
+ * Get the interned set of shared objects pointed to by a pointer.
+ * The points-to set is walked only once per pointer node.
+ */
+AccessPartitioning::ObjsID AccessPartitioning::getObjsOfPointer(NodeID ptr) {
+    PtrToObjsIDMap::const_iterator it = ptrToObjsID.find(ptr);
+    if (it != ptrToObjsID.end())
+        return it->second;
+
+    PointsTo objs;
+    const PointsTo& pts = pta->getPts(ptr);
+    for (PointsTo::iterator pit = pts.begin(), epit = pts.end(); pit != epit; ++pit) {
+        if (isSharedObj(*pit))
+            addObjAndFields(*pit, objs);
+    }
+    ObjsID id = internObjs(objs);
+    ptrToObjsID[ptr] = id;
+    return id;
+}
+
+/*!
+ * Summarise every access once, bucket accesses by their shared objects
+ * and compute the partners of each interned set
+ */
+void AccessPartitioning::run() {
+    PAG* pag = pta->getPAG();
+    NodeID blackhole = pag->getBlackHoleNode();
+
+    /// ObjsID 0 is the empty set
+    objsTable.push_back(ObjsEntry());
+
+    for (AccessID id = 0, e = accesses.size(); id != e; ++id) {
+        MTAAccess& access = accesses[id];
+        const Value* ptr = access.getPointer();
+        if (!pag->hasValueNode(ptr))
+            continue;
+
+        NodeID ptrNode = pag->getValueNode(ptr);
+        bool unknown = pta->getPts(ptrNode).test(blackhole);
+        ObjsID objsID = getObjsOfPointer(ptrNode);
+        access.setSummary(objsID, unknown);
+
+        bool write = access.isWrite();
+        if (unknown) {
+            unknownAccesses.set(id);
+            if (write)
+                unknownWrites.set(id);
+        }
+        if (objsID == 0)
+            continue;
+
+        sharedAccesses.set(id);
+        if (write)
+            sharedWrites.set(id);
+
+        const PointsTo& objs = objsTable[objsID].objs;
+        for (PointsTo::iterator it = objs.begin(), eit = objs.end(); it != eit; ++it) {
+            Bucket& bucket = objToBucket[*it];
+            bucket.accesses.set(id);
+            if (write)
+                bucket.writes.set(id);
+        }
+    }
+
+    /// accesses with the same set of objects have the same partners
+    for (ObjsID objsID = 1, e = objsTable.size(); objsID != e; ++objsID) {
+        ObjsEntry& entry = objsTable[objsID];
+        for (PointsTo::iterator it = entry.objs.begin(), eit = entry.objs.end(); it != eit; ++it) {
+            ObjToBucketMap::const_iterator bit = objToBucket.find(*it);
+            if (bit == objToBucket.end())
+                continue;
+            entry.writePartners |= bit->second.accesses;
+            entry.readPartners |= bit->second.writes;
+        }
+    }
+}
+
+/*!
+ * Get candidate partners of an access.
+ * A write pairs with every access sharing one of its buckets, a read only with
+ * the writes of those buckets. Unknown accesses pair with all shared accesses.
+ */
+void AccessPartitioning::getCandidatePartners(AccessID id, NodeBS& partners) const {
+    partners.clear();
+    const MTAAccess& access = accesses[id];
+    bool write = access.isWrite();
+
+    if (access.isShared()) {
+        const ObjsEntry& entry = objsTable[access.getObjsID()];
+        partners |= write ? entry.writePartners : entry.readPartners;
+        partners |= write ? unknownAccesses : unknownWrites;
+    }
+    if (access.isUnknown())
+        partners |= write ? sharedAccesses : sharedWrites;
+
+    /// keep only partners after id so that each pair is generated once
+    NodeBS earlier;
+    for (NodeBS::iterator it = partners.begin(), eit = partners.end(); it != eit && *it < id; ++it)
+        earlier.set(*it);
+    partners.intersectWithComplement(earlier);
+
+    /// a write run by several threads races with itself, a read never does
+    if (write && (access.isShared() || access.isUnknown()))
+        partners.set(id);
+    else
+        partners.reset(id);
+}
+
+/*!
+ * Print partitioning statistics
+ */
+void AccessPartitioning::print() const {
+    outs() << pasMsg(" --- Access Partitioning ---\n");
+    outs() << "No. of accesses: \t" << getNumOfAccesses() << "\n";
+    outs() << "No. of shared accesses: \t" << sharedAccesses.count() << "\n";
+    outs() << "No. of unknown accesses: \t" << unknownAccesses.count() << "\n";
+    outs() << "No. of summarised pointers: \t" << ptrToObjsID.size() << "\n";
+    outs() << "No. of distinct object sets: \t" << getNumOfObjsSets() << "\n";
+    outs() << "No. of object buckets: \t" << getNumOfBuckets() << "\n";
+    outs() << "\n";
+}
@@ -42,9 +42,10 @@ void MTASVFGBuilder::createSVFG(MemSSA* mssa, SVFG* graph) {
 }
 
 /*!
- *
+ * Collect loads/stores and the objects accessed by them,
+ * i.e., the points-to sets of the pointer of a load and of the destination of a store
  */
-void MTASVFGBuilder::collectLoadStoreSVFGNodes() {
+void MTASVFGBuilder::collectLoadStoreSVFGNodes(PointerAnalysis* pta) {
 
     for (SVFG::const_iterator it = svfg->begin(), eit = svfg->end(); it != eit; ++it) {
         const SVFGNode* snode = it->second;
@@ -52,46 +53,50 @@ void MTASVFGBuilder::collectLoadStoreSVFGNodes() {
             const StmtSVFGNode* node = cast<StmtSVFGNode>(snode);
             if (node->getInst()) {
                 ldnodeSet.insert(node);
+                const PointsTo& pts = pta->getPts(node->getPAGSrcNodeID());
+                for (PointsTo::iterator oit = pts.begin(), eoit = pts.end(); oit != eoit; ++oit)
+                    objToLoads[*oit].set(node->getId());
             }
         }
         if (isa<StoreSVFGNode>(snode)) {
             const StmtSVFGNode* node = cast<StmtSVFGNode>(snode);
             if (node->getInst()) {
                 stnodeSet.insert(node);
+                const PointsTo& pts = pta->getPts(node->getPAGDstNodeID());
+                for (PointsTo::iterator oit = pts.begin(), eoit = pts.end(); oit != eoit; ++oit)
+                    objToStores[*oit].set(node->getId());
             }
         }
     }
 }
-bool MTASVFGBuilder::recordEdge(NodeID id1, NodeID id2, PointsTo pts) {
-    NodeIDPair pair = std::make_pair(id1, id2);
-    if (recordedges.find(pair) == recordedges.end()) {
-        recordedges.insert(pair);
-        edge2pts[pair] = pts;
+bool MTASVFGBuilder::recordEdge(NodeID id1, NodeID id2, const PointsTo& pts) {
+    std::pair<EdgeToRecordMap::iterator, bool> res = edgeToRecord.insert(std::make_pair(std::make_pair(id1, id2), (u32_t)recordedges.size()));
+    if (res.second) {
+        recordedges.push_back(std::make_pair(std::make_pair(id1, id2), pts));
         return true;
-    } else {
-        edge2pts[pair] |= pts;
     }
+    recordedges[res.first->second].second |= pts;
     return false;
 }
-bool MTASVFGBuilder::recordAddingEdge(NodeID id1, NodeID id2, PointsTo pts) {
+bool MTASVFGBuilder::recordAddingEdge(NodeID id1, NodeID id2, const PointsTo& pts) {
     return recordEdge(id1, id2, pts);
 }
 
-bool MTASVFGBuilder::recordRemovingEdge(NodeID id1, NodeID id2, PointsTo pts) {
+bool MTASVFGBuilder::recordRemovingEdge(NodeID id1, NodeID id2, const PointsTo& pts) {
     return recordEdge(id1, id2, pts);
 }
 
+/*!
+ * Add the recorded edges to the SVFG in one go
+ */
 void MTASVFGBuilder::performAddingMHPEdges() {
-    MTASVFGBuilder::numOfNewSVFGEdges = recordedges.size();
-    while (!recordedges.empty()) {
-        std::pair<NodeID, NodeID> edgepair = *recordedges.begin();
-        PointsTo pts = edge2pts[edgepair];
-        recordedges.erase(recordedges.begin());
-        addTDEdges(edgepair.first, edgepair.second, pts);
-    }
+    for (RecordedEdgeVec::const_iterator it = recordedges.begin(), eit = recordedges.end(); it != eit; ++it)
+        addTDEdges(it->first.first, it->first.second, it->second);
+    recordedges.clear();
+    edgeToRecord.clear();
 }
 
-SVFGEdge*  MTASVFGBuilder::addTDEdges(NodeID srcId, NodeID dstId, PointsTo& pts) {
+SVFGEdge*  MTASVFGBuilder::addTDEdges(NodeID srcId, NodeID dstId, const PointsTo& pts) {
 
     SVFGNode* srcNode = svfg->getSVFGNode(srcId);
     SVFGNode* dstNode = svfg->getSVFGNode(dstId);
@@ -108,11 +113,9 @@ SVFGEdge*  MTASVFGBuilder::addTDEdges(NodeID srcId, NodeID dstId, PointsTo& pts)
 }
 
 void MTASVFGBuilder::performRemovingMHPEdges() {
-    while (!recordedges.empty()) {
-        std::pair<NodeID, NodeID> edgepair = *recordedges.begin();
-        recordedges.erase(recordedges.begin());
-
-        PointsTo remove_pts = edge2pts[edgepair];
+    for (RecordedEdgeVec::const_iterator rit = recordedges.begin(), reit = recordedges.end(); rit != reit; ++rit) {
+        const NodeIDPair& edgepair = rit->first;
+        const PointsTo& remove_pts = rit->second;
         const StmtSVFGNode*  n1 = cast<StmtSVFGNode>(svfg->getSVFGNode(edgepair.first));
         const StmtSVFGNode*  n2 = cast<StmtSVFGNode>(svfg->getSVFGNode(edgepair.second));
 
@@ -147,6 +150,8 @@ void MTASVFGBuilder::performRemovingMHPEdges() {
             MTASVFGBuilder::numOfRemovedSVFGEdges++;
         }
     }
+    recordedges.clear();
+    edgeToRecord.clear();
 }
 
 
@@ -155,7 +160,7 @@ void MTASVFGBuilder::performRemovingMHPEdges() {
  */
 
 /// whether is a first write in the lock span.
-bool MTASVFGBuilder::isHeadofSpan(const StmtSVFGNode* n, LockAnalysis::LockSpan lspan) {
+bool MTASVFGBuilder::isHeadofSpan(const StmtSVFGNode* n, const LockAnalysis::LockSpan& lspan) {
     SVFGNodeLockSpanPair pair = std::make_pair(n,lspan);
     if (pairheadmap.find(pair) != pairheadmap.end())
         return pairheadmap[pair];
@@ -228,7 +233,7 @@ bool MTASVFGBuilder::isTailofSpan(const StmtSVFGNode* n, InstSet mergespan) {
 }
 
 /// whether is a last write in the lock span.
-bool MTASVFGBuilder::isTailofSpan(const StmtSVFGNode* n, LockAnalysis::LockSpan lspan) {
+bool MTASVFGBuilder::isTailofSpan(const StmtSVFGNode* n, const LockAnalysis::LockSpan& lspan) {
     assert(isa<StoreSVFGNode>(n) && "Node is not a store node");
 
     SVFGNodeLockSpanPair pair = std::make_pair(n,lspan);
@@ -387,7 +392,7 @@ void MTASVFGBuilder::handleStoreLoadNonSparse(const StmtSVFGNode* n1,const StmtS
     PointsTo pts = pta->getPts(n1->getPAGDstNodeID());
     pts &= pta->getPts(n2->getPAGSrcNodeID());
 
-    addTDEdges(n1->getId(), n2->getId(), pts);
+    recordAddingEdge(n1->getId(), n2->getId(), pts);
 }
 
 
@@ -396,8 +401,8 @@ void MTASVFGBuilder::handleStoreStoreNonSparse(const StmtSVFGNode* n1,const Stmt
     PointsTo pts = pta->getPts(n1->getPAGDstNodeID());
     pts &= pta->getPts(n2->getPAGDstNodeID());
 
-    addTDEdges(n1->getId(), n2->getId(), pts);
-    addTDEdges(n2->getId(), n1->getId(), pts);
+    recordAddingEdge(n1->getId(), n2->getId(), pts);
+    recordAddingEdge(n2->getId(), n1->getId(), pts);
 }
 
 void MTASVFGBuilder::handleStoreLoad(const StmtSVFGNode* n1,const StmtSVFGNode* n2, PointerAnalysis* pta) {
@@ -422,9 +427,9 @@ void MTASVFGBuilder::handleStoreLoad(const StmtSVFGNode* n1,const StmtSVFGNode*
 
     if (ADDEDGE_NOLOCK!=AddModelFlag && lockana->isProtectedByCommonLock(i1, i2)) {
         if (isTailofSpan(n1) && isHeadofSpan(n2))
-            addTDEdges(n1->getId(), n2->getId(), pts);
+            recordAddingEdge(n1->getId(), n2->getId(), pts);
     } else {
-        addTDEdges(n1->getId(), n2->getId(), pts);
+        recordAddingEdge(n1->getId(), n2->getId(), pts);
     }
 }
 
@@ -446,12 +451,12 @@ void MTASVFGBuilder::handleStoreStore(const StmtSVFGNode* n1,const StmtSVFGNode*
     /// Lock
     if (ADDEDGE_NOLOCK!=AddModelFlag && lockana->isProtectedByCommonLock(i1, i2)) {
         if (isTailofSpan(n1) && isHeadofSpan(n2))
-            addTDEdges(n1->getId(), n2->getId(), pts);
+            recordAddingEdge(n1->getId(), n2->getId(), pts);
         if (isTailofSpan(n2) && isHeadofSpan(n1))
-            addTDEdges(n2->getId(), n1->getId(), pts);
+            recordAddingEdge(n2->getId(), n1->getId(), pts);
     } else {
-        addTDEdges(n1->getId(), n2->getId(), pts);
-        addTDEdges(n2->getId(), n1->getId(), pts);
+        recordAddingEdge(n1->getId(), n2->getId(), pts);
+        recordAddingEdge(n2->getId(), n1->getId(), pts);
     }
 }
 
@@ -566,7 +571,7 @@ void MTASVFGBuilder::mergeSpan(NodeBS comlocks, InstSet& res) {
 void MTASVFGBuilder::readPrecision() {
 
     recordedges.clear();
-    edge2pts.clear();
+    edgeToRecord.clear();
 
     for (SVFGNodeSet::iterator it1 = stnodeSet.begin(), eit1 = stnodeSet.end(); it1 != eit1; ++it1) {
         const StmtSVFGNode* n1 = cast<StmtSVFGNode>(*it1);
@@ -604,18 +609,74 @@ void MTASVFGBuilder::readPrecision() {
     performRemovingMHPEdges();
 }
 
+/*!
+ * Add thread value-flow edges between stores and loads/stores that may happen in parallel.
+ * An edge carries the objects accessed by both nodes, so only pairs sharing an object
+ * are checked against MHP and locks, except for the models ignoring aliases.
+ * Edges are recorded first and added to the SVFG in bulk, so that the lock span checks
+ * only see the intra-thread value-flows.
+ */
 void MTASVFGBuilder::connectMHPEdges(PointerAnalysis* pta) {
-    PCG* pcg;
-    if (ADDEDGE_NONSPARSE==AddModelFlag) {
-        pcg= new PCG(pta);
-        pcg->analyze();
-    }
-    collectLoadStoreSVFGNodes();
+    collectLoadStoreSVFGNodes(pta);
     recordedges.clear();
-    edge2pts.clear();
+    edgeToRecord.clear();
 
     /// todo: we ignore rule 2 and 3. but so far I haven't added intra-thread value flow affected by fork
     /// and inter-thread value flow affected by join
+    if (ADDEDGE_NONSPARSE == AddModelFlag || ADDEDGE_NOALIAS == AddModelFlag)
+        connectMHPEdgesOfAllPairs(pta);
+    else
+        connectMHPEdgesByObjects(pta);
+
+    performAddingMHPEdges();
+
+    if(ReadPrecisionTDEdge && ADDEDGE_NORP!=AddModelFlag) {
+        DBOUT(DGENERAL,outs()<<"Read precision edge removing \n");
+        DBOUT(DMTA,outs()<<"Read precision edge removing \n");
+        readPrecision();
+    }
+}
+
+/*!
+ * For each store, collect the loads and stores accessing one of its objects from the inverted index
+ */
+void MTASVFGBuilder::connectMHPEdgesByObjects(PointerAnalysis* pta) {
+    for (SVFGNodeSet::const_iterator it1 = stnodeSet.begin(), eit1 =  stnodeSet.end(); it1!=eit1; ++it1) {
+        const StmtSVFGNode* n1 = cast<StmtSVFGNode>(*it1);
+
+        SVFGNodeIDSet loads;
+        SVFGNodeIDSet stores;
+        const PointsTo& pts = pta->getPts(n1->getPAGDstNodeID());
+        for (PointsTo::iterator oit = pts.begin(), eoit = pts.end(); oit != eoit; ++oit) {
+            ObjToSVFGNodesMap::const_iterator lit = objToLoads.find(*oit);
+            if (lit != objToLoads.end())
+                loads |= lit->second;
+            ObjToSVFGNodesMap::const_iterator sit = objToStores.find(*oit);
+            if (sit != objToStores.end())
+                stores |= sit->second;
+        }
+
+        for (SVFGNodeIDSet::iterator it2 = loads.begin(), eit2 = loads.end(); it2 != eit2; ++it2)
+            handleStoreLoad(n1, cast<StmtSVFGNode>(svfg->getSVFGNode(*it2)), pta);
+
+        /// each pair of stores is handled once, from the store with the smaller id
+        for (SVFGNodeIDSet::iterator it2 = stores.begin(), eit2 = stores.end(); it2 != eit2; ++it2) {
+            if (*it2 > n1->getId())
+                handleStoreStore(n1, cast<StmtSVFGNode>(svfg->getSVFGNode(*it2)), pta);
+        }
+    }
+}
+
+/*!
+ * Check every store against every load and every other store
+ */
+void MTASVFGBuilder::connectMHPEdgesOfAllPairs(PointerAnalysis* pta) {
+    PCG* pcg = NULL;
+    if (ADDEDGE_NONSPARSE==AddModelFlag && UsePCG) {
+        pcg= new PCG(pta);
+        pcg->analyze();
+    }
+
     for (SVFGNodeSet::const_iterator it1 = stnodeSet.begin(), eit1 =  stnodeSet.end(); it1!=eit1; ++it1) {
         const StmtSVFGNode* n1 = cast<StmtSVFGNode>(*it1);
         const Instruction* i1 = n1->getInst();
@@ -650,12 +711,7 @@ void MTASVFGBuilder::connectMHPEdges(PointerAnalysis* pta) {
             }
         }
     }
-
-    if(ReadPrecisionTDEdge && ADDEDGE_NORP!=AddModelFlag) {
-        DBOUT(DGENERAL,outs()<<"Read precision edge removing \n");
-        DBOUT(DMTA,outs()<<"Read precision edge removing \n");
-        readPrecision();
-    }
+    delete pcg;
 }
 
 /*!
@@ -34,6 +34,7 @@ void LockAnalysis::analyze() {
 
     collectLockUnlocksites();
     buildCandidateFuncSetforLock();
+    buildLockAliasClasses();
 
     DOTIMESTAT(double lockStart = PTAStat::getClk());
 
@@ -44,6 +45,7 @@ void LockAnalysis::analyze() {
     DBOUT(DGENERAL, outs() << "\tCollect context-sensitive locks\n");
     DBOUT(DMTA, outs() << "\tCollect context-sensitive locks\n");
     collectCxtLock();
+    buildCxtLockAliases();
 
     DBOUT(DGENERAL, outs() << "\tInter-procedural LockAnalysis\n");
     DBOUT(DMTA, outs() << "\tInter-procedural LockAnalysis\n");
@@ -74,6 +76,66 @@ void LockAnalysis::collectLockUnlocksites() {
     }
 }
 
+/*!
+ * Number lock sites densely and group them into alias classes.
+ * Lock sites acquiring the same lock value form one class, and the alias
+ * relation is computed once between class representatives, so that later
+ * lock queries are bitset operations instead of alias queries.
+ */
+void LockAnalysis::buildLockAliasClasses() {
+    typedef std::map<const Value*, NodeID> ValueToClassMap;
+    ValueToClassMap valToClass;
+    InstVec classReps;
+    for (InstSet::const_iterator it = locksites.begin(), eit = locksites.end(); it != eit; ++it) {
+        std::pair<ValueToClassMap::iterator, bool> res = valToClass.insert(std::make_pair(getLockVal(*it), (NodeID)classReps.size()));
+        if (res.second)
+            classReps.push_back(*it);
+        lockSiteToID[*it] = lockSites.size();
+        lockSites.push_back(*it);
+        lockSiteClass.push_back(res.first->second);
+    }
+    numOfLockClasses = classReps.size();
+
+    /// alias relation between classes
+    LockSetVec classAliases(numOfLockClasses);
+    for (NodeID c1 = 0; c1 < numOfLockClasses; ++c1) {
+        for (NodeID c2 = c1; c2 < numOfLockClasses; ++c2) {
+            if (isAliasedLocks(classReps[c1], classReps[c2])) {
+                classAliases[c1].set(c2);
+                classAliases[c2].set(c1);
+            }
+        }
+    }
+
+    LockSetVec classToSites(numOfLockClasses);
+    for (LockSiteID id = 0; id < lockSites.size(); ++id)
+        classToSites[lockSiteClass[id]].set(id);
+
+    lockSiteAliases.resize(lockSites.size());
+    for (LockSiteID id = 0; id < lockSites.size(); ++id) {
+        const LockSet& aliasClasses = classAliases[lockSiteClass[id]];
+        for (LockSet::iterator it = aliasClasses.begin(), eit = aliasClasses.end(); it != eit; ++it)
+            lockSiteAliases[id] |= classToSites[*it];
+    }
+}
+
+/*!
+ * Lift the alias relation of lock sites to context-sensitive locks
+ */
+void LockAnalysis::buildCxtLockAliases() {
+    LockSetVec siteToCxtLocks(lockSites.size());
+    for (CxtLockID id = 0; id < cxtLocks.size(); ++id)
+        siteToCxtLocks[getLockSiteID(cxtLocks[id].getStmt())].set(id);
+
+    cxtLockAliases.clear();
+    cxtLockAliases.resize(cxtLocks.size());
+    for (CxtLockID id = 0; id < cxtLocks.size(); ++id) {
+        const LockSet& aliasSites = lockSiteAliases[getLockSiteID(cxtLocks[id].getStmt())];
+        for (LockSet::iterator it = aliasSites.begin(), eit = aliasSites.end(); it != eit; ++it)
+            cxtLockAliases[id] |= siteToCxtLocks[*it];
+    }
+}
+
 /*!
  * Collect candidate functions for context-sensitive lock analysis
  */
@@ -312,10 +374,10 @@ void LockAnalysis::analyzeLockSpanCxtStmt() {
             handleFork(cts);
         } else if (isTDAcquire(curInst)) {
             assert(hasCxtLock(cts) && "context-sensitive lock not found!!");
-            if(addCxtStmtToSpan(cts,cts))
+            if(addCxtStmtToSpan(cts,getCxtLockID(cts)))
                 handleIntra(cts);
         } else if (isTDRelease(curInst)) {
-            if(removeCxtStmtToSpan(cts,cts))
+            if(hasCxtLock(cts) && removeCxtStmtToSpan(cts,getCxtLockID(cts)))
                 handleIntra(cts);
         } else if (isa<CallInst>(curInst) && !isExtCall(curInst)) {
             handleCall(cts);
@@ -334,10 +396,10 @@ void LockAnalysis::analyzeLockSpanCxtStmt() {
  * Print context-insensitive and context-sensitive locks
  */
 void LockAnalysis::printLocks(const CxtStmt& cts) {
-    const CxtLockSet & lockset = getCxtLockfromCxtStmt(cts);
-    outs() << "\nlock sets size = " << lockset.size() << "\n";
-    for (CxtLockSet::iterator it = lockset.begin(), eit = lockset.end(); it != eit; ++it) {
-        (*it).dump();
+    const LockSet& lockset = getCxtLockfromCxtStmt(cts);
+    outs() << "\nlock sets size = " << lockset.count() << "\n";
+    for (LockSet::iterator it = lockset.begin(), eit = lockset.end(); it != eit; ++it) {
+        getCxtLock(*it).dump();
     }
 }
 
@@ -419,16 +481,15 @@ void LockAnalysis::handleRet(const CxtStmt& cts) {
     }
 }
 
-/// Handle intra
+/// Handle intra, a region leader propagates to the successors of the last instruction of its region
 void LockAnalysis::handleIntra(const CxtStmt& cts) {
 
-    const Instruction* curInst = cts.getStmt();
-    const CallStrCxt& curCxt = cts.getContext();
+    const Instruction* curInst = tct->getRegionEnd(cts.getStmt());
 
     InstVec nextInsts;
     getNextInsts(curInst, nextInsts);
     for (InstVec::const_iterator nit = nextInsts.begin(), enit = nextInsts.end(); nit != enit; ++nit) {
-        CxtStmt newCts(curCxt, *nit);
+        CxtStmt newCts(cts.getCxtID(), *nit);
         markCxtStmtFlag(newCts, cts);
     }
 }
@@ -478,28 +539,33 @@ bool LockAnalysis::isProtectedByCommonLock(const llvm::Instruction *i1, const ll
     numOfTotalQueries++;
     bool commonlock = false;
     DOTIMESTAT(double queryStart = PTAStat::getClk());
-    if (isInsideIntraLock(i1) && isInsideIntraLock(i2))
-        commonlock = isProtectedByCommonCILock(i1,i2) ;
-    else
-        commonlock = isProtectedByCommonCxtLock(i1,i2);
+    commonlock = isProtectedByCommonLockReadOnly(i1,i2);
     DOTIMESTAT(double queryEnd = PTAStat::getClk());
     DOTIMESTAT(lockQueriesTime += (queryEnd - queryStart) / TIMEINTERVAL);
     return commonlock;
 }
 
+/*!
+ * Protected by at least one common lock under every context (read-only, no statistics)
+ */
+bool LockAnalysis::isProtectedByCommonLockReadOnly(const llvm::Instruction *i1, const llvm::Instruction *i2) const {
+    if (isInsideIntraLock(i1) && isInsideIntraLock(i2))
+        return isProtectedByCommonCILock(i1,i2);
+    else
+        return isProtectedByCommonCxtLock(i1,i2);
+}
+
 /*!
  * Protected by at least one common context-insensitive lock
  */
-bool LockAnalysis::isProtectedByCommonCILock(const llvm::Instruction *i1, const llvm::Instruction *i2) {
+bool LockAnalysis::isProtectedByCommonCILock(const llvm::Instruction *i1, const llvm::Instruction *i2) const {
 
     if(!isInsideCondIntraLock(i1) && !isInsideCondIntraLock(i2)) {
-        const InstSet& lockset1 = getIntraLockSet(i1);
-        const InstSet& lockset2 = getIntraLockSet(i2);
-        for (InstSet::const_iterator cil1 = lockset1.begin(), ecil1 = lockset1.end(); cil1!=ecil1; ++cil1) {
-            for (InstSet::const_iterator cil2=lockset2.begin(), ecil2=lockset2.end(); cil2!=ecil2; ++cil2) {
-                if (isAliasedLocks(*cil1, *cil2))
-                    return true;
-            }
+        const LockSet& lockset1 = getIntraLockSet(i1);
+        const LockSet& lockset2 = getIntraLockSet(i2);
+        for (LockSet::iterator cil1 = lockset1.begin(), ecil1 = lockset1.end(); cil1!=ecil1; ++cil1) {
+            if (lockSiteAliases[*cil1].intersects(lockset2))
+                return true;
         }
     }
     return false;
@@ -508,11 +574,11 @@ bool LockAnalysis::isProtectedByCommonCILock(const llvm::Instruction *i1, const
 /*!
  * Protected by at least one common context-sensitive lock
  */
-bool LockAnalysis::isProtectedByCommonCxtLock(const CxtStmt& cxtStmt1, const CxtStmt& cxtStmt2) {
+bool LockAnalysis::isProtectedByCommonCxtLock(const CxtStmt& cxtStmt1, const CxtStmt& cxtStmt2) const {
     if(!hasCxtLockfromCxtStmt(cxtStmt1) || !hasCxtLockfromCxtStmt(cxtStmt2))
         return true;
-    const CxtLockSet& lockset1 = getCxtLockfromCxtStmt(cxtStmt1);
-    const CxtLockSet& lockset2 = getCxtLockfromCxtStmt(cxtStmt2);
+    const LockSet& lockset1 = getCxtLockfromCxtStmt(cxtStmt1);
+    const LockSet& lockset2 = getCxtLockfromCxtStmt(cxtStmt2);
     if (alias(lockset1,lockset2))
         return true;
 
@@ -522,7 +588,7 @@ bool LockAnalysis::isProtectedByCommonCxtLock(const CxtStmt& cxtStmt1, const Cxt
 /*!
  * Protected by at least one common context-sensitive lock under each context
  */
-bool LockAnalysis::isProtectedByCommonCxtLock(const llvm::Instruction *i1, const llvm::Instruction *i2) {
+bool LockAnalysis::isProtectedByCommonCxtLock(const llvm::Instruction *i1, const llvm::Instruction *i2) const {
     if(!hasCxtStmtfromInst(i1) || !hasCxtStmtfromInst(i2))
         return false;
     const CxtStmtSet& ctsset1 = getCxtStmtfromInst(i1);
@@ -531,7 +597,8 @@ bool LockAnalysis::isProtectedByCommonCxtLock(const llvm::Instruction *i1, const
         const CxtStmt& cxtStmt1 = *cts1;
         for (CxtStmtSet::const_iterator cts2 = ctsset2.begin(), ects2 = ctsset2.end(); cts2 != ects2; cts2++) {
             const CxtStmt& cxtStmt2 = *cts2;
-            if(cxtStmt1==cxtStmt2) continue;
+            /// instructions of one region share their statements, only skip the very same statement
+            if(i1==i2 && cxtStmt1==cxtStmt2) continue;
             if(isProtectedByCommonCxtLock(cxtStmt1,cxtStmt2)==false)
                 return false;
         }
@@ -562,14 +629,9 @@ bool LockAnalysis::isInSameSpan(const llvm::Instruction *i1, const llvm::Instruc
  */
 bool LockAnalysis::isInSameCISpan(const llvm::Instruction *i1, const llvm::Instruction *i2) const {
     if(!isInsideCondIntraLock(i1) && !isInsideCondIntraLock(i2)) {
-        const InstSet& lockset1 = getIntraLockSet(i1);
-        const InstSet& lockset2 = getIntraLockSet(i2);
-        for (InstSet::const_iterator cil1 = lockset1.begin(), ecil1 = lockset1.end(); cil1!=ecil1; ++cil1) {
-            for (InstSet::const_iterator cil2=lockset2.begin(), ecil2=lockset2.end(); cil2!=ecil2; ++cil2) {
-                if (*cil1==*cil2)
-                    return true;
-            }
-        }
+        const LockSet& lockset1 = getIntraLockSet(i1);
+        const LockSet& lockset2 = getIntraLockSet(i2);
+        return lockset1.intersects(lockset2);
     }
     return false;
 }
@@ -580,9 +642,9 @@ bool LockAnalysis::isInSameCISpan(const llvm::Instruction *i1, const llvm::Instr
 bool LockAnalysis::isInSameCSSpan(const CxtStmt& cxtStmt1, const CxtStmt& cxtStmt2) const {
     if(!hasCxtLockfromCxtStmt(cxtStmt1) || !hasCxtLockfromCxtStmt(cxtStmt2))
         return true;
-    const CxtLockSet& lockset1 = getCxtLockfromCxtStmt(cxtStmt1);
-    const CxtLockSet& lockset2 = getCxtLockfromCxtStmt(cxtStmt2);
-    if (intersects(lockset1,lockset2))
+    const LockSet& lockset1 = getCxtLockfromCxtStmt(cxtStmt1);
+    const LockSet& lockset2 = getCxtLockfromCxtStmt(cxtStmt2);
+    if (lockset1.intersects(lockset2))
         return true;
 
     return false;
@@ -600,7 +662,7 @@ bool LockAnalysis::isInSameCSSpan(const llvm::Instruction *I1, const llvm::Instr
         const CxtStmt& cxtStmt1 = *cts1;
         for (CxtStmtSet::const_iterator cts2 = ctsset2.begin(), ects2 = ctsset2.end(); cts2 != ects2; cts2++) {
             const CxtStmt& cxtStmt2 = *cts2;
-            if(cxtStmt1==cxtStmt2) continue;
+            if(I1==I2 && cxtStmt1==cxtStmt2) continue;
             if(isInSameCSSpan(cxtStmt1,cxtStmt2)==false)
                 return false;
         }
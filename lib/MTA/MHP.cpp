@@ -7,6 +7,7 @@
 
 
 #include "MTA/MHP.h"
+#include "MTA/MHPSummary.h"
 #include "MTA/MTA.h"
 #include "MTA/LockAnalysis.h"
 #include "MTA/MTAResultValidator.h"
@@ -21,6 +22,8 @@ using namespace analysisUtil;
 
 static cl::opt<bool> PrintInterLev("print-interlev", cl::init(false),cl::desc("Print Thread Interleaving Results"));
 static cl::opt<bool> DoLockAnalysis("lockanalysis", cl::init(true),cl::desc("Run Lock Analysis"));
+static cl::opt<std::string> MHPSummaryFile("mhp-summary", cl::init(""),cl::desc("File to write MHP results to for incremental analysis"));
+static cl::opt<bool> IncrementalMHP("mhp-incremental", cl::init(false),cl::desc("Reuse results in -mhp-summary for threads whose code is unchanged"));
 
 
 /*!
@@ -93,12 +96,56 @@ void MHP::analyze() {
     DBOUT(DGENERAL, outs() << pasMsg("MHP interleaving analysis\n"));
     DBOUT(DMTA, outs() << pasMsg("MHP interleaving analysis\n"));
     DOTIMESTAT(double interleavingStart = PTAStat::getClk());
+
+    /// restore the results of unchanged threads, only the others are propagated again
+    MHPSummary* summary = NULL;
+    if (!MHPSummaryFile.empty()) {
+        summary = new MHPSummary(tct, fja);
+        if (IncrementalMHP && summary->load(MHPSummaryFile)) {
+            u32_t restored = summary->restore(threadStmtToTheadInterLeav, instToTSMap);
+            DBOUT(DMTA, outs() << "MHP summary: reuse " << summary->getCleanThreads().count() << " of "
+                  << tct->getTCTNodeNum() << " threads, " << restored << " thread statements\n");
+        }
+    }
+
     analyzeInterleaving();
+
+    if (summary) {
+        summary->save(MHPSummaryFile, threadStmtToTheadInterLeav, instToTSMap);
+        delete summary;
+    }
+
+    buildIndex();
+
     DOTIMESTAT(double interleavingEnd = PTAStat::getClk());
     DOTIMESTAT(interleavingTime += (interleavingEnd - interleavingStart) / TIMEINTERVAL);
 
 }
 
+/*!
+ * Build the index of thread statements and their interleavings
+ */
+void MHP::buildIndex() {
+    NodeBS multiForked;
+    for (NodeID tid = 0; tid < tct->getTCTNodeNum(); tid++) {
+        if (isMultiForkedThread(tid))
+            multiForked.set(tid);
+    }
+    index.init(tct->getTCTNodeNum(), multiForked);
+
+    std::vector<std::pair<NodeID, const NodeBS*> > stmts;
+    for (InstToThreadStmtSetMap::const_iterator it = instToTSMap.begin(), eit = instToTSMap.end(); it != eit; ++it) {
+        stmts.clear();
+        for (CxtThreadStmtSet::const_iterator sit = it->second.begin(), esit = it->second.end(); sit != esit; ++sit)
+            stmts.push_back(std::make_pair(sit->getTid(), &getConstInterleavingThreads(*sit)));
+        index.addInst(it->first, stmts);
+    }
+    index.finish();
+
+    DBOUT(DMTA, outs() << "MHP index: " << index.getNumOfStmts() << " thread statements, "
+          << index.getNumOfRows() << " distinct thread sets\n");
+}
+
 /*!
  * Analyze thread interleaving
  */
@@ -107,7 +154,7 @@ void MHP::analyzeInterleaving() {
         const CxtThread& ct = it->second->getCxtThread();
         NodeID rootTid = it->first;
         const llvm::Function* routine = tct->getStartRoutineOfCxtThread(ct);
-        CxtThreadStmt rootcts(rootTid,ct.getContext(),&(routine->getEntryBlock().front()));
+        CxtThreadStmt rootcts(rootTid,ct.getCxtID(),&(routine->getEntryBlock().front()));
 
         addInterleavingThread(rootcts,rootTid);
         updateAncestorThreads(rootTid);
@@ -146,7 +193,8 @@ void MHP::analyzeInterleaving() {
     }
 
     /// update non-candidate functions' interleaving
-    updateNonCandidateFunInterleaving();
+    if (!tct->useRegions())
+        updateNonCandidateFunInterleaving();
 
 
     if(PrintInterLev)
@@ -171,13 +219,12 @@ void MHP::updateNonCandidateFunInterleaving() {
 
             for (CxtThreadStmtSet::const_iterator it1 = tsSet.begin(), eit1 = tsSet.end(); it1 != eit1; ++it1) {
                 const CxtThreadStmt& cts = *it1;
-                const CallStrCxt& curCxt = cts.getContext();
 
                 for (const_inst_iterator II = inst_begin(fun), EE = inst_end(fun); II != EE; ++II) {
                     const Instruction *inst = &*II;
                     if (inst == entryinst)
                         continue;
-                    CxtThreadStmt newCts(cts.getTid(), curCxt, inst);
+                    CxtThreadStmt newCts(cts.getTid(), cts.getCxtID(), inst);
                     threadStmtToTheadInterLeav[newCts] |= threadStmtToTheadInterLeav[cts];
                     instToTSMap[inst].insert(newCts);
                 }
@@ -193,12 +240,11 @@ void MHP::handleNonCandidateFun(const CxtThreadStmt& cts) {
     const Instruction* curInst = cts.getStmt();
     const Function* curfun = curInst->getParent()->getParent();
     assert(curInst == &(curfun->getEntryBlock().front()) && "curInst is not the entry of non candidate function.");
-    const CallStrCxt& curCxt = cts.getContext();
     PTACallGraphNode* node = tcg->getCallGraphNode(curfun);
     for (PTACallGraphNode::const_iterator nit = node->OutEdgeBegin(), neit = node->OutEdgeEnd(); nit != neit; nit++) {
         const Function* callee = (*nit)->getDstNode()->getFunction();
         if (!isExtCall(callee)) {
-            CxtThreadStmt newCts(cts.getTid(), curCxt, &(callee->getEntryBlock().front()));
+            CxtThreadStmt newCts(cts.getTid(), cts.getCxtID(), &(callee->getEntryBlock().front()));
             addInterleavingThread(newCts, cts);
         }
     }
@@ -221,7 +267,7 @@ void MHP::handleFork(const CxtThreadStmt& cts, NodeID rootTid) {
             pushCxt(newCxt,call,routine);
             const llvm::Instruction* stmt = &(routine->getEntryBlock().front());
             CxtThread ct(newCxt,call);
-            CxtThreadStmt newcts(tct->getTCTNode(ct)->getId(),ct.getContext(),stmt);
+            CxtThreadStmt newcts(tct->getTCTNode(ct)->getId(),ct.getCxtID(),stmt);
             addInterleavingThread(newcts,cts);
         }
     }
@@ -245,7 +291,7 @@ void MHP::handleJoin(const CxtThreadStmt& cts, NodeID rootTid) {
             joinLoop->getExitBlocks(exitbbs);
             while(!exitbbs.empty()) {
                 BasicBlock* eb = exitbbs.pop_back_val();
-                CxtThreadStmt newCts(cts.getTid(),curCxt,&(eb->front()));
+                CxtThreadStmt newCts(cts.getTid(),cts.getCxtID(),&(eb->front()));
                 addInterleavingThread(newCts,cts);
                 if(isJoinInSymmetricLoop(curCxt,call))
                     rmInterleavingThread(newCts,joinedTids,call);
@@ -264,7 +310,7 @@ void MHP::handleJoin(const CxtThreadStmt& cts, NodeID rootTid) {
             joinLoop->getExitBlocks(exitbbs);
             while(!exitbbs.empty()) {
                 BasicBlock* eb = exitbbs.pop_back_val();
-                CxtThreadStmt newCts(cts.getTid(),cts.getContext(),&(eb->front()));
+                CxtThreadStmt newCts(cts.getTid(),cts.getCxtID(),&(eb->front()));
                 addInterleavingThread(newCts,cts);
             }
         }
@@ -333,13 +379,14 @@ void MHP::handleRet(const CxtThreadStmt& cts) {
 
 /*!
  * Handling intraprocedural statements (successive statements on the CFG )
+ * A region leader propagates to the successors of the last instruction of its region.
  */
 void MHP::handleIntra(const CxtThreadStmt& cts) {
 
     InstVec nextInsts;
-    getNextInsts(cts.getStmt(),nextInsts);
+    getNextInsts(tct->getRegionEnd(cts.getStmt()),nextInsts);
     for(InstVec::const_iterator nit = nextInsts.begin(), enit = nextInsts.end(); nit!=enit; ++nit) {
-        CxtThreadStmt newCts(cts.getTid(),cts.getContext(),*nit);
+        CxtThreadStmt newCts(cts.getTid(),cts.getCxtID(),*nit);
         addInterleavingThread(newCts,cts);
     }
 }
@@ -392,7 +439,7 @@ void MHP::updateSiblingThreads(NodeID curTid) {
             const CxtThread& ct = tct->getTCTNode(*it)->getCxtThread();
             const llvm::Function* routine = tct->getStartRoutineOfCxtThread(ct);
             const llvm::Instruction* stmt = &(routine->getEntryBlock().front());
-            CxtThreadStmt cts(*it,ct.getContext(),stmt);
+            CxtThreadStmt cts(*it,ct.getCxtID(),stmt);
             addInterleavingThread(cts,curTid);
         }
 
@@ -498,34 +545,15 @@ bool MHP::isConnectedfromMain(const Function* fun) {
  */
 
 bool MHP::mayHappenInParallelInst(const llvm::Instruction* i1, const llvm::Instruction* i2) {
+    bool mhp = mayHappenInParallelReadOnly(i1,i2);
+    if(mhp)
+        numOfMHPQueries++;
+    return mhp;
+}
 
+bool MHP::mayHappenInParallelReadOnly(const llvm::Instruction* i1, const llvm::Instruction* i2) const {
     /// TODO: Any instruction in dead function is assumed no MHP with others
-    if(!hasThreadStmtSet(i1) || !hasThreadStmtSet(i2))
-        return false;
-
-    const CxtThreadStmtSet& tsSet1 = getThreadStmtSet(i1);
-    const CxtThreadStmtSet& tsSet2 = getThreadStmtSet(i2);
-    for(CxtThreadStmtSet::const_iterator it1 = tsSet1.begin(), eit1 = tsSet1.end(); it1!=eit1; ++it1) {
-        const CxtThreadStmt& ts1 = *it1;
-        NodeBS l1 = getInterleavingThreads(ts1);
-        for(CxtThreadStmtSet::const_iterator it2 = tsSet2.begin(), eit2 = tsSet2.end(); it2!=eit2; ++it2) {
-            const CxtThreadStmt& ts2 = *it2;
-            NodeBS l2 = getInterleavingThreads(ts2);
-            if(ts1.getTid()!=ts2.getTid()) {
-                if(l1.test(ts2.getTid()) && l2.test(ts1.getTid())) {
-                    numOfMHPQueries++;
-                    return true;
-                }
-            }
-            else {
-                if (isMultiForkedThread(ts1.getTid())) {
-                    numOfMHPQueries++;
-                    return true;
-                }
-            }
-        }
-    }
-    return false;
+    return index.mayHappenInParallel(getRegionLeader(i1), getRegionLeader(i2));
 }
 
 bool MHP::mayHappenInParallelCache(const llvm::Instruction* i1, const llvm::Instruction* i2) {
@@ -558,22 +586,7 @@ bool MHP::mayHappenInParallel(const llvm::Instruction* i1, const llvm::Instructi
 }
 
 bool MHP::executedByTheSameThread(const llvm::Instruction* i1, const llvm::Instruction* i2) {
-    if(!hasThreadStmtSet(i1) || !hasThreadStmtSet(i2))
-        return true;
-
-    const CxtThreadStmtSet& tsSet1 = getThreadStmtSet(i1);
-    const CxtThreadStmtSet& tsSet2 = getThreadStmtSet(i2);
-    for(CxtThreadStmtSet::const_iterator it1 = tsSet1.begin(), eit1 = tsSet1.end(); it1!=eit1; ++it1) {
-        const CxtThreadStmt& ts1 = *it1;
-        for(CxtThreadStmtSet::const_iterator it2 = tsSet2.begin(), eit2 = tsSet2.end(); it2!=eit2; ++it2) {
-            const CxtThreadStmt& ts2 = *it2;
-            if(ts1.getTid()!=ts2.getTid())
-                return false;
-            else if (isMultiForkedThread(ts1.getTid()))
-                return false;
-        }
-    }
-    return true;
+    return index.executedByTheSameThread(getRegionLeader(i1), getRegionLeader(i2));
 }
 
 void MHP::validateResults() {
@@ -727,7 +740,6 @@ void ForkJoinAnalysis::handleFork(const CxtStmt& cts, NodeID rootTid) {
 /// Handle join
 void ForkJoinAnalysis::handleJoin(const CxtStmt& cts, NodeID rootTid) {
     const CallInst* call = cast<CallInst>(cts.getStmt());
-    const CallStrCxt& curCxt = cts.getContext();
 
     assert(isTDJoin(call));
 
@@ -741,7 +753,7 @@ void ForkJoinAnalysis::handleJoin(const CxtStmt& cts, NodeID rootTid) {
                 joinLoop->getExitBlocks(exitbbs);
                 while(!exitbbs.empty()) {
                     BasicBlock* eb = exitbbs.pop_back_val();
-                    CxtStmt newCts(curCxt,&(eb->front()));
+                    CxtStmt newCts(cts.getCxtID(),&(eb->front()));
                     addDirectlyJoinTID(cts,rootTid);
                     if(isSameSCEV(forkSite,joinSite)) {
                         markCxtStmtFlag(newCts,TDDead);
@@ -765,7 +777,7 @@ void ForkJoinAnalysis::handleJoin(const CxtStmt& cts, NodeID rootTid) {
                 joinLoop->getExitBlocks(exitbbs);
                 while(!exitbbs.empty()) {
                     BasicBlock* eb = exitbbs.pop_back_val();
-                    CxtStmt newCts(curCxt,&(eb->front()));
+                    CxtStmt newCts(cts.getCxtID(),&(eb->front()));
                     markCxtStmtFlag(newCts,cts);
                 }
             }
@@ -836,12 +848,11 @@ void ForkJoinAnalysis::handleRet(const CxtStmt& cts) {
 void ForkJoinAnalysis::handleIntra(const CxtStmt& cts) {
 
     const Instruction* curInst = cts.getStmt();
-    const CallStrCxt& curCxt = cts.getContext();
 
     InstVec nextInsts;
     getNextInsts(curInst,nextInsts);
     for(InstVec::const_iterator nit = nextInsts.begin(), enit = nextInsts.end(); nit!=enit; ++nit) {
-        CxtStmt newCts(curCxt,*nit);
+        CxtStmt newCts(cts.getCxtID(),*nit);
         markCxtStmtFlag(newCts,cts);
     }
 }
@@ -0,0 +1,139 @@
+/*
+ * MHPIndex.cpp
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#include "MTA/MHPIndex.h"
+
+using namespace llvm;
+
+/*!
+ * Start building the index, row 0 is the empty row
+ */
+void MHPIndex::init(u32_t threads, const NodeBS& multiForked) {
+    numOfThreads = threads;
+    numOfWords = (threads + 63) / 64;
+    if (numOfWords == 0)
+        numOfWords = 1;
+    rows.clear();
+    rowIds.clear();
+    stmtTids.clear();
+    stmtRows.clear();
+    entries.clear();
+    instToEntry.clear();
+
+    std::vector<u64_t> row(numOfWords, 0);
+    addRow(row);
+    for (NodeBS::iterator it = multiForked.begin(), eit = multiForked.end(); it != eit; ++it)
+        row[*it / 64] |= 1ULL << (*it % 64);
+    multiForkedRow = addRow(row);
+}
+
+/*!
+ * Add a row, reusing an identical one
+ */
+u32_t MHPIndex::addRow(const std::vector<u64_t>& row) {
+    std::map<std::vector<u64_t>, u32_t>::iterator it = rowIds.find(row);
+    if (it != rowIds.end())
+        return it->second;
+    u32_t id = rows.size() / numOfWords;
+    rows.insert(rows.end(), row.begin(), row.end());
+    rowIds[row] = id;
+    return id;
+}
+
+/*!
+ * Add the thread statements of an instruction
+ */
+void MHPIndex::addInst(const Instruction* inst, const std::vector<std::pair<NodeID, const NodeBS*> >& stmts) {
+    InstEntry entry;
+    entry.firstStmt = stmtTids.size();
+    entry.numOfStmts = stmts.size();
+    entry.singleOwner = NoThread;
+
+    std::vector<u64_t> owners(numOfWords, 0);
+    std::vector<u64_t> unions(numOfWords, 0);
+    std::vector<u64_t> row(numOfWords);
+    for (u32_t i = 0; i < stmts.size(); ++i) {
+        NodeID tid = stmts[i].first;
+        assert(tid < numOfThreads && "thread id out of range");
+        owners[tid / 64] |= 1ULL << (tid % 64);
+
+        std::fill(row.begin(), row.end(), 0);
+        const NodeBS& interleaving = *stmts[i].second;
+        for (NodeBS::iterator it = interleaving.begin(), eit = interleaving.end(); it != eit; ++it) {
+            assert(*it < numOfThreads && "thread id out of range");
+            row[*it / 64] |= 1ULL << (*it % 64);
+        }
+        for (u32_t w = 0; w < numOfWords; ++w)
+            unions[w] |= row[w];
+
+        stmtTids.push_back(tid);
+        stmtRows.push_back(addRow(row));
+
+        if (i == 0)
+            entry.singleOwner = tid;
+        else if (entry.singleOwner != tid)
+            entry.singleOwner = NoThread;
+    }
+    entry.ownerRow = addRow(owners);
+    entry.unionRow = addRow(unions);
+
+    instToEntry[inst] = entries.size();
+    entries.push_back(entry);
+}
+
+/*!
+ * Finish building
+ */
+void MHPIndex::finish() {
+    rowIds.clear();
+}
+
+/*!
+ * Two instructions may happen in parallel if they have statements (t1,l1) and (t2,l2) where
+ * (1) t1 == t2 and t1 is multi-forked, or
+ * (2) t1 != t2 and t1 \in l2 and t2 \in l1.
+ * (1) is an intersection of the owner rows with the multi-forked row.
+ * (2) needs some owner of each to be in the interleaving union of the other before statements are compared.
+ */
+bool MHPIndex::mayHappenInParallel(const Instruction* i1, const Instruction* i2) const {
+    const InstEntry* e1 = getEntry(i1);
+    const InstEntry* e2 = getEntry(i2);
+    if (e1 == NULL || e2 == NULL)
+        return false;
+
+    if (intersects(e1->ownerRow, e2->ownerRow, multiForkedRow))
+        return true;
+
+    if (!intersects(e1->unionRow, e2->ownerRow) || !intersects(e2->unionRow, e1->ownerRow))
+        return false;
+
+    for (u32_t s1 = e1->firstStmt, end1 = e1->firstStmt + e1->numOfStmts; s1 != end1; ++s1) {
+        NodeID t1 = stmtTids[s1];
+        u32_t l1 = stmtRows[s1];
+        if (!intersects(l1, e2->ownerRow))
+            continue;
+        for (u32_t s2 = e2->firstStmt, end2 = e2->firstStmt + e2->numOfStmts; s2 != end2; ++s2) {
+            NodeID t2 = stmtTids[s2];
+            if (t1 != t2 && test(l1, t2) && test(stmtRows[s2], t1))
+                return true;
+        }
+    }
+    return false;
+}
+
+/*!
+ * Instructions without statements are treated as executed by the same thread
+ */
+bool MHPIndex::executedByTheSameThread(const Instruction* i1, const Instruction* i2) const {
+    const InstEntry* e1 = getEntry(i1);
+    const InstEntry* e2 = getEntry(i2);
+    if (e1 == NULL || e2 == NULL)
+        return true;
+
+    if (e1->singleOwner == NoThread || e1->singleOwner != e2->singleOwner)
+        return false;
+    return !test(multiForkedRow, e1->singleOwner);
+}
@@ -0,0 +1,477 @@
+/*
+ * MHPSummary.cpp
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#include "MTA/MHPSummary.h"
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/ToolOutputFile.h>
+#include <algorithm>
+#include <fstream>
+
+using namespace llvm;
+using namespace analysisUtil;
+
+namespace {
+const char* SummaryTag = "MHPSummary";
+const u32_t SummaryVersion = 3;
+/// Longest name accepted when loading, anything longer means a corrupt file
+const u32_t MaxNameLength = 1 << 20;
+
+/// Hash a list of keys independently of their order
+u64_t hashKeys(std::vector<std::string>& keys) {
+    std::sort(keys.begin(), keys.end());
+    u64_t hash = getStableHash("");
+    for (std::vector<std::string>::const_iterator it = keys.begin(), eit = keys.end(); it != eit; ++it) {
+        hash = getStableHash(*it, hash);
+        hash = getStableHash("\n", hash);
+    }
+    return hash;
+}
+
+/// Names are written as "<length>:<name>" so that empty names and names with spaces can be read back
+void writeName(raw_ostream& os, StringRef name) {
+    os << name.size() << ":" << name;
+}
+
+/// Read a name written by writeName, return false if it is malformed
+bool readName(std::istream& is, std::string& name) {
+    u32_t len = 0;
+    if (!(is >> len) || is.get() != ':' || len > MaxNameLength)
+        return false;
+    name.resize(len);
+    return len == 0 || is.read(&name[0], len);
+}
+}
+
+/*!
+ * Constructor
+ */
+MHPSummary::MHPSummary(TCT* t, const ForkJoinAnalysis* f) : tct(t), fja(f), tcg(t->getThreadCallGraph()) {
+    numberInsts();
+    threadSigs.resize(tct->getTCTNodeNum());
+    for (TCT::const_iterator it = tct->begin(), eit = tct->end(); it != eit; ++it)
+        threadSigs[it->first] = computeThreadSignature(it->first);
+    tctHash = computeTCTHash();
+    fjaHash = computeFJAHash();
+}
+
+/*!
+ * Number the instructions of every function
+ */
+void MHPSummary::numberInsts() {
+    Module* module = tcg->getModule();
+    for (Module::const_iterator F = module->begin(), E = module->end(); F != E; ++F) {
+        InstVec& insts = funToInsts[&*F];
+        for (const_inst_iterator II = inst_begin(&*F), EE = inst_end(&*F); II != EE; ++II) {
+            instToIndex[&*II] = insts.size();
+            insts.push_back(&*II);
+        }
+    }
+}
+
+u32_t MHPSummary::getInstIndex(const Instruction* inst) const {
+    InstToIndexMap::const_iterator it = instToIndex.find(inst);
+    assert(it != instToIndex.end() && "instruction not numbered?");
+    return it->second;
+}
+
+/*!
+ * Get an instruction by its key, return NULL if it does not exist
+ */
+const Instruction* MHPSummary::getInst(const std::string& fun, u32_t idx) const {
+    const Function* F = tcg->getModule()->getFunction(fun);
+    if (F == NULL)
+        return NULL;
+    FunToInstsMap::const_iterator it = funToInsts.find(F);
+    if (it == funToInsts.end() || idx >= it->second.size())
+        return NULL;
+    return it->second[idx];
+}
+
+std::string MHPSummary::getInstKey(const Instruction* inst) const {
+    std::string str;
+    raw_string_ostream rawstr(str);
+    writeName(rawstr, inst->getParent()->getParent()->getName());
+    rawstr << " " << getInstIndex(inst);
+    return rawstr.str();
+}
+
+std::string MHPSummary::getCallSiteKey(CallSiteID cs) const {
+    const PTACallGraph::CallSitePair& csPair = tcg->getCallSitePair(cs);
+    std::string str;
+    raw_string_ostream rawstr(str);
+    rawstr << getInstKey(csPair.first.getInstruction()) << " ";
+    writeName(rawstr, csPair.second->getName());
+    return rawstr.str();
+}
+
+std::string MHPSummary::getCxtKey(const CallStrCxt& cxt) const {
+    std::string str;
+    for (CallStrCxt::const_iterator it = cxt.begin(), eit = cxt.end(); it != eit; ++it)
+        str += "[" + getCallSiteKey(*it) + "]";
+    return str;
+}
+
+/*!
+ * Structural hash of a function.
+ * Operands are named by their position instead of their value names, and debug
+ * metadata is ignored, so edits of other functions or of line numbers do not change it.
+ */
+u64_t MHPSummary::getFunctionHash(const Function* fun) {
+    FunToHashMap::const_iterator it = funToHash.find(fun);
+    if (it != funToHash.end())
+        return it->second;
+
+    std::string str;
+    raw_string_ostream rawstr(str);
+    rawstr << fun->getName() << " ";
+    fun->getFunctionType()->print(rawstr);
+
+    DenseMap<const BasicBlock*, u32_t> bbToIndex;
+    for (Function::const_iterator bit = fun->begin(), ebit = fun->end(); bit != ebit; ++bit) {
+        u32_t idx = bbToIndex.size();
+        bbToIndex[&*bit] = idx;
+    }
+
+    for (const_inst_iterator II = inst_begin(fun), EE = inst_end(fun); II != EE; ++II) {
+        const Instruction* inst = &*II;
+        rawstr << "\n" << inst->getOpcodeName() << " ";
+        inst->getType()->print(rawstr);
+        if (const CmpInst* cmp = dyn_cast<CmpInst>(inst))
+            rawstr << " p" << cmp->getPredicate();
+        for (User::const_op_iterator oit = inst->op_begin(), eoit = inst->op_end(); oit != eoit; ++oit) {
+            const Value* op = *oit;
+            rawstr << " ";
+            if (const Instruction* opInst = dyn_cast<Instruction>(op))
+                rawstr << "i" << getInstIndex(opInst);
+            else if (const Argument* arg = dyn_cast<Argument>(op))
+                rawstr << "a" << arg->getArgNo();
+            else if (const BasicBlock* bb = dyn_cast<BasicBlock>(op))
+                rawstr << "b" << bbToIndex[bb];
+            else if (const GlobalValue* gv = dyn_cast<GlobalValue>(op))
+                rawstr << "g" << gv->getName();
+            else if (isa<MetadataAsValue>(op))
+                rawstr << "m";
+            else
+                op->print(rawstr);
+        }
+        if (const PHINode* phi = dyn_cast<PHINode>(inst)) {
+            for (u32_t i = 0; i < phi->getNumIncomingValues(); ++i)
+                rawstr << " b" << bbToIndex[phi->getIncomingBlock(i)];
+        }
+    }
+
+    u64_t hash = getStableHash(rawstr.str());
+    funToHash[fun] = hash;
+    return hash;
+}
+
+/*!
+ * Signature of a thread: the functions reachable from its start routine and
+ * their call edges. Fork and join edges lead to other threads and are excluded.
+ */
+u64_t MHPSummary::computeThreadSignature(NodeID tid) {
+    const CxtThread& ct = tct->getTCTNode(tid)->getCxtThread();
+    const Function* routine = tct->getStartRoutineOfCxtThread(ct);
+
+    std::vector<std::string> keys;
+    TCT::PTACGNodeSet visited;
+    FIFOWorkList<const PTACallGraphNode*> worklist;
+    const PTACallGraphNode* root = tcg->getCallGraphNode(routine);
+    visited.insert(root);
+    worklist.push(root);
+    while (!worklist.empty()) {
+        const PTACallGraphNode* node = worklist.pop();
+        const Function* fun = node->getFunction();
+        std::string str;
+        raw_string_ostream rawstr(str);
+        rawstr << "f " << fun->getName() << " " << getFunctionHash(fun);
+        keys.push_back(rawstr.str());
+
+        for (PTACallGraphNode::const_iterator nit = node->OutEdgeBegin(), neit = node->OutEdgeEnd(); nit != neit; ++nit) {
+            const PTACallGraphEdge* edge = *nit;
+            if (isa<ThreadForkEdge>(edge) || isa<ThreadJoinEdge>(edge))
+                continue;
+            std::string callee = edge->getDstNode()->getFunction()->getName().str();
+            for (PTACallGraphEdge::CallInstSet::const_iterator cit = edge->directCallsBegin(),
+                    ecit = edge->directCallsEnd(); cit != ecit; ++cit)
+                keys.push_back("e " + getInstKey(*cit) + " " + callee);
+            for (PTACallGraphEdge::CallInstSet::const_iterator cit = edge->indirectCallsBegin(),
+                    ecit = edge->indirectCallsEnd(); cit != ecit; ++cit)
+                keys.push_back("e " + getInstKey(*cit) + " " + callee);
+            if (visited.insert(edge->getDstNode()).second)
+                worklist.push(edge->getDstNode());
+        }
+    }
+    return hashKeys(keys);
+}
+
+/*!
+ * Hash of the thread creation tree
+ */
+u64_t MHPSummary::computeTCTHash() const {
+    std::vector<std::string> keys;
+    for (TCT::const_iterator it = tct->begin(), eit = tct->end(); it != eit; ++it) {
+        const TCTNode* node = it->second;
+        const CxtThread& ct = node->getCxtThread();
+        std::string str;
+        raw_string_ostream rawstr(str);
+        rawstr << "t " << it->first << " ";
+        if (tct->hasParentThread(it->first))
+            rawstr << tct->getParentThread(it->first);
+        else
+            rawstr << "-";
+        rawstr << " " << tct->getStartRoutineOfCxtThread(ct)->getName() << " ";
+        if (ct.getThread())
+            rawstr << getInstKey(ct.getThread());
+        else
+            rawstr << "-";
+        rawstr << " " << getCxtKey(ct.getContext()) << " " << node->isInloop() << node->isIncycle() << node->isMultiforked();
+        keys.push_back(rawstr.str());
+    }
+    return hashKeys(keys);
+}
+
+/*!
+ * Hash of the fork/join results used by the interleaving analysis
+ */
+u64_t MHPSummary::computeFJAHash() const {
+    std::vector<std::string> keys;
+    const ForkJoinAnalysis::ThreadPairSet* pairSets[] = {&fja->HBPair, &fja->HPPair, &fja->fullJoin, &fja->partialJoin};
+    const char* pairTags[] = {"hb", "hp", "fj", "pj"};
+    for (u32_t i = 0; i < 4; ++i) {
+        for (ForkJoinAnalysis::ThreadPairSet::const_iterator it = pairSets[i]->begin(), eit = pairSets[i]->end(); it != eit; ++it) {
+            std::string str;
+            raw_string_ostream rawstr(str);
+            rawstr << pairTags[i] << " " << it->first << " " << it->second;
+            keys.push_back(rawstr.str());
+        }
+    }
+    for (ForkJoinAnalysis::CxtStmtToTIDMap::const_iterator it = fja->directJoinMap.begin(), eit = fja->directJoinMap.end(); it != eit; ++it) {
+        std::string str;
+        raw_string_ostream rawstr(str);
+        rawstr << "dj " << getInstKey(it->first.getStmt()) << " " << getCxtKey(it->first.getContext());
+        for (NodeBS::iterator tit = it->second.begin(), etit = it->second.end(); tit != etit; ++tit)
+            rawstr << " " << *tit;
+        keys.push_back(rawstr.str());
+    }
+    for (ForkJoinAnalysis::CxtStmtToLoopMap::const_iterator it = fja->cxtJoinInLoop.begin(), eit = fja->cxtJoinInLoop.end(); it != eit; ++it)
+        keys.push_back("lj " + getInstKey(it->first.getStmt()) + " " + getCxtKey(it->first.getContext()));
+    return hashKeys(keys);
+}
+
+/*!
+ * Read the records of a summary file.
+ * The stream is checked after every field, return false if the file is truncated or malformed.
+ */
+bool MHPSummary::readRecords(std::istream& F) {
+    std::string tag;
+    u32_t version = 0;
+    u64_t hash = 0;
+    F >> tag >> version;
+    if (!F || tag != SummaryTag || version != SummaryVersion)
+        return false;
+    F >> tag >> hash;
+    if (!F || tag != "tct" || hash != tctHash)
+        return false;
+    F >> tag >> hash;
+    if (!F || tag != "fja" || hash != fjaHash)
+        return false;
+    /// records are kept per region leader or per instruction
+    u32_t regions = 0;
+    F >> tag >> regions;
+    if (!F || tag != "regions" || regions != (u32_t)tct->useRegions())
+        return false;
+
+    /// threads with unchanged signatures
+    u32_t num = 0;
+    F >> tag >> num;
+    if (!F || tag != "threads")
+        return false;
+    for (u32_t i = 0; i < num; ++i) {
+        NodeID tid;
+        if (!(F >> tid >> hash))
+            return false;
+        if (tid < threadSigs.size() && threadSigs[tid] == hash)
+            cleanThreads.set(tid);
+    }
+
+    /// resolve call sites, 0 marks a call site which no longer exists
+    std::vector<CallSiteID> callsites;
+    F >> tag >> num;
+    if (!F || tag != "callsites")
+        return false;
+    for (u32_t i = 0; i < num; ++i) {
+        std::string caller, callee;
+        u32_t idx;
+        F >> std::ws;
+        if (!readName(F, caller) || !(F >> idx >> std::ws) || !readName(F, callee))
+            return false;
+        const Instruction* inst = getInst(caller, idx);
+        const Function* calleeFun = tcg->getModule()->getFunction(callee);
+        CallSiteID cs = 0;
+        if (inst && calleeFun && tcg->hasCallSiteID(getLLVMCallSite(inst), calleeFun))
+            cs = tcg->getCallSiteID(getLLVMCallSite(inst), calleeFun);
+        callsites.push_back(cs);
+    }
+
+    NodeBS unresolved;
+    F >> tag >> num;
+    if (!F || tag != "records")
+        return false;
+    for (u32_t i = 0; i < num; ++i) {
+        Record record;
+        std::string fun;
+        u32_t idx, len;
+        bool resolved = true;
+        if (!(F >> record.tid >> std::ws) || !readName(F, fun) || !(F >> idx >> len))
+            return false;
+        for (u32_t j = 0; j < len; ++j) {
+            u32_t cs;
+            if (!(F >> cs))
+                return false;
+            if (cs >= callsites.size() || callsites[cs] == 0)
+                resolved = false;
+            else
+                record.cxt.push_back(callsites[cs]);
+        }
+        if (!(F >> len))
+            return false;
+        for (u32_t j = 0; j < len; ++j) {
+            NodeID t;
+            if (!(F >> t))
+                return false;
+            record.interleav.set(t);
+        }
+        if (!cleanThreads.test(record.tid))
+            continue;
+        record.inst = getInst(fun, idx);
+        if (record.inst == NULL || !resolved) {
+            unresolved.set(record.tid);
+            continue;
+        }
+        records.push_back(record);
+    }
+
+    /// a thread is clean only if all the contexts of its records are resolved
+    cleanThreads.intersectWithComplement(unresolved);
+    return true;
+}
+
+/*!
+ * Load a summary.
+ * Records are kept only for clean threads whose contexts can all be resolved.
+ */
+bool MHPSummary::load(const std::string& filename) {
+    std::ifstream F(filename.c_str());
+    if (!F.is_open())
+        return false;
+
+    /// a truncated or malformed file is rejected as a whole
+    if (!readRecords(F)) {
+        cleanThreads.clear();
+        records.clear();
+        return false;
+    }
+
+    /// a thread is clean only if all its ancestors are clean
+    NodeBS dirty;
+    for (TCT::const_iterator it = tct->begin(), eit = tct->end(); it != eit; ++it) {
+        if (!cleanThreads.test(it->first))
+            dirty.set(it->first);
+    }
+    NodeBS descendants;
+    for (NodeBS::iterator it = cleanThreads.begin(), eit = cleanThreads.end(); it != eit; ++it) {
+        if (tct->getAncestorThread(*it).intersects(dirty))
+            descendants.set(*it);
+    }
+    cleanThreads.intersectWithComplement(descendants);
+
+    RecordVec cleanRecords;
+    for (RecordVec::const_iterator it = records.begin(), eit = records.end(); it != eit; ++it) {
+        if (cleanThreads.test(it->tid))
+            cleanRecords.push_back(*it);
+    }
+    records.swap(cleanRecords);
+    return !cleanThreads.empty();
+}
+
+/*!
+ * Restore the interleavings of clean threads
+ */
+u32_t MHPSummary::restore(ThreadStmtToThreadInterleav& interleav, InstToThreadStmtSetMap& instToTS) const {
+    for (RecordVec::const_iterator it = records.begin(), eit = records.end(); it != eit; ++it) {
+        CxtThreadStmt cts(it->tid, it->cxt, it->inst);
+        interleav[cts] |= it->interleav;
+        instToTS[it->inst].insert(cts);
+    }
+    return records.size();
+}
+
+/*!
+ * Write the results of the current program
+ */
+void MHPSummary::save(const std::string& filename, const ThreadStmtToThreadInterleav& interleav,
+                      const InstToThreadStmtSetMap& instToTS) {
+    std::error_code err;
+    tool_output_file F(filename.c_str(), err, sys::fs::F_None);
+    if (err) {
+        errs() << "Failed to write MHP summary " << filename << ": " << err.message() << "\n";
+        F.os().clear_error();
+        return;
+    }
+    raw_fd_ostream& os = F.os();
+
+    os << SummaryTag << " " << SummaryVersion << "\n";
+    os << "tct " << tctHash << "\n";
+    os << "fja " << fjaHash << "\n";
+    os << "regions " << (u32_t)tct->useRegions() << "\n";
+    os << "threads " << threadSigs.size() << "\n";
+    for (NodeID tid = 0; tid < threadSigs.size(); ++tid)
+        os << tid << " " << threadSigs[tid] << "\n";
+
+    /// number call sites of all contexts
+    std::map<CallSiteID, u32_t> csToIndex;
+    std::vector<CallSiteID> callsites;
+    u32_t numOfRecords = 0;
+    for (InstToThreadStmtSetMap::const_iterator it = instToTS.begin(), eit = instToTS.end(); it != eit; ++it) {
+        for (MHP::CxtThreadStmtSet::const_iterator cit = it->second.begin(), ecit = it->second.end(); cit != ecit; ++cit) {
+            const CallStrCxt& cxt = cit->getContext();
+            for (CallStrCxt::const_iterator csit = cxt.begin(), ecsit = cxt.end(); csit != ecsit; ++csit) {
+                if (csToIndex.insert(std::make_pair(*csit, (u32_t)callsites.size())).second)
+                    callsites.push_back(*csit);
+            }
+            numOfRecords++;
+        }
+    }
+    os << "callsites " << callsites.size() << "\n";
+    for (std::vector<CallSiteID>::const_iterator it = callsites.begin(), eit = callsites.end(); it != eit; ++it)
+        os << getCallSiteKey(*it) << "\n";
+
+    os << "records " << numOfRecords << "\n";
+    for (InstToThreadStmtSetMap::const_iterator it = instToTS.begin(), eit = instToTS.end(); it != eit; ++it) {
+        std::string instKey = getInstKey(it->first);
+        for (MHP::CxtThreadStmtSet::const_iterator cit = it->second.begin(), ecit = it->second.end(); cit != ecit; ++cit) {
+            const CallStrCxt& cxt = cit->getContext();
+            os << cit->getTid() << " " << instKey << " " << cxt.size();
+            for (CallStrCxt::const_iterator csit = cxt.begin(), ecsit = cxt.end(); csit != ecsit; ++csit)
+                os << " " << csToIndex[*csit];
+
+            ThreadStmtToThreadInterleav::const_iterator iit = interleav.find(*cit);
+            if (iit == interleav.end()) {
+                os << " 0\n";
+                continue;
+            }
+            os << " " << iit->second.count();
+            for (NodeBS::iterator tit = iit->second.begin(), etit = iit->second.end(); tit != etit; ++tit)
+                os << " " << *tit;
+            os << "\n";
+        }
+    }
+
+    F.os().close();
+    if (!F.os().has_error())
+        F.keep();
+}
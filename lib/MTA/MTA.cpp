@@ -12,15 +12,17 @@
 #include "MTA/MTAStat.h"
 #include "WPA/Andersen.h"
 #include "MTA/FSMPTA.h"
+#include "MTA/AccessPartition.h"
+#include "MTA/RacePairChecker.h"
+#include "MTA/RaceReport.h"
 #include "Util/AnalysisUtil.h"
+#include "Util/PhaseProfiler.h"
 
 #include <llvm/Support/CommandLine.h>   // for llvm command line options
 #include <llvm/IR/InstIterator.h>   // for inst iteration
 
 #include <iostream>
 #include <iomanip>
-#include <fstream>
-#include <regex>
 
 using namespace llvm;
 using namespace analysisUtil;
@@ -31,6 +33,21 @@ static cl::opt<bool> AndersenAnno("tsan-ander", cl::init(false), cl::desc("Add T
 
 static cl::opt<bool> FSAnno("tsan-fs", cl::init(false), cl::desc("Add TSan annotation according to flow-sensitive analysis"));
 
+static cl::opt<unsigned> MTAThreads("mta-threads", cl::init(1), cl::desc("Number of threads used to check race candidate pairs"));
+
+static cl::opt<std::string> RaceReportPath("race-report", cl::init("output.txt"), cl::desc("File to write detected races to"));
+
+static cl::opt<std::string> SortedRaceReportPath("race-report-sorted", cl::init(""),
+        cl::desc("File to also write the detected races to, merged and sorted by location, when the analysis ends"));
+
+static cl::opt<RaceReport::Format> RaceReportFormat("race-report-format", cl::init(RaceReport::Text),
+        cl::desc("Format of the race report"),
+        cl::values(
+            clEnumValN(RaceReport::Text, "text", "line and file of both accesses on four lines"),
+            clEnumValN(RaceReport::JSONL, "jsonl", "one JSON object per race"),
+            clEnumValN(RaceReport::SARIF, "sarif", "SARIF 2.1.0 log")
+        ));
+
 
 char MTA::ID = 0;
 llvm::ModulePass* MTA::modulePass = NULL;
@@ -43,10 +60,12 @@ MTA::MTA() :
 }
 
 MTA::~MTA() {
+    if (tct)
+        delete tct;
     if (tcg)
         delete tcg;
-    //if (tct)
-    //    delete tct;
+    /// the TCT was the last holder of interned contexts
+    CallStrCxtTable::releaseTable();
 }
 
 /*!
@@ -54,6 +73,7 @@ MTA::~MTA() {
  */
 bool MTA::runOnModule(llvm::Module& module) {
 
+    PhaseScope phase("MTA");
 
     modulePass = this;
 
@@ -110,6 +130,7 @@ bool MTA::runOnModule(llvm::Module& module) {
  * Compute lock sets
  */
 LockAnalysis* MTA::computeLocksets(TCT* tct) {
+    PhaseScope phase("Lockset");
     LockAnalysis* lsa = new LockAnalysis(tct);
     lsa->analyze();
     return lsa;
@@ -130,7 +151,10 @@ MHP* MTA::computeMHP(llvm::Module& module) {
     DBOUT(DMTA, outs() << pasMsg("Build TCT\n"));
 
     DOTIMESTAT(double tctStart = stat->getClk());
-    tct = new TCT(tcg, pta);
+    {
+        PhaseScope phase("TCT build");
+        tct = new TCT(tcg, pta);
+    }
     DOTIMESTAT(double tctEnd = stat->getClk());
     DOTIMESTAT(stat->TCTTime += (tctEnd - tctStart) / TIMEINTERVAL);
 
@@ -146,7 +170,10 @@ MHP* MTA::computeMHP(llvm::Module& module) {
 
     DOTIMESTAT(double mhpStart = stat->getClk());
     MHP* mhp = new MHP(tct);
-    mhp->analyze();
+    {
+        PhaseScope phase("MHP");
+        mhp->analyze();
+    }
     DOTIMESTAT(double mhpEnd = stat->getClk());
     DOTIMESTAT(stat->MHPTime += (mhpEnd - mhpStart) / TIMEINTERVAL);
 
@@ -199,61 +226,6 @@ void MTA::detect(llvm::Module& module) {
     outs() << "HP needcheck: " << needcheckinst.size() << "\n";
 }
 
-bool hasDataRace(InstructionPair &pair, llvm::Module& module, MHP *mhp, LockAnalysis *lsa){
-    //check alias
-    PointerAnalysis* pta = AndersenWaveDiff::createAndersenWaveDiff(module);
-    bool alias = false;
-    if (const StoreInst *p1 = dyn_cast<StoreInst>(pair.getInst1())){
-        if (const StoreInst *p2 = dyn_cast<StoreInst>(pair.getInst2())){
-            AliasResult results = pta->alias(p1->getPointerOperand(),p2->getPointerOperand());
-            pair.setAlias(results);
-            alias = (results == MayAlias || results == MustAlias || results == PartialAlias);
-        } else if (const LoadInst *p2 = dyn_cast<LoadInst>(pair.getInst2())) {
-            AliasResult results = pta->alias(p1->getPointerOperand(),p2->getPointerOperand());
-            pair.setAlias(results);
-            alias = (results == MayAlias || results == MustAlias || results == PartialAlias);
-        }
-    } else if (const LoadInst *p1 = dyn_cast<LoadInst>(pair.getInst1())){
-        if (const LoadInst *p2 = dyn_cast<LoadInst>(pair.getInst2())){
-            AliasResult results = pta->alias(p1->getPointerOperand(),p2->getPointerOperand());
-            pair.setAlias(results);
-            alias = (results == MayAlias || results == MustAlias || results == PartialAlias);
-        } else if (const StoreInst *p2 = dyn_cast<StoreInst>(pair.getInst2())){
-            AliasResult results = pta->alias(p1->getPointerOperand(),p2->getPointerOperand());
-            pair.setAlias(results);
-            alias = (results == MayAlias || results == MustAlias || results == PartialAlias);
-        }
-    }
-    if (!alias) return false;
-    //check mhp
-    if (!mhp->mayHappenInParallel(pair.getInst1(), pair.getInst2())) return false;
-    //check lock
-    return (!lsa->isProtectedByCommonLock(pair.getInst1(),pair.getInst2()));
-}
-
-bool isShared(const llvm::Value *val, llvm::Module& module){
-    PointerAnalysis* pta = AndersenWaveDiff::createAndersenWaveDiff(module);
-    PAG* pag = pta->getPAG();
-    const PointsTo& target = pta->getPts(pag->getValueNode(val));
-    for (PointsTo::iterator it = target.begin(), eit = target.end();
-            it != eit; ++it) {
-        const MemObj *obj = pag->getObject(*it);
-        if (obj->isGlobalObj() || obj->isStaticObj() || obj->isHeap()){
-            return true;
-        }
-    }
-    return false;
-}
-
-bool isShared(const Instruction *loc, llvm::Module& module){
-    if (const StoreInst *p1 = dyn_cast<StoreInst>(loc)){
-        return isShared(p1->getPointerOperand(), module);
-    } else if (const LoadInst *p1 = dyn_cast<LoadInst>(loc)){
-        return isShared(p1->getPointerOperand(), module);
-    }
-    return false;
-}
-
 bool isSite(const Instruction *inst){
     llvm::CallSite cs(const_cast<llvm::Instruction*>(inst));
     return (analysisUtil::isStaticExtCall(cs) || analysisUtil::isHeapAllocExtCallViaRet(cs));
@@ -261,80 +233,29 @@ bool isSite(const Instruction *inst){
 
 void MTA::pairAnalysis(llvm::Module& module, MHP *mhp, LockAnalysis *lsa){
     std::cout << " --- Running pair analysis ---\n";
+    PhaseScope phase("Pair checking");
 
-    std::set<const Instruction *> instructions;
-    std::vector<InstructionPair> pairs;
+    // bucket accesses by shared objects, so that only aliasing pairs with at least one write are checked
+    AccessPartitioning partition(mhp->getTCT()->getPTA());
+    partition.collectAccesses(module);
+    partition.run();
 
-    for (Module::iterator F = module.begin(), E = module.end(); F != E; ++F) {
-        for (inst_iterator II = inst_begin(&*F), E = inst_end(&*F); II != E; ++II) {
-            const Instruction *inst = &*II;
-            if (const StoreInst *st = dyn_cast<StoreInst>(inst)) {
-                instructions.insert(st);
-            }
+    // races are written once per pair of source lines as soon as they are confirmed
+    RaceReport report(&partition, RaceReportPath, RaceReportFormat, SortedRaceReportPath);
 
-            else if (const LoadInst *ld = dyn_cast<LoadInst>(inst)) {
-                instructions.insert(ld);
-            }
-        }
-    }
-    int total = instructions.size();
-    int count = 0;
-    // pair up all instructions (NC2) pairs and add to pair vector if they contain data race
-    for (auto it = instructions.cbegin(); it != instructions.cend();){   
-        // if this instruction is not global/heap/static then skip
-        ++count;
-        if (count%50==0){
-            std::cout << "Analysing... ";
-            std::cout << int((double(count)/total)*100) << " %\r";    
-            std::cout.flush();
-        }
-        
-        if (!isShared(*it,module)) {
-            ++it;
-            continue;
-        }
-        for (auto it2 = ++it; it2 != instructions.cend(); ++it2){        
-            InstructionPair pair = InstructionPair(*it,*it2);  
-            if (hasDataRace(pair, module,mhp,lsa)){
-                pairs.push_back(pair);
-            }
-        }
-    }
-    
-    instructions.clear();
+    // check candidate pairs in parallel, only read-only queries of MHP and lockset analysis are used
+    RacePairChecker checker(&partition, mhp, lsa, MTAThreads);
+    checker.setReport(&report);
+    RacePairChecker::AccessPairVec racyPairs;
+    checker.check(racyPairs);
+    report.finish();
+
+    DBOUT(DMTA, partition.print());
+    DBOUT(DMTA, outs() << "No. of candidate pairs: \t" << checker.numOfCandidatePairs << "\n");
+    DBOUT(DMTA, outs() << "No. of stolen chunks: \t" << checker.numOfStolenChunks << "\n");
+    DBOUT(DMTA, outs() << "No. of reported races: \t" << report.getNumOfRaces() << "\n");
+    DBOUT(DMTA, outs() << "No. of duplicated races: \t" << report.getNumOfDuplicates() << "\n");
 
-    // remove empty instructions
-    // write to txt file
-    std::ofstream output;
-    output.open("output.txt");
-    /*
-    separate error message into
-    line1
-    filename1
-    line2
-    filename2
-    for the plugin
-    */
-    std::string s1;
-    std::string s2;
-    std::regex line("ln: (\\d+)");
-    std::regex file("fl: (.*)");
-    std::smatch match;
-    for (auto it = pairs.cbegin(); it != pairs.cend(); ++it){
-        s1 = getSourceLoc(it->getInst1());
-        s2 = getSourceLoc(it->getInst2());
-        if (s1.empty() || s2.empty()) continue;
-        if (std::regex_search(s1, match, line))
-            output << match[1] << std::endl;
-        if (std::regex_search(s1, match, file))
-            output << match[1] << std::endl;
-        if (std::regex_search(s2, match, line))
-            output << match[1] << std::endl;
-        if (std::regex_search(s2, match, file))
-            output << match[1] << std::endl;
-    }
-    output.close();
     //need to also remove paairs that are a local variable. need to go into mem, and check.
 
 }
-
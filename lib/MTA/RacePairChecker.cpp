@@ -0,0 +1,188 @@
+/*
+ * RacePairChecker.cpp
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#include "MTA/RacePairChecker.h"
+#include "MTA/MHP.h"
+#include "MTA/LockAnalysis.h"
+#include "MTA/RaceReport.h"
+
+#include <algorithm>
+#include <thread>
+#include <iostream>
+
+using namespace llvm;
+
+
+/*!
+ * Constructor
+ */
+RacePairChecker::RacePairChecker(const AccessPartitioning* p, MHP* m, LockAnalysis* l, u32_t threads) :
+    numOfCandidatePairs(0), numOfStolenChunks(0), partition(p), mhp(m), lsa(l), report(NULL),
+    numOfThreads(threads == 0 ? 1 : threads), numOfDoneAccesses(0) {
+    ranges = new WorkRange[numOfThreads];
+    results.resize(numOfThreads);
+}
+
+/*!
+ * Destructor
+ */
+RacePairChecker::~RacePairChecker() {
+    delete[] ranges;
+}
+
+/*!
+ * Check all candidate pairs on numOfThreads workers
+ */
+void RacePairChecker::check(AccessPairVec& racyPairs) {
+    u32_t total = partition->getNumOfAccesses();
+
+    /// initial sharding: contiguous and equally sized ranges
+    u32_t shard = total / numOfThreads;
+    for (u32_t i = 0; i < numOfThreads; ++i) {
+        ranges[i].begin = i * shard;
+        ranges[i].end = (i + 1 == numOfThreads) ? total : (i + 1) * shard;
+    }
+
+    if (numOfThreads == 1) {
+        runWorker(0);
+    }
+    else {
+        std::vector<std::thread> workers;
+        for (u32_t i = 0; i < numOfThreads; ++i)
+            workers.push_back(std::thread(&RacePairChecker::runWorker, this, i));
+        for (u32_t i = 0; i < numOfThreads; ++i)
+            workers[i].join();
+    }
+
+    /// merge per-worker results
+    for (u32_t i = 0; i < numOfThreads; ++i) {
+        const WorkerResult& res = results[i];
+        racyPairs.insert(racyPairs.end(), res.racyPairs.begin(), res.racyPairs.end());
+        numOfCandidatePairs += res.numOfCandidatePairs;
+        numOfStolenChunks += res.numOfStolenChunks;
+        mhp->numOfTotalQueries += res.numOfMHPQueries;
+        mhp->numOfMHPQueries += res.numOfMHPPairs;
+        lsa->numOfTotalQueries += res.numOfLockQueries;
+        lsa->numOfLockedQueries += res.numOfLockedPairs;
+    }
+    std::sort(racyPairs.begin(), racyPairs.end());
+}
+
+/*!
+ * Process the own range chunk by chunk, then steal from others until no work is left
+ */
+void RacePairChecker::runWorker(u32_t wid) {
+    WorkerResult& res = results[wid];
+    NodeBS partners;
+    AccessID begin, end;
+    while (true) {
+        if (!popChunk(wid, begin, end)) {
+            if (steal(wid))
+                continue;
+            break;
+        }
+        for (AccessID id = begin; id != end; ++id)
+            checkAccess(id, partners, res);
+        u32_t done = numOfDoneAccesses.fetch_add(end - begin) + (end - begin);
+        if (wid == 0)
+            reportProgress(done);
+    }
+}
+
+/*!
+ * Take at most ChunkSize accesses from the front of worker wid's range
+ */
+bool RacePairChecker::popChunk(u32_t wid, AccessID& begin, AccessID& end) {
+    WorkRange& range = ranges[wid];
+    std::lock_guard<std::mutex> guard(range.mtx);
+    if (range.begin == range.end)
+        return false;
+    begin = range.begin;
+    end = std::min(range.end, range.begin + ChunkSize);
+    range.begin = end;
+    return true;
+}
+
+/*!
+ * Steal the back half of the largest remaining range.
+ * Only one lock is held at a time, so stealing never deadlocks.
+ * Return false if no range is worth stealing, i.e., all work is (almost) done.
+ */
+bool RacePairChecker::steal(u32_t wid) {
+    u32_t victim = numOfThreads;
+    u32_t largest = 0;
+    for (u32_t i = 0; i < numOfThreads; ++i) {
+        if (i == wid)
+            continue;
+        std::lock_guard<std::mutex> guard(ranges[i].mtx);
+        u32_t size = ranges[i].end - ranges[i].begin;
+        if (size > largest) {
+            largest = size;
+            victim = i;
+        }
+    }
+    if (victim == numOfThreads)
+        return false;
+
+    AccessID begin, end;
+    {
+        WorkRange& range = ranges[victim];
+        std::lock_guard<std::mutex> guard(range.mtx);
+        u32_t size = range.end - range.begin;
+        if (size == 0)
+            return true;	/// the victim finished in the meantime, try again
+        end = range.end;
+        begin = (size <= ChunkSize) ? range.begin : range.end - size / 2;
+        range.end = begin;
+    }
+    {
+        WorkRange& range = ranges[wid];
+        std::lock_guard<std::mutex> guard(range.mtx);
+        range.begin = begin;
+        range.end = end;
+    }
+    results[wid].numOfStolenChunks++;
+    return true;
+}
+
+/*!
+ * Check candidate pairs of an access.
+ * Candidates share an abstract object, so they already alias;
+ * a pair is racy if it may happen in parallel and is not protected by a common lock.
+ */
+void RacePairChecker::checkAccess(AccessID id, NodeBS& partners, WorkerResult& res) const {
+    partition->getCandidatePartners(id, partners);
+    const Instruction* i1 = partition->getInstruction(id);
+    for (NodeBS::iterator it = partners.begin(), eit = partners.end(); it != eit; ++it) {
+        const Instruction* i2 = partition->getInstruction(*it);
+        res.numOfCandidatePairs++;
+
+        res.numOfMHPQueries++;
+        if (!mhp->mayHappenInParallelReadOnly(i1, i2))
+            continue;
+        res.numOfMHPPairs++;
+
+        res.numOfLockQueries++;
+        if (lsa->isProtectedByCommonLockReadOnly(i1, i2)) {
+            res.numOfLockedPairs++;
+            continue;
+        }
+        if (report)
+            report->addRace(id, *it);
+        else
+            res.racyPairs.push_back(std::make_pair(id, *it));
+    }
+}
+
+/*!
+ * Print the percentage of processed accesses
+ */
+void RacePairChecker::reportProgress(u32_t done) const {
+    u32_t total = partition->getNumOfAccesses();
+    std::cout << "Analysing... ";
+    std::cout << int((double(done) / total) * 100) << " %\r";
+    std::cout.flush();
+}
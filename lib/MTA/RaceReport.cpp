@@ -0,0 +1,290 @@
+/*
+ * RaceReport.cpp
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#include "MTA/RaceReport.h"
+#include "Util/AnalysisUtil.h"
+#include <llvm/IR/DebugInfoMetadata.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/Format.h>
+#include <algorithm>
+
+using namespace llvm;
+
+
+/*!
+ * Constructor
+ */
+RaceReport::RaceReport(const AccessPartitioning* p, const std::string& path, Format f, const std::string& sorted) :
+    partition(p), format(f), os(NULL), sortedPath(sorted), numOfRaces(0), numOfDuplicates(0) {
+    std::error_code err;
+    os = new raw_fd_ostream(path.c_str(), err, sys::fs::F_Text);
+    if (err) {
+        errs() << "Failed to open race report " << path << ": " << err.message() << "\n";
+        delete os;
+        os = NULL;
+    }
+
+    /// LocID 0 is reserved for accesses without debug information
+    locs.push_back(SourceLoc("", 0));
+    buildLocTable();
+
+    if (os) {
+        writeHeader(*os);
+        os->flush();
+    }
+}
+
+/*!
+ * Destructor
+ */
+RaceReport::~RaceReport() {
+    finish();
+}
+
+/*!
+ * Look up the source locations of all accesses
+ */
+void RaceReport::buildLocTable() {
+    accessLocs.resize(partition->getNumOfAccesses());
+    for (AccessID id = 0, e = partition->getNumOfAccesses(); id != e; ++id)
+        accessLocs[id] = getLocOfInst(partition->getInstruction(id));
+}
+
+/*!
+ * Intern the source location of an instruction
+ */
+RaceReport::LocID RaceReport::getLocOfInst(const Instruction* inst) {
+    const DILocation* loc = inst->getDebugLoc();
+    if (loc == NULL)
+        return 0;
+
+    std::pair<std::string, u32_t> key(loc->getFilename().str(), loc->getLine());
+    std::pair<LocToIDMap::iterator, bool> res = locToID.insert(std::make_pair(key, (LocID)locs.size()));
+    if (res.second)
+        locs.push_back(SourceLoc(key.first, key.second));
+    return res.first->second;
+}
+
+/*!
+ * Report a racy pair.
+ * Locations are ordered so that a pair of lines is reported once, whatever the order of the accesses.
+ * The first race of a pair of lines is written and flushed at once. If a sorted report is
+ * requested, a duplicate replaces the merged race if it is preferred, so that the sorted
+ * report does not depend on arrival order.
+ */
+bool RaceReport::addRace(AccessID id1, AccessID id2) {
+    LocID loc1 = accessLocs[id1];
+    LocID loc2 = accessLocs[id2];
+    if (loc1 == 0 || loc2 == 0)
+        return false;
+
+    bool write1 = partition->isWrite(id1);
+    bool write2 = partition->isWrite(id2);
+    if (lessLoc(loc2, loc1)) {
+        std::swap(loc1, loc2);
+        std::swap(id1, id2);
+        std::swap(write1, write2);
+    }
+    RaceRecord race(loc1, id1, write1, loc2, id2, write2);
+
+    std::lock_guard<std::mutex> guard(mtx);
+    std::pair<LocPairToRaceMap::iterator, bool> res =
+        raceOfLocs.insert(std::make_pair(std::make_pair(loc1, loc2), (u32_t)races.size()));
+    if (!res.second) {
+        numOfDuplicates++;
+        if (!sortedPath.empty()) {
+            RaceRecord& kept = races[res.first->second];
+            if (race.isPreferredTo(kept))
+                kept = race;
+        }
+        return false;
+    }
+    if (os) {
+        writeRace(*os, numOfRaces, race);
+        os->flush();
+    }
+    numOfRaces++;
+    if (!sortedPath.empty())
+        races.push_back(race);
+    return true;
+}
+
+/*!
+ * Prefer a write-write race, then the smallest pair of access IDs.
+ * This is a total order on the races between the same lines.
+ */
+bool RaceReport::RaceRecord::isPreferredTo(const RaceRecord& rhs) const {
+    bool ww = write1 && write2;
+    bool rhsWW = rhs.write1 && rhs.write2;
+    if (ww != rhsWW)
+        return ww;
+    AccessID lo = std::min(id1, id2), hi = std::max(id1, id2);
+    AccessID rhsLo = std::min(rhs.id1, rhs.id2), rhsHi = std::max(rhs.id1, rhs.id2);
+    if (lo != rhsLo)
+        return lo < rhsLo;
+    if (hi != rhsHi)
+        return hi < rhsHi;
+    /// same accesses on the same line, order them by the first one
+    return id1 < rhs.id1;
+}
+
+/*!
+ * Write the header of a report
+ */
+void RaceReport::writeHeader(raw_ostream& out) {
+    if (format == SARIF) {
+        out << "{\"$schema\":\"https://json.schemastore.org/sarif-2.1.0.json\",\"version\":\"2.1.0\","
+            << "\"runs\":[{\"tool\":{\"driver\":{\"name\":\"SVF-MTA\",\"rules\":[{\"id\":\"DataRace\","
+            << "\"shortDescription\":{\"text\":\"Data race\"}}]}},\"results\":[\n";
+    }
+}
+
+/*!
+ * Write the trailer of a report
+ */
+void RaceReport::writeTrailer(raw_ostream& out) {
+    if (format == SARIF)
+        out << "\n]}]}\n";
+}
+
+/*!
+ * Kind of a race
+ */
+const char* RaceReport::getKind(bool write1, bool write2) {
+    if (write1 && write2)
+        return "write-write";
+    if (write1 || write2)
+        return "read-write";
+    return "read-read";
+}
+
+/*!
+ * Write one race
+ */
+void RaceReport::writeRace(raw_ostream& out, u32_t index, const RaceRecord& race) {
+    const SourceLoc& loc1 = locs[race.loc1];
+    const SourceLoc& loc2 = locs[race.loc2];
+    u64_t id = getStableID(loc1, loc2);
+    const char* kind = getKind(race.write1, race.write2);
+
+    switch (format) {
+    case Text: {
+        out << loc1.line << "\n" << loc1.file << "\n" << loc2.line << "\n" << loc2.file << "\n";
+        break;
+    }
+    case JSONL: {
+        out << "{\"id\":\"" << format_hex_no_prefix(id, 16) << "\",\"kind\":\"" << kind << "\","
+            << "\"first\":{\"file\":";
+        writeJSONString(out, loc1.file);
+        out << ",\"line\":" << loc1.line << ",\"write\":" << (race.write1 ? "true" : "false") << "},"
+            << "\"second\":{\"file\":";
+        writeJSONString(out, loc2.file);
+        out << ",\"line\":" << loc2.line << ",\"write\":" << (race.write2 ? "true" : "false") << "}}\n";
+        break;
+    }
+    case SARIF: {
+        if (index > 0)
+            out << ",\n";
+        out << "{\"ruleId\":\"DataRace\",\"level\":\"warning\",\"message\":{\"text\":";
+        std::string msg;
+        raw_string_ostream rawstr(msg);
+        rawstr << kind << " race with " << loc2.file << ":" << loc2.line;
+        writeJSONString(out, rawstr.str());
+        out << "},\"partialFingerprints\":{\"raceId\":\"" << format_hex_no_prefix(id, 16) << "\"},"
+            << "\"locations\":[";
+        writeSARIFLocation(out, loc1);
+        out << "],\"relatedLocations\":[";
+        writeSARIFLocation(out, loc2);
+        out << "]}";
+        break;
+    }
+    }
+}
+
+/*!
+ * Write a SARIF physical location
+ */
+void RaceReport::writeSARIFLocation(raw_ostream& out, const SourceLoc& loc) {
+    out << "{\"physicalLocation\":{\"artifactLocation\":{\"uri\":";
+    writeJSONString(out, loc.file);
+    out << "},\"region\":{\"startLine\":" << loc.line << "}}}";
+}
+
+/*!
+ * Write a JSON string literal
+ */
+void RaceReport::writeJSONString(raw_ostream& out, StringRef str) {
+    out << '"';
+    for (StringRef::iterator it = str.begin(), eit = str.end(); it != eit; ++it) {
+        unsigned char c = *it;
+        if (c == '"' || c == '\\')
+            out << '\\' << (char)c;
+        else if (c == '\n')
+            out << "\\n";
+        else if (c == '\t')
+            out << "\\t";
+        else if (c < 0x20)
+            out << "\\u" << format_hex_no_prefix(c, 4);
+        else
+            out << (char)c;
+    }
+    out << '"';
+}
+
+/*!
+ * Stable ID of a race, the hash of its two source locations
+ */
+u64_t RaceReport::getStableID(const SourceLoc& loc1, const SourceLoc& loc2) {
+    std::string str;
+    raw_string_ostream rawstr(str);
+    rawstr << loc1.file << ":" << loc1.line << "|" << loc2.file << ":" << loc2.line;
+    return analysisUtil::getStableHash(rawstr.str());
+}
+
+/*!
+ * Write the trailer and close the report, then write the sorted report if requested
+ */
+void RaceReport::finish() {
+    std::lock_guard<std::mutex> guard(mtx);
+    if (os) {
+        writeTrailer(*os);
+        os->close();
+        delete os;
+        os = NULL;
+    }
+    if (!sortedPath.empty()) {
+        writeSorted(sortedPath);
+        sortedPath.clear();
+    }
+}
+
+/*!
+ * Write the merged races sorted by location to a file
+ */
+void RaceReport::writeSorted(const std::string& path) {
+    std::error_code err;
+    raw_fd_ostream out(path.c_str(), err, sys::fs::F_Text);
+    if (err) {
+        errs() << "Failed to open sorted race report " << path << ": " << err.message() << "\n";
+        return;
+    }
+
+    std::vector<u32_t> order(races.size());
+    for (u32_t i = 0; i < order.size(); ++i)
+        order[i] = i;
+    std::sort(order.begin(), order.end(), [this](u32_t lhs, u32_t rhs) {
+        const RaceRecord& l = races[lhs];
+        const RaceRecord& r = races[rhs];
+        if (l.loc1 != r.loc1)
+            return lessLoc(l.loc1, r.loc1);
+        return lessLoc(l.loc2, r.loc2);
+    });
+
+    writeHeader(out);
+    for (u32_t i = 0; i < order.size(); ++i)
+        writeRace(out, i, races[order[i]]);
+    writeTrailer(out);
+}
@@ -17,6 +17,7 @@ using namespace llvm;
 using namespace analysisUtil;
 
 static cl::opt<bool> TCTDotGraph("dump-tct", cl::init(false), cl::desc("Dump dot graph of Call Graph"));
+static cl::opt<bool> MTARegions("mta-region", cl::init(false), cl::desc("Propagate MHP and lockset facts over sync-free instruction regions (experimental, see tests/scripts/checkmtaregion.sh)"));
 
 /*!
  * An instruction i is in loop
@@ -336,6 +337,8 @@ void TCT::build() {
 
     markRelProcs();
 
+    buildRegions();
+
     collectLoopInfoForJoin();
 
     // the fork site of main function is initialized with NULL.
@@ -404,6 +407,76 @@ void TCT::getNextInsts(const llvm::Instruction* curInst, InstVec& instList) {
     }
 }
 
+/*!
+ * Whether MHP and lock analysis propagate over regions
+ */
+bool TCT::useRegions() const {
+    return MTARegions;
+}
+
+/*!
+ * Thread and lock operations, returns and calls of non-external functions end regions
+ */
+bool TCT::isRegionBoundary(const llvm::Instruction* inst) const {
+    if (isa<ReturnInst>(inst))
+        return true;
+    if (!isa<CallInst>(inst))
+        return false;
+    if (!isExtCall(inst))
+        return true;
+    const ThreadAPI* api = tcg->getThreadAPI();
+    return api->isTDFork(inst) || api->isTDJoin(inst) || api->isTDAcquire(inst) || api->isTDRelease(inst);
+}
+
+/*!
+ * Split every basic block into regions once, so that leaders and ends are looked up by MHP and lock analysis.
+ * Boundaries are regions of their own; an instruction after a boundary leads the next region.
+ */
+void TCT::buildRegions() {
+    if (!useRegions())
+        return;
+    llvm::Module* module = tcg->getModule();
+    for (Module::const_iterator fit = module->begin(), efit = module->end(); fit != efit; ++fit) {
+        for (Function::const_iterator bit = fit->begin(), ebit = fit->end(); bit != ebit; ++bit) {
+            const Instruction* leader = NULL;
+            for (BasicBlock::const_iterator it = bit->begin(), eit = bit->end(); it != eit; ++it) {
+                const Instruction* inst = &*it;
+                if (isRegionBoundary(inst)) {
+                    leader = NULL;
+                    continue;
+                }
+                if (leader == NULL) {
+                    leader = inst;
+                    continue;
+                }
+                instToRegionLeader[inst] = leader;
+                regionLeaderToEnd[leader] = inst;
+            }
+        }
+    }
+}
+
+/*!
+ * The first instruction of the region
+ */
+const llvm::Instruction* TCT::getRegionLeader(const llvm::Instruction* inst) const {
+    InstToInstMap::const_iterator it = instToRegionLeader.find(inst);
+    if (it != instToRegionLeader.end())
+        return it->second;
+    return inst;
+}
+
+/*!
+ * The last instruction of the region
+ */
+const llvm::Instruction* TCT::getRegionEnd(const llvm::Instruction* leader) const {
+    assert(getRegionLeader(leader) == leader && "not a region leader");
+    InstToInstMap::const_iterator it = regionLeaderToEnd.find(leader);
+    if (it != regionLeaderToEnd.end())
+        return it->second;
+    return leader;
+}
+
 /*!
  * Push calling context
  */
@@ -55,6 +55,9 @@ static cl::opt<bool> PTSPrint("print-pts", cl::init(false),
 static cl::opt<bool> PTSAllPrint("print-all-pts", cl::init(false),
                                  cl::desc("Print all points-to set of both top-level and address-taken variables"));
 
+static cl::opt<bool> PtsTextFile("pts-text-file", cl::init(false),
+                                  cl::desc("Store pointer analysis results in the legacy text format"));
+
 static cl::opt<bool> PStat("stat", cl::init(true),
                            cl::desc("Statistic for Pointer analysis"));
 
@@ -133,6 +136,10 @@ void PointerAnalysis::initialize(Module& module) {
     /// whether we have already built PAG
     if(pag == NULL) {
 
+        /// classify external and thread API functions once for all later queries
+        ExtAPI::getExtAPI()->classifyModule(module);
+        ThreadAPI::getThreadAPI()->classifyModule(module);
+
         /// run class hierarchy analysis
         chgraph = new CHGraph();
         chgraph->buildCHG(module);
@@ -298,7 +305,7 @@ void PointerAnalysis::dumpAllTypes()
 /*!
  * Constructor
  */
-BVDataPTAImpl::BVDataPTAImpl(PointerAnalysis::PTATY type) : PointerAnalysis(type) {
+BVDataPTAImpl::BVDataPTAImpl(PointerAnalysis::PTATY type) : PointerAnalysis(type), ptsFile(NULL) {
     if(type == Andersen_WPA || type == AndersenWave_WPA || type == AndersenLCD_WPA) {
         ptD = new PTDataTy();
     }
@@ -324,7 +331,7 @@ BVDataPTAImpl::BVDataPTAImpl(PointerAnalysis::PTATY type) : PointerAnalysis(type
 void BVDataPTAImpl::expandFIObjs(const PointsTo& pts, PointsTo& expandedPts) {
     expandedPts = pts;;
     for(PointsTo::iterator pit = pts.begin(), epit = pts.end(); pit!=epit; ++pit) {
-        if(pag->getBaseObjNode(*pit)==*pit) {
+        if(pag->getBaseObjNode(*pit)==*pit && pag->hasAllFieldsObjNode(*pit)) {
             expandedPts |= pag->getAllFieldsObjNode(*pit);
         }
     }
@@ -346,6 +353,31 @@ void BVDataPTAImpl::writeToFile(const string& filename) {
         return;
     }
 
+    if (!PtsTextFile) {
+        /// the header of the binary format is written last, at the start of the file
+        if (!F.os().supportsSeeking()) {
+            outs() << "  binary points-to file needs a seekable output, use -pts-text-file!\n";
+            return;
+        }
+        writeBinaryPts(F.os());
+    }
+    else {
+        writeTextPts(F.os());
+    }
+
+    // Job finish and close file
+    F.os().close();
+    if (!F.os().has_error()) {
+        outs() << "\n";
+        F.keep();
+        return;
+    }
+}
+
+/*!
+ * Store points-to data and PAG offset nodes in the text format
+ */
+void BVDataPTAImpl::writeTextPts(raw_fd_ostream& os) {
     // Write analysis results to file
     PTDataTy *ptD = getPTDataTy();
     auto &ptsMap = ptD->getPtsMap();
@@ -353,43 +385,54 @@ void BVDataPTAImpl::writeToFile(const string& filename) {
         NodeID var = it->first;
         const PointsTo &pts = getPts(var);
 
-        F.os() << var << " -> { ";
+        os << var << " -> { ";
         if (pts.empty()) {
-            F.os() << " ";
+            os << " ";
         } else {
             for (auto it = pts.begin(), ie = pts.end(); it != ie; ++it) {
-                F.os() << *it << " ";
+                os << *it << " ";
             }
         }
-        F.os() << "}\n";
+        os << "}\n";
     }
 
-    // Write PAG offset nodes to file
-    NodeID firstGepObjNode = 0;
-    for (auto it = pag->begin(), ie = pag->end(); it != ie; ++it) {
-        PAGNode* pagNode = it->second;
-        if (GepObjPN *gepObjPN = dyn_cast<GepObjPN>(pagNode)) {
-            if (firstGepObjNode > gepObjPN->getId()) {
-                firstGepObjNode = gepObjPN->getId();
-            }
-        }
-    }
-    for (NodeID i = firstGepObjNode, e = pag->getTotalNodeNum(); i != e; ++i) {
+    // Write PAG offset nodes to file, all of them as the binary writer does
+    for (NodeID i = 0, e = pag->getTotalNodeNum(); i != e; ++i) {
         GepObjPN *gepObjPN = dyn_cast<GepObjPN>(pag->getPAGNode(i));
         if (gepObjPN) {
-            F.os() << i << " ";
-            F.os() << pag->getBaseObjNode(i) << " ";
-            F.os() << gepObjPN->getLocationSet().getOffset() << "\n";
+            os << i << " ";
+            os << pag->getBaseObjNode(i) << " ";
+            os << gepObjPN->getLocationSet().getOffset() << "\n";
         }
     }
+}
 
-    // Job finish and close file
-    F.os().close();
-    if (!F.os().has_error()) {
-        outs() << "\n";
-        F.keep();
-        return;
+/*!
+ * Store points-to data and PAG offset nodes in the binary format of PointsToFile
+ */
+void BVDataPTAImpl::writeBinaryPts(raw_fd_ostream& os) {
+    PointsToFileWriter writer(os);
+
+    // Write points-to sets in ascending order of vars,
+    // including those still mapped from a previously loaded file
+    NodeSet vars;
+    const PTDataTy::PtsMap& ptsMap = getPTDataTy()->getPtsMap();
+    for (PTDataTy::PtsMapConstIter it = ptsMap.begin(), ie = ptsMap.end(); it != ie; ++it)
+        vars.insert(it->first);
+    if (ptsFile) {
+        for (u32_t i = 0, e = ptsFile->getNumOfVars(); i != e; ++i)
+            vars.insert(ptsFile->getVar(i));
     }
+    for (NodeSet::const_iterator it = vars.begin(), ie = vars.end(); it != ie; ++it)
+        writer.addPts(*it, getPts(*it));
+
+    // Write PAG offset nodes
+    for (NodeID i = 0, e = pag->getTotalNodeNum(); i != e; ++i) {
+        if (GepObjPN *gepObjPN = dyn_cast<GepObjPN>(pag->getPAGNode(i)))
+            writer.addGepObj(i, pag->getBaseObjNode(i), gepObjPN->getLocationSet().getOffset());
+    }
+
+    writer.finish();
 }
 
 /*!
@@ -400,6 +443,9 @@ void BVDataPTAImpl::writeToFile(const string& filename) {
 bool BVDataPTAImpl::readFromFile(const string& filename) {
     outs() << "Loading pointer analysis results from '" << filename << "'...";
 
+    if (PointsToFile::isPointsToFile(filename))
+        return readBinaryPts(filename);
+
     ifstream F(filename.c_str());
     if (!F.is_open()) {
         outs() << "  error opening file for reading!\n";
@@ -462,6 +508,49 @@ bool BVDataPTAImpl::readFromFile(const string& filename) {
     return true;
 }
 
+/*!
+ * Load pointer analysis result from a binary file.
+ * The file stays mapped, points-to sets are decoded when they are queried.
+ * PAG offset nodes are created eagerly as the solver would have done.
+ */
+bool BVDataPTAImpl::readBinaryPts(const string& filename) {
+    PointsToFile* file = PointsToFile::open(filename);
+    if (file == NULL) {
+        outs() << "  invalid points-to file!\n";
+        return false;
+    }
+
+    // Create PAG offset nodes, a stale or corrupt file fails the load
+    for (u32_t i = 0, e = file->getNumOfGepObjs(); i != e; ++i) {
+        NodeID id;
+        NodeID base;
+        Size_t offset;
+        file->getGepObj(i, id, base, offset);
+
+        const MemObj* obj = pag->findPAGNode(base) ? pag->getObject(base) : NULL;
+        if (obj == NULL) {
+            outs() << "  invalid base object " << base << " of gep object " << id << "!\n";
+            delete file;
+            return false;
+        }
+        NodeID n = pag->getGepObjNode(obj, LocationSet(offset));
+        if (n != id) {
+            outs() << "  gep object " << id << " does not match PAG node " << n << "!\n";
+            delete file;
+            return false;
+        }
+    }
+
+    delete ptsFile;
+    ptsFile = file;
+
+    // Update callgraph
+    updateCallGraph(pag->getIndirectCallsites());
+
+    outs() << "\n";
+    return true;
+}
+
 /*!
  * Dump points-to of each pag node
  */
@@ -831,7 +920,7 @@ llvm::AliasResult BVDataPTAImpl::alias(const Value* V1,
  * Return alias results based on our points-to/alias analysis
  */
 llvm::AliasResult BVDataPTAImpl::alias(NodeID node1, NodeID node2) {
-    return alias(getPts(node1),getPts(node2));
+    return alias(getConstPts(node1),getConstPts(node2));
 }
 
 /*!
@@ -0,0 +1,319 @@
+//===- PointsToFile.cpp -- Binary on-disk points-to results ------------------//
+//
+//                     SVF: Static Value-Flow Analysis
+//
+// Copyright (C) <2013-2017>  <Yulei Sui>
+//
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+
+/*
+ * PointsToFile.cpp
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#include "MemoryModel/PointsToFile.h"
+#include <llvm/Support/Endian.h>
+#include <llvm/Support/EndianStream.h>
+#include <llvm/ADT/Twine.h>
+#include <llvm/Support/ErrorHandling.h>
+#include <llvm/Support/LEB128.h>
+#include <cstring>
+#include <fstream>
+
+using namespace llvm;
+using namespace llvm::support;
+using namespace PointsToFileFormat;
+
+namespace {
+const u32_t BitsPerWord = 64;
+}
+
+/*!
+ * Constructor, reserve space for the header which is written last
+ */
+PointsToFileWriter::PointsToFileWriter(raw_fd_ostream& o) : os(o), payloadSize(0) {
+    assert(os.supportsSeeking() && "points-to file output must be seekable");
+    for (u32_t i = 0; i < HeaderSize; ++i)
+        os << '\0';
+}
+
+/*!
+ * Stream out the compressed bitset of a var
+ */
+void PointsToFileWriter::addPts(NodeID var, const PointsTo& pts) {
+    assert((index.empty() || index.back().first < var) && "vars must be added in ascending order");
+    index.push_back(std::make_pair(var, payloadSize));
+
+    /// collect non-zero words
+    std::vector<std::pair<u64_t, u64_t> > words;
+    for (PointsTo::iterator it = pts.begin(), eit = pts.end(); it != eit; ++it) {
+        u64_t wordIdx = *it / BitsPerWord;
+        if (words.empty() || words.back().first != wordIdx)
+            words.push_back(std::make_pair(wordIdx, 0));
+        words.back().second |= (u64_t)1 << (*it % BitsPerWord);
+    }
+
+    endian::Writer<little> writer(os);
+    encodeULEB128(words.size(), os);
+    payloadSize += getULEB128Size(words.size());
+    u64_t prev = 0;
+    for (u32_t i = 0; i < words.size(); ++i) {
+        encodeULEB128(words[i].first - prev, os);
+        payloadSize += getULEB128Size(words[i].first - prev);
+        writer.write<uint64_t>(words[i].second);
+        payloadSize += sizeof(uint64_t);
+        prev = words[i].first;
+    }
+}
+
+/*!
+ * Add a gep object node
+ */
+void PointsToFileWriter::addGepObj(NodeID id, NodeID base, Size_t offset) {
+    gepObjs.push_back(std::make_pair(id, std::make_pair(base, offset)));
+}
+
+/*!
+ * Write the index and gep sections after the payload, then fill in the header
+ */
+void PointsToFileWriter::finish() {
+    endian::Writer<little> writer(os);
+
+    u64_t indexOffset = HeaderSize + payloadSize;
+    for (u32_t i = 0; i < index.size(); ++i) {
+        writer.write<uint32_t>(index[i].first);
+        writer.write<uint32_t>(0);
+        writer.write<uint64_t>(index[i].second);
+    }
+
+    u64_t gepOffset = indexOffset + (u64_t)index.size() * IndexEntrySize;
+    for (u32_t i = 0; i < gepObjs.size(); ++i) {
+        writer.write<uint32_t>(gepObjs[i].first);
+        writer.write<uint32_t>(gepObjs[i].second.first);
+        writer.write<int64_t>(gepObjs[i].second.second);
+    }
+
+    os.seek(0);
+    os.write(Magic, sizeof(Magic));
+    writer.write<uint32_t>(Version);
+    writer.write<uint32_t>(index.size());
+    writer.write<uint32_t>(gepObjs.size());
+    writer.write<uint32_t>(0);
+    writer.write<uint64_t>(indexOffset);
+    writer.write<uint64_t>(gepOffset);
+    writer.write<uint64_t>(HeaderSize);
+}
+
+/*!
+ * Whether a file starts with the magic of the binary format
+ */
+bool PointsToFile::isPointsToFile(const std::string& filename) {
+    std::ifstream F(filename.c_str(), std::ios::binary);
+    char magic[sizeof(Magic)];
+    if (!F.read(magic, sizeof(magic)))
+        return false;
+    return std::memcmp(magic, Magic, sizeof(Magic)) == 0;
+}
+
+/*!
+ * Map a file and check its header, the bounds of its sections and its index.
+ * Payloads are only checked when they are decoded.
+ */
+PointsToFile* PointsToFile::open(const std::string& filename) {
+    ErrorOr<std::unique_ptr<MemoryBuffer> > buf = MemoryBuffer::getFile(filename, -1, false);
+    if (!buf)
+        return NULL;
+
+    const char* start = (*buf)->getBufferStart();
+    u64_t size = (*buf)->getBufferSize();
+    if (size < HeaderSize || std::memcmp(start, Magic, sizeof(Magic)) != 0)
+        return NULL;
+    if (endian::read32le(start + 8) != Version)
+        return NULL;
+
+    /// sections are laid out as header, payload, index, gep; check each bound
+    /// against the size before adding to it so that nothing can wrap around
+    u64_t vars = endian::read32le(start + 12);
+    u64_t geps = endian::read32le(start + 16);
+    u64_t indexOffset = endian::read64le(start + 24);
+    u64_t gepOffset = endian::read64le(start + 32);
+    u64_t payloadOffset = endian::read64le(start + 40);
+    if (payloadOffset < HeaderSize || payloadOffset > indexOffset || indexOffset > size)
+        return NULL;
+    if (vars > (size - indexOffset) / IndexEntrySize)
+        return NULL;
+    if (gepOffset < indexOffset + vars * IndexEntrySize || gepOffset > size)
+        return NULL;
+    if (geps > (size - gepOffset) / GepEntrySize)
+        return NULL;
+
+    /// vars must be strictly ascending and usable as DenseMap keys, payload
+    /// offsets must be ascending and inside the payload section
+    u64_t payloadSize = indexOffset - payloadOffset;
+    const char* index = start + indexOffset;
+    for (u64_t i = 0; i < vars; ++i) {
+        const char* entry = index + i * IndexEntrySize;
+        u64_t offset = endian::read64le(entry + 8);
+        if (offset >= payloadSize)
+            return NULL;
+        NodeID var = endian::read32le(entry);
+        if (var == DenseMapInfo<NodeID>::getEmptyKey() || var == DenseMapInfo<NodeID>::getTombstoneKey())
+            return NULL;
+        if (i > 0) {
+            const char* prev = entry - IndexEntrySize;
+            if (endian::read32le(prev) >= endian::read32le(entry) || endian::read64le(prev + 8) > offset)
+                return NULL;
+        }
+    }
+
+    return new PointsToFile(std::move(*buf));
+}
+
+/*!
+ * Constructor
+ */
+PointsToFile::PointsToFile(std::unique_ptr<MemoryBuffer> buf) : buffer(std::move(buf)) {
+    const char* start = buffer->getBufferStart();
+    numOfVars = endian::read32le(start + 12);
+    numOfGepObjs = endian::read32le(start + 16);
+    index = start + endian::read64le(start + 24);
+    gepObjs = start + endian::read64le(start + 32);
+    payload = start + endian::read64le(start + 40);
+    payloadEnd = index;
+
+    varToSlot.reserve(numOfVars);
+    decoded = new std::atomic<PointsTo*>[numOfVars];
+    for (u32_t i = 0; i < numOfVars; ++i) {
+        varToSlot[getVar(i)] = i;
+        decoded[i].store(NULL);
+    }
+}
+
+/*!
+ * Destructor
+ */
+PointsToFile::~PointsToFile() {
+    for (u32_t i = 0; i < numOfVars; ++i)
+        delete decoded[i].load();
+    delete[] decoded;
+}
+
+/*!
+ * Var of an index slot
+ */
+NodeID PointsToFile::getVar(u32_t slot) const {
+    assert(slot < numOfVars && "slot out of range");
+    return endian::read32le(index + (u64_t)slot * IndexEntrySize);
+}
+
+/*!
+ * Get the points-to set of a var
+ */
+PointsTo& PointsToFile::getPts(NodeID var) {
+    PointsTo* pts = findPts(var);
+    assert(pts && "var not in points-to file");
+    return *pts;
+}
+
+PointsTo* PointsToFile::findPts(NodeID var) {
+    DenseMap<NodeID, u32_t>::const_iterator it = varToSlot.find(var);
+    if (it == varToSlot.end())
+        return NULL;
+    return &getPtsOfSlot(it->second);
+}
+
+/*!
+ * Get the points-to set of an index slot.
+ * Concurrent first accesses may decode the same set twice, only one copy is kept.
+ */
+PointsTo& PointsToFile::getPtsOfSlot(u32_t slot) {
+    PointsTo* pts = decoded[slot].load(std::memory_order_acquire);
+    if (pts)
+        return *pts;
+
+    PointsTo* newPts = new PointsTo();
+    if (!decode(slot, *newPts))
+        report_fatal_error("corrupt payload for var " + Twine(getVar(slot)) + " in points-to file '"
+                           + buffer->getBufferIdentifier() + "'");
+    if (decoded[slot].compare_exchange_strong(pts, newPts, std::memory_order_acq_rel))
+        return *newPts;
+    delete newPts;
+    return *pts;
+}
+
+/*!
+ * Read a ULEB128 value in [p, end), return false if it runs past end or does not fit in 64 bits
+ */
+static bool readULEB128(const uint8_t*& p, const uint8_t* end, u64_t& value) {
+    value = 0;
+    for (u32_t shift = 0; p != end; shift += 7) {
+        uint8_t byte = *p++;
+        if (shift >= 64 || (shift == 63 && (byte & 0x7f) > 1))
+            return false;
+        value |= (u64_t)(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0)
+            return true;
+    }
+    return false;
+}
+
+/*!
+ * Decode the compressed bitset of a slot.
+ * A payload ends where the next one starts (or at the index), every read is
+ * checked against that bound. Return false if the payload is corrupt.
+ */
+bool PointsToFile::decode(u32_t slot, PointsTo& pts) const {
+    const char* entry = index + (u64_t)slot * IndexEntrySize;
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(payload + endian::read64le(entry + 8));
+    const uint8_t* end = reinterpret_cast<const uint8_t*>(slot + 1 < numOfVars
+                         ? payload + endian::read64le(entry + IndexEntrySize + 8) : payloadEnd);
+
+    /// node IDs are 32 bits, so are the bits of the highest word
+    const u64_t MaxWordIdx = ((u64_t)1 << 32) / BitsPerWord;
+
+    u64_t numOfWords = 0;
+    if (!readULEB128(p, end, numOfWords))
+        return false;
+    u64_t wordIdx = 0;
+    for (u64_t i = 0; i < numOfWords; ++i) {
+        u64_t delta = 0;
+        if (!readULEB128(p, end, delta) || delta >= MaxWordIdx - wordIdx)
+            return false;
+        if ((u64_t)(end - p) < sizeof(uint64_t))
+            return false;
+        wordIdx += delta;
+        u64_t word = endian::read64le(p);
+        p += sizeof(uint64_t);
+        for (u32_t bit = 0; word != 0; ++bit, word >>= 1) {
+            if (word & 1)
+                pts.set(wordIdx * BitsPerWord + bit);
+        }
+    }
+    return true;
+}
+
+/*!
+ * Get a gep object node
+ */
+void PointsToFile::getGepObj(u32_t i, NodeID& id, NodeID& base, Size_t& offset) const {
+    assert(i < numOfGepObjs && "gep object out of range");
+    const char* entry = gepObjs + (u64_t)i * GepEntrySize;
+    id = endian::read32le(entry);
+    base = endian::read32le(entry + 4);
+    offset = (int64_t)endian::read64le(entry + 8);
+}
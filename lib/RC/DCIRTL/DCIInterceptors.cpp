@@ -77,6 +77,8 @@ void *__dci_thread_start_func(void *arg) {
     assert(callback);
     void *res = callback(param);
 
+    /// Merge the accesses of this thread before it exits
+    dci->mergeLogs();
     return res;
 }
 
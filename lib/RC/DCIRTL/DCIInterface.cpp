@@ -44,28 +44,21 @@ void __dci_fini() {
 /*
  * DCI function for memory read
  * ksize: n means the bytes of addr. 2^n bytes. e.g 2(4 bytes)
+ * Only accesses of instructions in RC pairs are logged, pairs are checked when logs are merged.
  */
 void __dci_memory_read(void *addr, u16 ksize, unsigned instID) {
-    u16 x_ = DCIMem::getAbsAddr(addr, ksize);
-    dci->lockInfo((unsigned)get_counter());
-    dci->dciinfo[get_counter()]->addReadInst(x_, instID);
-    dci->unlockInfo((unsigned)get_counter());
-    if (dci->isemptyIG(instID))
+    if (!dci->isCandidate(instID))
         return;
-    dci->checkReadPair(x_, instID);
+    dci->logAccess(DCIMem::getAbsAddr(addr, ksize), instID, false);
 }
 
 /*
  * DCI function for memory write
  */
 void __dci_memory_write(void *addr, u16 ksize, unsigned instID) {
-    u16 x_ = DCIMem::getAbsAddr(addr, ksize);
-    dci->lockInfo((unsigned)get_counter());
-    dci->dciinfo[get_counter()]->addWriteInst(x_, instID);
-    dci->unlockInfo((unsigned)get_counter());
-    if (dci->isemptyIG(instID))
+    if (!dci->isCandidate(instID))
         return;
-    dci->checkWritePair(x_, instID);
+    dci->logAccess(DCIMem::getAbsAddr(addr, ksize), instID, true);
 }
 
 /// DCI instrumentation interfaces for memory intrinsic
@@ -8,6 +8,9 @@
 #include "DCIRTL.h"
 #include "DCIInterceptors.h"
 
+#include <algorithm>
+#include <vector>
+
 
 namespace __dci {
 
@@ -36,16 +39,57 @@ void Initialize(unsigned instr_num) {
  * Finalize function
  */
 void Finalize() {
+    dci->mergeLogs();
     CollectPairs();
 }
 
+/*
+ * Merge the logged accesses of all threads.
+ * All accesses of the batch are added to the instruction maps before any of them is
+ * checked. The maps are cumulative, so this finds the same pairs as checking every
+ * access when it happens.
+ */
+void DCIInfo::mergeLogs() {
+    BlockingMutexLock l(&mtx_merge);
+
+    u32 heads[MAX_THREAD_NUM];
+    for (unsigned t = 0; t < MAX_THREAD_NUM; t++) {
+        DCIMem* info = dciinfo[t];
+        if (info == NULL)
+            continue;
+        heads[t] = atomic_load(&info->head, memory_order_acquire);
+        for (u32 i = atomic_load(&info->tail, memory_order_relaxed); i != heads[t]; i++) {
+            const DCIMem::LogEntry& e = info->log[i % DCIMem::LogSize];
+            if (e.write)
+                info->addWriteInst(e.addr, e.instID);
+            else
+                info->addReadInst(e.addr, e.instID);
+        }
+    }
+
+    for (unsigned t = 0; t < MAX_THREAD_NUM; t++) {
+        DCIMem* info = dciinfo[t];
+        if (info == NULL)
+            continue;
+        for (u32 i = atomic_load(&info->tail, memory_order_relaxed); i != heads[t]; i++) {
+            const DCIMem::LogEntry& e = info->log[i % DCIMem::LogSize];
+            if (isemptyIG(e.instID))
+                continue;
+            if (e.write)
+                checkWritePair(e.addr, e.instID, t);
+            else
+                checkReadPair(e.addr, e.instID, t);
+        }
+        atomic_store(&info->tail, heads[t], memory_order_release);
+    }
+}
+
 /*
  * Initialize pair information. Store all RC pairs into instToGroup
  */
 void InitializePairInfo() {
 
     dci = new DCIInfo();
-    dci->pairs.clear();
     dci->instToGroup.clear();
 
     FILE *pfile;
@@ -54,17 +98,31 @@ void InitializePairInfo() {
             printf("Can't open RC.pairs\n");
         }
     }
+    u64 numOfPairs = 0;
+    unsigned maxID = 0;
     if (pfile!=NULL) {
         unsigned a, b;
         while(!feof(pfile)) {
             if (EOF == fscanf(pfile, "%u %u\n", &a, &b)) {
                 printf("Error reading RC.pairs\n");
+                break;
             }
             dci->instToGroup[a].set(b);
             dci->instToGroup[b].set(a);
+            maxID = std::max(maxID, std::max(a, b));
+            numOfPairs++;
         }
         fclose(pfile);
     }
+
+    /// Refined pairs are a subset of the RC pairs
+    dci->pairs.init(numOfPairs);
+
+    dci->numOfCandidateBits = numOfPairs ? maxID + 1 : 0;
+    dci->candidates = new u64[dci->numOfCandidateBits / 64 + 1];
+    memset(dci->candidates, 0, (dci->numOfCandidateBits / 64 + 1) * sizeof(u64));
+    for (std::map<unsigned, InstIDSet>::iterator it = dci->instToGroup.begin(), ei = dci->instToGroup.end(); it != ei; it++)
+        dci->candidates[it->first / 64] |= 1ull << (it->first % 64);
 }
 
 /*
@@ -76,8 +134,15 @@ void CollectPairs() {
         printf("Can't open DCI.pairs\n");
     }
     if (pfile!=NULL) {
+        std::vector<Pair> pairs;
+        for (u64 i = 0; i < dci->pairs.capacity(); i++) {
+            if (dci->pairs.at(i) != PairSet::Empty)
+                pairs.push_back(dci->pairs.at(i));
+        }
+        std::sort(pairs.begin(), pairs.end());
+
         unsigned a,b;
-        for (Pairs::iterator it = dci->pairs.begin(), ei = dci->pairs.end(); it != ei; it++) {
+        for (std::vector<Pair>::iterator it = pairs.begin(), ei = pairs.end(); it != ei; it++) {
 
             Pair pair = *it;
             dci->getPair(a,b,pair);
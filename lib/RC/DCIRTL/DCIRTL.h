@@ -10,6 +10,7 @@
 
 #include <atomic>
 #include <map>
+#include <string.h>
 #include <set>
 #include <thread>
 
@@ -46,7 +47,6 @@ typedef __rtl_common::uptr uptr;
 typedef std::set<uptr> ThrSet;
 typedef u64 Pair;
 typedef RCSparseBitVector<MAX_INSTR_NUM> InstIDSet;
-typedef std::set<Pair> Pairs;
 
 /*
  * Get current thread
@@ -156,20 +156,50 @@ extern EscapeInfo* escapeinfo;
  * DCI memory accesses information
  * 0-13 the 14 bits of real address
  * 14-15 ksize
+ *
+ * Accesses are appended by the owner thread to a preallocated ring without any
+ * lock, and merged into write2inst/read2inst by DCIInfo::mergeLogs in batches.
+ * The instruction maps are only accessed during a merge.
  */
 struct DCIMem {
     typedef std::map<u16, InstIDSet> InstMap;
 
+    /// An access in the log
+    struct LogEntry {
+        u32 instID;
+        u16 addr;
+        u16 write;
+    };
+
+    /// Sizes of the log and of the filter of logged accesses
+    //@{
+    static const u32 LogSize = 4096;
+    static const u32 FilterSize = 4096;
+    //@}
+
     /// Write and Read instructions
     //@{
     InstMap write2inst;
     InstMap read2inst;
     //@}
 
+    /// Access log, head is advanced by the owner and tail by the merger
+    //@{
+    LogEntry log[LogSize];
+    atomic_uint32_t head;
+    atomic_uint32_t tail;
+    //@}
+
+    /// Accesses logged by the owner recently, only accessed by the owner
+    u64 filter[FilterSize];
+
     /// Constructor
     DCIMem() {
         write2inst.clear();
         read2inst.clear();
+        atomic_store(&head, 0, memory_order_relaxed);
+        atomic_store(&tail, 0, memory_order_relaxed);
+        memset(filter, 0, sizeof(filter));
     }
 
     /*!
@@ -179,6 +209,34 @@ struct DCIMem {
         return ((ksize) << 14) | ((u64) addr & 0x3fff);
     }
 
+    /*!
+     * Whether an access was logged recently, remember it otherwise.
+     * The instruction maps are cumulative, so logging an access again adds nothing.
+     */
+    inline bool isLogged(u16 x_, unsigned instID, bool write) {
+        u64 key = (((u64)instID << 17) | ((u64)x_ << 1) | write) + 1;
+        u64& slot = filter[(key * 0x9E3779B97F4A7C15ull) >> 52];
+        if (slot == key)
+            return true;
+        slot = key;
+        return false;
+    }
+
+    /*!
+     * Append an access to the log, return false if the log is full
+     */
+    inline bool append(u16 x_, unsigned instID, bool write) {
+        u32 h = atomic_load(&head, memory_order_relaxed);
+        if (h - atomic_load(&tail, memory_order_acquire) == LogSize)
+            return false;
+        LogEntry& e = log[h % LogSize];
+        e.instID = instID;
+        e.addr = x_;
+        e.write = write;
+        atomic_store(&head, h + 1, memory_order_release);
+        return true;
+    }
+
     /*!
      * Add a read instruction
      */
@@ -194,6 +252,65 @@ struct DCIMem {
     }
 };
 
+/*!
+ * Lock-free open-addressing hash set of pairs.
+ * Its capacity is fixed when it is initialized.
+ */
+class PairSet {
+public:
+    static const Pair Empty = ~0ull;
+
+    PairSet(): slots(NULL), mask(0) {
+    }
+
+    ~PairSet() {
+        delete[] slots;
+    }
+
+    /*!
+     * Allocate space for at least n pairs
+     */
+    void init(u64 n) {
+        u64 cap = 16;
+        while (cap < 2 * n)
+            cap <<= 1;
+        delete[] slots;
+        slots = new atomic_uint64_t[cap];
+        for (u64 i = 0; i < cap; ++i)
+            atomic_store(&slots[i], Empty, memory_order_relaxed);
+        mask = cap - 1;
+    }
+
+    /*!
+     * Insert a pair, return false if it is already in the set
+     */
+    bool insert(Pair pair) {
+        for (u64 i = (pair * 0x9E3779B97F4A7C15ull) & mask, n = 0; n <= mask; i = (i + 1) & mask, ++n) {
+            u64 cur = atomic_load(&slots[i], memory_order_acquire);
+            if (cur == Empty && atomic_compare_exchange_strong(&slots[i], &cur, pair, memory_order_acq_rel))
+                return true;
+            if (cur == pair)
+                return false;
+        }
+        assert(false && "pair set is full");
+        return false;
+    }
+
+    /// Slots, for iteration
+    //@{
+    inline u64 capacity() const {
+        return slots ? mask + 1 : 0;
+    }
+    inline Pair at(u64 i) const {
+        return atomic_load(&slots[i], memory_order_acquire);
+    }
+    //@}
+
+private:
+    atomic_uint64_t* slots;
+    u64 mask;
+};
+
 /*!
  * DCI information
  */
@@ -203,23 +320,25 @@ struct DCIInfo {
     DCIMem *dciinfo[MAX_THREAD_NUM];
 
     /// All pairs
-    Pairs pairs;
+    PairSet pairs;
 
     /// The map is used to record all RaceComb pairs
     /// unsigned is the instruction, InstIDSet is its paired instructions
     std::map<unsigned, InstIDSet> instToGroup;
 
+    /// Bitmap of instructions in any RaceComb pair, fixed after initialization
+    //@{
+    u64* candidates;
+    unsigned numOfCandidateBits;
+    //@}
 
-    /// Mutexes for instructions' paired group
-    /// Multiple instructions share one mutex
-    /// Use id & MAX_INST_MASK to identify it.
-    BlockingMutex mtx_instToGroup[MAX_INSTR_NUM];
-
-    /// Mutex for threads' DCI information
-    BlockingMutex mtx_dciinfo[MAX_THREAD_NUM];
+    /// Mutex for merging the access logs, it guards the instruction maps and instToGroup
+    BlockingMutex mtx_merge;
 
-    /// Mutex for pairs
-    BlockingMutex mtx_pairs;
+    /// Constructor
+    DCIInfo(): candidates(NULL), numOfCandidateBits(0) {
+        memset(dciinfo, 0, sizeof(dciinfo));
+    }
 
     /*!
      * Add a pair(a,b)
@@ -230,9 +349,7 @@ struct DCIInfo {
             pair = (((u64)a) << 32) | ((u64)b);
         else
             pair = (((u64)b) << 32) | ((u64)a);
-        mtx_pairs.Lock();
         pairs.insert(pair);
-        mtx_pairs.Unlock();
     }
 
     /*!
@@ -243,11 +360,33 @@ struct DCIInfo {
         b=pair & 4294967295;
     }
 
+    /*!
+     * Whether an instruction is in any RaceComb pair. Accesses of other instructions are not logged.
+     */
+    inline bool isCandidate(unsigned id) const {
+        return id < numOfCandidateBits && (candidates[id / 64] >> (id % 64)) & 1;
+    }
+
+    /*!
+     * Log an access of the current thread, merge all logs if its log is full
+     */
+    inline void logAccess(u16 x_, unsigned instID, bool write) {
+        DCIMem* info = dciinfo[get_counter()];
+        if (info->isLogged(x_, instID, write))
+            return;
+        while (!info->append(x_, instID, write))
+            mergeLogs();
+    }
+
+    /*!
+     * Merge the logged accesses of all threads and check their pairs
+     */
+    void mergeLogs();
+
     /*!
      * Check if one instruction does not have any paired instructions
      */
     inline bool isemptyIG(unsigned id) {
-        BlockingMutexLock l(&mtx_instToGroup[id&(MAX_INSTR_MASK)]);
         if (instToGroup.find(id) == instToGroup.end()) return true;
         return instToGroup[id].empty();
     }
@@ -256,7 +395,6 @@ struct DCIInfo {
      * Add a paired instruction pid to id's paired group
      */
     inline void setIG(unsigned id, unsigned pid) {
-//        BlockingMutexLock l(&mtx_instToGroup[id&(MAX_INSTR_MASK)]);
         instToGroup[id].set(pid);
     }
 
@@ -264,99 +402,49 @@ struct DCIInfo {
      * Delete a paired instruction pid from id's paired group
      */
     inline void resetIG(unsigned id, unsigned pid) {
-        BlockingMutexLock l(&mtx_instToGroup[id&(MAX_INSTR_MASK)]);
         instToGroup[id].reset(pid);
     }
 
-    /// Lock and unlock for instruction id's paired group
-    //@{
-    inline void lockIG(unsigned id) {
-        mtx_instToGroup[id&(MAX_INSTR_MASK)].Lock();
-    }
-    inline void unlockIG(unsigned id) {
-        mtx_instToGroup[id&(MAX_INSTR_MASK)].Unlock();
-    }
-    //@}
-
-    /// Lock and unlock for thread's DCI information
-    //@{
-    inline void lockInfo(unsigned id) {
-        mtx_dciinfo[id].Lock();
-    }
-    inline void unlockInfo(unsigned id) {
-        mtx_dciinfo[id].Unlock();
-    }
-    //@}
-
     /*!
-     * Check write instruction. Remove the pair if it is visited
+     * Check write instruction of thread thd. Remove the pair if it is visited
      */
-    void checkWritePair(u16 x_, unsigned id) {
-
-        unsigned cur_thd = (unsigned)get_counter();
+    void checkWritePair(u16 x_, unsigned id, unsigned thd) {
 
         InstIDSet temp;
-        for (unsigned i = 0; i < cur_thd; i++) {
-            if (dciinfo[i] == NULL)
-                break;
-            lockInfo(i);
-            temp |= dciinfo[i]->read2inst[x_];
-            temp |= dciinfo[i]->write2inst[x_];
-            unlockInfo(i);
-        }
-
-        for (unsigned i = cur_thd+1; i < MAX_THREAD_NUM; i++) {
-            if (dciinfo[i] == NULL)
-                break;
-            lockInfo(i);
+        for (unsigned i = 0; i < MAX_THREAD_NUM; i++) {
+            if (i == thd || dciinfo[i] == NULL)
+                continue;
             temp |= dciinfo[i]->read2inst[x_];
             temp |= dciinfo[i]->write2inst[x_];
-            unlockInfo(i);
         }
 
-        lockIG(id);
         temp &= instToGroup[id];
-        unlockIG(id);
 
         for (InstIDSet::iterator it = temp.begin(), ei = temp.end(); it != ei; it++) {
             addPair(id,*it);
             resetIG(id,*it);
-            /// Only delete its instToGroup to reduce unnecessary locks.
+            /// Only delete its instToGroup to reduce unnecessary updates.
             /// resetIG(*it,id);
         }
     }
 
     /*!
-     * Check read instruction. Remove the pair if it is visited
+     * Check read instruction of thread thd. Remove the pair if it is visited
      */
-    void checkReadPair(u16 x_, unsigned id) {
-
-        unsigned cur_thd = (unsigned)get_counter();
+    void checkReadPair(u16 x_, unsigned id, unsigned thd) {
 
         InstIDSet temp;
-        for (unsigned i = 0; i < cur_thd; i++) {
-            if (dciinfo[i] == NULL)
-                break;
-            lockInfo(i);
-            temp |= dciinfo[i]->write2inst[x_];
-            unlockInfo(i);
-        }
-
-        for (unsigned i = cur_thd+1; i < MAX_THREAD_NUM; i++) {
-            if (dciinfo[i] == NULL)
-                break;
-            lockInfo(i);
+        for (unsigned i = 0; i < MAX_THREAD_NUM; i++) {
+            if (i == thd || dciinfo[i] == NULL)
+                continue;
             temp |= dciinfo[i]->write2inst[x_];
-            unlockInfo(i);
         }
 
-        lockIG(id);
         temp &= instToGroup[id];
-        unlockIG(id);
         for (InstIDSet::iterator it = temp.begin(), ei = temp.end(); it != ei; it++) {
             addPair(id,*it);
             resetIG(id,*it);
-            /// Only delete its instToGroup to reduce unnecessary locks.
+            /// Only delete its instToGroup to reduce unnecessary updates.
             /// resetIG(*it,id);
         }
     }
@@ -57,6 +57,28 @@ INLINE typename T::Type atomic_fetch_sub(volatile T *a,
     return __sync_fetch_and_add(&a->val_dont_use, -v);
 }
 
+/*!
+ * Atomic fetch and or
+ */
+template<typename T>
+INLINE typename T::Type atomic_fetch_or(volatile T *a,
+                                        typename T::Type v, memory_order mo) {
+    (void)mo;
+    DCHECK(!((uptr)a % sizeof(*a)));
+    return __sync_fetch_and_or(&a->val_dont_use, v);
+}
+
+/*!
+ * Atomic fetch and and
+ */
+template<typename T>
+INLINE typename T::Type atomic_fetch_and(volatile T *a,
+        typename T::Type v, memory_order mo) {
+    (void)mo;
+    DCHECK(!((uptr)a % sizeof(*a)));
+    return __sync_fetch_and_and(&a->val_dont_use, v);
+}
+
 /// Atomic exchange
 //{@
 template<typename T>
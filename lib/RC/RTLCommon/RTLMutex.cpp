@@ -6,6 +6,10 @@
  */
 
 #include "RTLMutex.h"
+#include <time.h>
+#if RTL_LINUX
+#include <linux/futex.h>
+#endif
 
 //using namespace __rtl_common;
 
@@ -83,3 +87,108 @@ void BlockingMutex::CheckLocked() {
     CHECK_NE(MtxUnlocked, atomic_load(m, memory_order_relaxed));
 }
 
+
+/*
+ * Get the monotonic clock in nanoseconds
+ */
+u64 __rtl_common::internal_monotonic_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (u64)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+/*
+ * Parker constructor
+ */
+Parker::Parker() {
+    atomic_store(&state_, 0, memory_order_relaxed);
+#if !RTL_LINUX
+    pthread_mutex_init(&mtx_, NULL);
+    pthread_cond_init(&cond_, NULL);
+#endif
+}
+
+/*
+ * Parker destructor
+ */
+Parker::~Parker() {
+#if !RTL_LINUX
+    pthread_cond_destroy(&cond_);
+    pthread_mutex_destroy(&mtx_);
+#endif
+}
+
+#if RTL_LINUX
+/*
+ * Park on the futex word while it is 0, with a timeout relative to now
+ */
+bool Parker::Park(u64 deadline) {
+    while (atomic_load(&state_, memory_order_acquire) == 0) {
+        u64 now = internal_monotonic_ns();
+        if (now >= deadline)
+            return false;
+        struct timespec ts;
+        ts.tv_sec = (deadline - now) / 1000000000ull;
+        ts.tv_nsec = (deadline - now) % 1000000000ull;
+        u64 retval;
+        asm volatile("mov %5, %%r10;"
+                     "mov %6, %%r8;"
+                     "mov %7, %%r9;"
+                     "syscall" : "=a"(retval) : "a"(__NR_futex), "D"((u64)&state_),
+                     "S"((u64)FUTEX_WAIT_PRIVATE), "d"((u64)0), "r"((u64)&ts), "r"((u64)0),
+                     "r"((u64)0) : "rcx", "r11", "r10", "r8", "r9",
+                     "memory", "cc");
+    }
+    return true;
+}
+
+/*
+ * Set the futex word and wake its waiter
+ */
+void Parker::Unpark() {
+    if (atomic_exchange(&state_, 1, memory_order_release) == 1)
+        return;
+    u64 retval;
+    asm volatile("mov %5, %%r10;"
+                 "mov %6, %%r8;"
+                 "mov %7, %%r9;"
+                 "syscall" : "=a"(retval) : "a"(__NR_futex), "D"((u64)&state_),
+                 "S"((u64)FUTEX_WAKE_PRIVATE), "d"((u64)1), "r"((u64)0), "r"((u64)0),
+                 "r"((u64)0) : "rcx", "r11", "r10", "r8", "r9",
+                 "memory", "cc");
+}
+#else
+/*
+ * Wait on the condition variable while the flag is 0
+ */
+bool Parker::Park(u64 deadline) {
+    bool woken = true;
+    pthread_mutex_lock(&mtx_);
+    while (atomic_load(&state_, memory_order_acquire) == 0) {
+        u64 now = internal_monotonic_ns();
+        if (now >= deadline) {
+            woken = false;
+            break;
+        }
+        /// The condition variable waits on the realtime clock
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        u64 abs = (u64)ts.tv_sec * 1000000000ull + ts.tv_nsec + (deadline - now);
+        ts.tv_sec = abs / 1000000000ull;
+        ts.tv_nsec = abs % 1000000000ull;
+        pthread_cond_timedwait(&cond_, &mtx_, &ts);
+    }
+    pthread_mutex_unlock(&mtx_);
+    return woken;
+}
+
+/*
+ * Set the flag and signal the condition variable
+ */
+void Parker::Unpark() {
+    pthread_mutex_lock(&mtx_);
+    atomic_store(&state_, 1, memory_order_release);
+    pthread_cond_signal(&cond_);
+    pthread_mutex_unlock(&mtx_);
+}
+#endif
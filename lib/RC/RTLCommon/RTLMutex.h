@@ -17,6 +17,9 @@
 #include "RTLAtomic.h"
 #include "RTLInternalDefs.h"
 #include <asm/unistd.h>
+#if !RTL_LINUX
+#include <pthread.h>
+#endif
 
 #define SYSCALL(name) __NR_ ## name
 
@@ -275,6 +278,65 @@ private:
     void operator = (const RWMutex&);
 };
 
+/*!
+ * Get the monotonic clock in nanoseconds
+ */
+u64 internal_monotonic_ns();
+
+/*!
+ * Parking spot of one thread.
+ * Park blocks on a futex word until Unpark is called or a deadline passes;
+ * platforms without futexes use a condition variable.
+ * An Unpark before Park is not lost, Prepare must be called before the next Park.
+ */
+class Parker {
+public:
+    /*!
+     * Constructor
+     */
+    Parker();
+
+    /*!
+     * Destructor
+     */
+    ~Parker();
+
+    /*!
+     * Reset the wakeup flag
+     */
+    void Prepare() {
+        atomic_store(&state_, 0, memory_order_relaxed);
+    }
+
+    /*!
+     * Park until unparked or the monotonic clock reaches deadline (in ns).
+     * Return false on timeout.
+     */
+    bool Park(u64 deadline);
+
+    /*!
+     * Wake the parked thread
+     */
+    void Unpark();
+
+private:
+    atomic_uint32_t state_;
+#if !RTL_LINUX
+    pthread_mutex_t mtx_;
+    pthread_cond_t cond_;
+#endif
+
+    /*!
+     * Constructor
+     */
+    Parker(const Parker&);
+
+    /*!
+     * Overload operator =
+     */
+    void operator=(const Parker&);
+};
+
 /*!
  * Generic scoped lock
  */
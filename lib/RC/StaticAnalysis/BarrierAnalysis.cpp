@@ -111,6 +111,8 @@ void BarrierAnalysis::visitFunction(const Function *F) {
 BarrierAnalysis::FunctionAnalyzerBase::UniversalInst2BarriersMap
 BarrierAnalysis::FunctionAnalyzerBase::universalBarrierSites;
 
+std::mutex BarrierAnalysis::FunctionAnalyzerBase::universalMutex;
+
 
 /*
  * Perform the bottom-up analysis.
@@ -157,7 +157,13 @@ private:
 
         /// Constructor
         FunctionAnalyzerBase(BarrierAnalysis *ba, const llvm::Function *F) :
-                ba(ba), F(F), barrierSites(universalBarrierSites[F]) {
+                ba(ba), F(F), barrierSites(getOrAddBarrierSites(F)) {
+        }
+
+        /// Get the records of F, Functions may be analyzed in parallel
+        static inline Inst2BarriersMap &getOrAddBarrierSites(const llvm::Function *F) {
+            std::lock_guard<std::mutex> guard(universalMutex);
+            return universalBarrierSites[F];
         }
 
         BarrierAnalysis *ba;
@@ -166,6 +172,7 @@ private:
 
         /// Records of the inter-procedural analysis results
         static UniversalInst2BarriersMap universalBarrierSites;
+        static std::mutex universalMutex;
     };
 
     /*!
@@ -6,22 +6,269 @@
  */
 
 #include "InterproceduralAnalysis.h"
+#include <llvm/Support/MathExtras.h>
 
 using namespace llvm;
 using namespace std;
 
 
+/// Memory of ScalarEvolution per Instruction. Its caches are filled lazily by
+/// queries after it is built, so its size cannot be measured when it is added.
+/// It is never evicted and is only built for a few spawn/join Functions.
+static const size_t SeBytesPerInst = 160;
+
+/// Bytes of a node of std::map and std::set besides its value:
+/// parent, left and right links and the color
+static const size_t RbNodeBytes = 4 * sizeof(void*);
+
+
+/*
+ * Bytes of a DenseMap with n entries.
+ * A DenseMap grows its power-of-two bucket array when it is 3/4 full.
+ */
+static size_t getDenseMapBytes(size_t n, size_t bucketBytes) {
+    if (n == 0)
+        return 0;
+    return (size_t) NextPowerOf2(n * 4 / 3) * bucketBytes;
+}
+
+
+/*
+ * Memory of a (post) dominator tree, measured on its nodes:
+ * the nodes, their children vectors and the BasicBlock to node map.
+ */
+static size_t getDomTreeBytes(const DominatorTreeBase<BasicBlock> &dt,
+        const Function *F) {
+    typedef DomTreeNodeBase<BasicBlock> Node;
+    size_t bytes = 0;
+    size_t numOfNodes = 0;
+    for (Function::const_iterator it = F->begin(), ie = F->end(); it != ie; ++it) {
+        const Node *node = dt.getNode(const_cast<BasicBlock*>(&*it));
+        if (node == NULL)
+            continue;
+        numOfNodes++;
+        bytes += sizeof(Node) + node->getChildren().capacity() * sizeof(Node*);
+    }
+    return bytes + getDenseMapBytes(numOfNodes,
+            sizeof(std::pair<BasicBlock*, std::unique_ptr<Node> >));
+}
+
+
+/*
+ * Memory of a dominance frontier, measured on its frontier sets.
+ */
+static size_t getDfBytes(const DomFrontier &df) {
+    size_t bytes = sizeof(DomFrontier);
+    for (DomFrontier::const_iterator it = df.begin(), ie = df.end(); it != ie; ++it)
+        bytes += RbNodeBytes + sizeof(*it)
+                + it->second.size() * (RbNodeBytes + sizeof(BasicBlock*));
+    return bytes;
+}
+
+
+/*
+ * Memory of a Loop and its sub-loops: the Loop, its block vector and
+ * block set, and its sub-loop vector.
+ */
+static size_t getLoopBytes(const Loop *L) {
+    size_t bytes = sizeof(Loop) + L->getNumBlocks() * 2 * sizeof(BasicBlock*)
+            + L->getSubLoops().capacity() * sizeof(Loop*);
+    for (Loop::iterator it = L->begin(), ie = L->end(); it != ie; ++it)
+        bytes += getLoopBytes(*it);
+    return bytes;
+}
+
+
+/*
+ * Memory of a LoopInfo, measured on its loops and its BasicBlock to Loop map.
+ */
+static size_t getLiBytes(const LoopInfo &li) {
+    size_t bytes = sizeof(LoopInfo);
+    size_t numOfBlocks = 0;
+    for (LoopInfo::iterator it = li.begin(), ie = li.end(); it != ie; ++it) {
+        bytes += getLoopBytes(*it);
+        numOfBlocks += (*it)->getNumBlocks();
+    }
+    return bytes + getDenseMapBytes(numOfBlocks, sizeof(std::pair<BasicBlock*, Loop*>));
+}
+
+
+/*
+ * Unpin the Functions of a thread when it exits.
+ */
+FunctionPassPool::RecentFunctions::~RecentFunctions() {
+    lock_guard<recursive_mutex> guard(poolMutex);
+    if (generation != FunctionPassPool::generation)
+        return;
+    for (u32_t i = 0; i < Size; ++i) {
+        if (funcs[i])
+            unpin(funcs[i]);
+    }
+    for (size_t i = 0; i < scoped.size(); ++i)
+        unpin(scoped[i]);
+}
+
+
+/*
+ * Drop the pins taken before the last clear(), the open PinScopes stay open.
+ */
+void FunctionPassPool::RecentFunctions::reset(u32_t gen) {
+    std::fill(funcs, funcs + Size, (const Function*) NULL);
+    next = 0;
+    scoped.clear();
+    generation = gen;
+}
+
+
+/*
+ * Open a scope, Functions queried from now on stay pinned until it ends.
+ */
+FunctionPassPool::PinScope::PinScope() {
+    lock_guard<recursive_mutex> guard(poolMutex);
+    RecentFunctions &recent = recentFunctions;
+    if (recent.generation != generation)
+        recent.reset(generation);
+    recent.depth++;
+    numOfOuterPins = recent.scoped.size();
+}
+
+
+/*
+ * Close a scope and unpin the Functions first queried in it.
+ */
+FunctionPassPool::PinScope::~PinScope() {
+    lock_guard<recursive_mutex> guard(poolMutex);
+    RecentFunctions &recent = recentFunctions;
+    assert(recent.depth > 0 && "PinScope closed twice");
+    recent.depth--;
+    // Pins taken before the last clear() are gone
+    if (recent.generation != generation)
+        return;
+    for (size_t i = numOfOuterPins; i < recent.scoped.size(); ++i)
+        unpin(recent.scoped[i]);
+    recent.scoped.resize(numOfOuterPins);
+}
+
+
+/*
+ * Unpin a Function
+ */
+void FunctionPassPool::unpin(const Function *F) {
+    auto it = func2AnalysesMap.find(F);
+    if (it != func2AnalysesMap.end()) {
+        assert(it->second.numOfPins > 0 && "Function is not pinned");
+        it->second.numOfPins--;
+    }
+}
+
+
+/*
+ * Get the analyses of F and move F to the front of the LRU list.
+ * Inside a PinScope, F is pinned until the scope ends. Otherwise it is
+ * pinned for the current thread until it queries Size other Functions.
+ */
+FunctionPassPool::FunctionAnalyses &FunctionPassPool::getAnalyses(const Function *F) {
+    map<const Function*, FunctionAnalyses>::iterator it = func2AnalysesMap.find(F);
+    if (it == func2AnalysesMap.end()) {
+        it = func2AnalysesMap.insert(make_pair(F, FunctionAnalyses())).first;
+        lruList.push_front(F);
+        it->second.lruPos = lruList.begin();
+    } else if (it->second.lruPos != lruList.begin()) {
+        lruList.splice(lruList.begin(), lruList, it->second.lruPos);
+    }
+    FunctionAnalyses &analyses = it->second;
+
+    // Pins taken before the last clear() are gone
+    RecentFunctions &recent = recentFunctions;
+    if (recent.generation != generation)
+        recent.reset(generation);
+
+    if (recent.depth > 0) {
+        if (find(recent.scoped.begin(), recent.scoped.end(), F) == recent.scoped.end()) {
+            recent.scoped.push_back(F);
+            analyses.numOfPins++;
+        }
+        return analyses;
+    }
+
+    if (find(recent.funcs, recent.funcs + RecentFunctions::Size, F)
+            != recent.funcs + RecentFunctions::Size)
+        return analyses;
+
+    const Function *old = recent.funcs[recent.next];
+    if (old)
+        unpin(old);
+    recent.funcs[recent.next] = F;
+    recent.next = (recent.next + 1) % RecentFunctions::Size;
+    analyses.numOfPins++;
+    return analyses;
+}
+
+
+/*
+ * Account for a new analysis, then evict the least recently used
+ * unpinned Functions until the cache is within budget.
+ * Functions with LoopInfo or ScalarEvolution are kept, since their Loops
+ * are held by long-lived analyses (e.g., ThreadJoinAnalysis).
+ */
+void FunctionPassPool::addBytes(FunctionAnalyses &analyses, size_t bytes) {
+    // The analyses being returned must survive the eviction below
+    assert(analyses.numOfPins > 0 && "analyses returned without a pin");
+    analyses.bytes += bytes;
+    totalBytes += bytes;
+    numOfMisses++;
+    if (budget == 0)
+        return;
+
+    FuncList::iterator it = lruList.end();
+    while (totalBytes > budget && it != lruList.begin()) {
+        --it;
+        map<const Function*, FunctionAnalyses>::iterator fit = func2AnalysesMap.find(*it);
+        FunctionAnalyses &victim = fit->second;
+        if (victim.numOfPins > 0 || victim.li || victim.se)
+            continue;
+        assert(&victim != &analyses && "evicting the analyses being returned");
+        releaseAnalyses(victim);
+        it = lruList.erase(it);
+        func2AnalysesMap.erase(fit);
+        numOfEvictions++;
+    }
+}
+
+
+/*
+ * Release the analyses of a Function.
+ * ScalarEvolution goes before the LoopInfo and DominatorTree it refers to.
+ */
+void FunctionPassPool::releaseAnalyses(FunctionAnalyses &analyses) {
+    delete analyses.se;
+    delete analyses.li;
+    delete analyses.dt;
+    delete analyses.pdt;
+    delete analyses.df;
+    totalBytes -= analyses.bytes;
+    analyses = FunctionAnalyses();
+}
+
+
 /*
  * Get DominatorTree for Function F.
+ * The DFS numbers are computed up front, so that queries do not update the tree.
  */
 DominatorTree &FunctionPassPool::getDt(const Function *F) {
-    map<const Function*, DominatorTree>::iterator it = func2DtMap.find(F);
-    if (it != func2DtMap.end())
-        return it->second;
+    lock_guard<recursive_mutex> guard(poolMutex);
+    FunctionAnalyses &analyses = getAnalyses(F);
+    if (analyses.dt) {
+        numOfHits++;
+        return *analyses.dt;
+    }
 
-    DominatorTree &dt = func2DtMap[F];
-    dt.recalculate(*const_cast<Function*>(F));
-    return dt;
+    DominatorTree *dt = new DominatorTree();
+    dt->recalculate(*const_cast<Function*>(F));
+    dt->updateDFSNumbers();
+    analyses.dt = dt;
+    addBytes(analyses, sizeof(DominatorTree) + getDomTreeBytes(*dt, F));
+    return *dt;
 }
 
 
@@ -29,13 +276,18 @@ DominatorTree &FunctionPassPool::getDt(const Function *F) {
  * Get DomFrontier for Function F.
  */
 DomFrontier &FunctionPassPool::getDf(const Function *F) {
-    map<const Function*, DomFrontier>::iterator it = func2DfMap.find(F);
-    if (it != func2DfMap.end())
-        return it->second;
+    lock_guard<recursive_mutex> guard(poolMutex);
+    FunctionAnalyses &analyses = getAnalyses(F);
+    if (analyses.df) {
+        numOfHits++;
+        return *analyses.df;
+    }
 
-    DomFrontier &df = func2DfMap[F];
-    df.init(F);
-    return df;
+    DomFrontier *df = new DomFrontier();
+    df->init(F);
+    analyses.df = df;
+    addBytes(analyses, getDfBytes(*df));
+    return *df;
 }
 
 
@@ -43,14 +295,19 @@ DomFrontier &FunctionPassPool::getDf(const Function *F) {
  * Get PostDominatorTree for Function F.
  */
 PostDominatorTree &FunctionPassPool::getPdt(const Function *F) {
-    map<const Function*, PostDominatorTree>::iterator it =
-            func2PdtMap.find(F);
-    if (it != func2PdtMap.end())
-        return it->second;
+    lock_guard<recursive_mutex> guard(poolMutex);
+    FunctionAnalyses &analyses = getAnalyses(F);
+    if (analyses.pdt) {
+        numOfHits++;
+        return *analyses.pdt;
+    }
 
-    PostDominatorTree &pdt = func2PdtMap[F];
-    pdt.recalculate(*const_cast<Function*>(F));
-    return pdt;
+    PostDominatorTree *pdt = new PostDominatorTree();
+    pdt->recalculate(*const_cast<Function*>(F));
+    pdt->updateDFSNumbers();
+    analyses.pdt = pdt;
+    addBytes(analyses, sizeof(PostDominatorTree) + getDomTreeBytes(*pdt, F));
+    return *pdt;
 }
 
 
@@ -58,25 +315,28 @@ PostDominatorTree &FunctionPassPool::getPdt(const Function *F) {
  * Get ScalarEvolution for Function F.
  */
 ScalarEvolution &FunctionPassPool::getSe(const Function *F) {
-    if (F != func2ScevCache.first) {
-        // Create a ScalarEvolution instance
-        Function &func = *const_cast<Function*>(F);
-        TargetLibraryInfo &tli = modulePass->getAnalysis<
-                TargetLibraryInfoWrapperPass>().getTLI();
-        AssumptionCache &ac = modulePass->getAnalysis<
-                AssumptionCacheTracker>().getAssumptionCache(func);
-        DominatorTree &dt = getDt(F);
-        LoopInfo &li = *getLi(F);
-        ScalarEvolution *SE = new ScalarEvolution(func, tli, ac, dt, li);
-
-        // Update the cache
-        func2ScevCache.first = F;
-        if (func2ScevCache.second) {
-            delete func2ScevCache.second;
-        }
-        func2ScevCache.second = SE;
+    lock_guard<recursive_mutex> guard(poolMutex);
+    FunctionAnalyses &analyses = getAnalyses(F);
+    if (analyses.se) {
+        numOfHits++;
+        return *analyses.se;
     }
-    return *func2ScevCache.second;
+
+    // Create a ScalarEvolution instance
+    Function &func = *const_cast<Function*>(F);
+    TargetLibraryInfo &tli = modulePass->getAnalysis<
+            TargetLibraryInfoWrapperPass>().getTLI();
+    AssumptionCache &ac = modulePass->getAnalysis<
+            AssumptionCacheTracker>().getAssumptionCache(func);
+    DominatorTree &dt = getDt(F);
+    LoopInfo &li = *getLi(F);
+    ScalarEvolution *SE = new ScalarEvolution(func, tli, ac, dt, li);
+    analyses.se = SE;
+    size_t numOfInsts = 0;
+    for (Function::const_iterator it = F->begin(), ie = F->end(); it != ie; ++it)
+        numOfInsts += it->size();
+    addBytes(analyses, numOfInsts * SeBytesPerInst);
+    return *SE;
 }
 
 
@@ -84,14 +344,17 @@ ScalarEvolution &FunctionPassPool::getSe(const Function *F) {
  * Get LoopInfo for Function F.
  */
 LoopInfo *FunctionPassPool::getLi(const Function *F) {
-    if (F != func2LiCache.first) {
-        func2LiCache.first = F;
-        if (func2LiCache.second) {
-            delete func2LiCache.second;
-        }
-        func2LiCache.second = new LoopInfo(getDt(F));
+    lock_guard<recursive_mutex> guard(poolMutex);
+    FunctionAnalyses &analyses = getAnalyses(F);
+    if (analyses.li) {
+        numOfHits++;
+        return analyses.li;
     }
-    return func2LiCache.second;
+
+    LoopInfo *LI = new LoopInfo(getDt(F));
+    analyses.li = LI;
+    addBytes(analyses, getLiBytes(*LI));
+    return LI;
 }
 
 
@@ -99,6 +362,7 @@ LoopInfo *FunctionPassPool::getLi(const Function *F) {
  * Get ReturnInst for Function F. Return NULL if it does not exist.
  */
 const ReturnInst *FunctionPassPool::getRet(const Function *F) {
+    lock_guard<recursive_mutex> guard(poolMutex);
     map<const Function*, const ReturnInst*>::iterator it =
             func2RetMap.find(F);
     if (it != func2RetMap.end())
@@ -127,30 +391,32 @@ void FunctionPassPool::setModulePass(ModulePass *modulePass) {
 }
 
 
+/*
+ * Set the memory budget of the cache in bytes, 0 means unbounded
+ */
+void FunctionPassPool::setBudget(size_t bytes) {
+    lock_guard<recursive_mutex> guard(poolMutex);
+    budget = bytes;
+}
+
+
 /*
  * Clear all saved analysis and release the memory
  */
 void FunctionPassPool::clear() {
+    lock_guard<recursive_mutex> guard(poolMutex);
 
-    // Clear caches
-    func2LiCache.first = NULL;
-    if (func2LiCache.second) {
-        delete func2LiCache.second;
-        func2LiCache.second = NULL;
-    }
-
-    func2ScevCache.first = NULL;
-    if (func2ScevCache.second) {
-        delete func2ScevCache.second;
-        func2ScevCache.second = NULL;
+    for (auto it = func2AnalysesMap.begin(), ie = func2AnalysesMap.end();
+            it != ie; ++it) {
+        releaseAnalyses(it->second);
     }
 
     // Clear maps
-    func2DtMap.clear();
-    func2DfMap.clear();
-    func2PdtMap.clear();
-    func2LiMap.clear();
+    func2AnalysesMap.clear();
     func2RetMap.clear();
+    lruList.clear();
+    totalBytes = 0;
+    generation++;
 
     // Set modulePass to NULL
     modulePass = NULL;
@@ -161,12 +427,20 @@ void FunctionPassPool::clear() {
  * Dump the Functions whose analysis exists in this pool
  */
 void FunctionPassPool::print() {
+    lock_guard<recursive_mutex> guard(poolMutex);
     outs() << " --- FunctionPassPool ---\n";
 
-    // Dump Functions with DominatorTree pass
-    outs() << "\tDominatorTree:\t";
-    for (auto it = func2DtMap.begin(), ie = func2DtMap.end(); it != ie; ++it) {
-        outs() << it->first->getName() << "  ";
+    // Dump Functions with cached analyses, most recently used first
+    outs() << "\tCached analyses:\t";
+    for (auto it = lruList.begin(), ie = lruList.end(); it != ie; ++it) {
+        const FunctionAnalyses &analyses = func2AnalysesMap[*it];
+        outs() << (*it)->getName() << "(";
+        if (analyses.dt)    outs() << " Dt";
+        if (analyses.df)    outs() << " Df";
+        if (analyses.pdt)   outs() << " Pdt";
+        if (analyses.li)    outs() << " Li";
+        if (analyses.se)    outs() << " Se";
+        outs() << " )  ";
     }
     outs() << "\n";
 
@@ -177,34 +451,48 @@ void FunctionPassPool::print() {
         outs() << it->first->getName() << "  ";
     }
     outs() << "\n";
+}
 
-    // Dump Function with cached ScalarEvolution pass
-    outs() << "\tCached ScalarEvolution:\t" << func2ScevCache.first->getName()
-            << "\n";
 
-    // Dump Function with cached LoopInfo pass
-    outs() << "\tCached LoopInfo:\t" << func2LiCache.first->getName() << "\n";
+/*
+ * Dump the hit/miss/eviction counters of the cache
+ */
+void FunctionPassPool::printStat() {
+    lock_guard<recursive_mutex> guard(poolMutex);
+    outs() << " --- FunctionPassPool Cache ---\n";
+    outs() << "\tBudget (bytes):\t" << budget << "\n";
+    outs() << "\tCached (bytes):\t" << totalBytes << "\n";
+    outs() << "\tCached Functions:\t" << func2AnalysesMap.size() << "\n";
+    outs() << "\tHits:\t" << numOfHits << "\n";
+    outs() << "\tMisses:\t" << numOfMisses << "\n";
+    outs() << "\tEvictions:\t" << numOfEvictions << "\n";
 }
 
 
 /*
  * Static class members
  */
-map<const Function*, DominatorTree> FunctionPassPool::func2DtMap;
+map<const Function*, FunctionPassPool::FunctionAnalyses> FunctionPassPool::func2AnalysesMap;
 
-map<const Function*, DomFrontier> FunctionPassPool::func2DfMap;
+map<const Function*, const ReturnInst*> FunctionPassPool::func2RetMap;
 
-map<const Function*, PostDominatorTree> FunctionPassPool::func2PdtMap;
+FunctionPassPool::FuncList FunctionPassPool::lruList;
 
-map<const Function*, LoopInfo*> FunctionPassPool::func2LiMap;
+thread_local FunctionPassPool::RecentFunctions FunctionPassPool::recentFunctions;
 
-map<const Function*, const ReturnInst*> FunctionPassPool::func2RetMap;
+size_t FunctionPassPool::budget = 0;
 
-pair<const Function*, ScalarEvolution*> FunctionPassPool::func2ScevCache =
-        make_pair((const Function*) NULL, (ScalarEvolution*) NULL);
+size_t FunctionPassPool::totalBytes = 0;
 
-pair<const Function*, LoopInfo*> FunctionPassPool::func2LiCache = make_pair(
-        (const Function*) NULL, (LoopInfo*) NULL);
+u32_t FunctionPassPool::generation = 0;
+
+u64_t FunctionPassPool::numOfHits = 0;
+
+u64_t FunctionPassPool::numOfMisses = 0;
+
+u64_t FunctionPassPool::numOfEvictions = 0;
+
+recursive_mutex FunctionPassPool::poolMutex;
 
 ModulePass *FunctionPassPool::modulePass = NULL;
 
@@ -269,6 +557,34 @@ void TopoSccOrder::init(PTACallGraph *cg, const PTACallGraph *conservativeCg) {
             func2SccMap[F] = scc;
         }
     } while (!topoNodeStack.empty());
+
+    identifySccDependencies();
+}
+
+
+/*
+ * Record the callee SCCs of every SCC.
+ * Dead Functions and declarations do not belong to any SCC and are skipped.
+ */
+void TopoSccOrder::identifySccDependencies() {
+    for (SCCS::iterator it = topoSccs.begin(), ie = topoSccs.end(); it != ie;
+            ++it) {
+        SCC *scc = *it;
+        DenseSet<const SCC*> calleeSccs;
+        for (SCC::const_iterator fit = scc->begin(), fie = scc->end(); fit != fie;
+                ++fit) {
+            const PTACallGraphNode *cgNode = cg->getCallGraphNode(*fit);
+            for (auto eit = cgNode->getOutEdges().begin(), eie =
+                    cgNode->getOutEdges().end(); eit != eie; ++eit) {
+                const Function *callee = (*eit)->getDstNode()->getFunction();
+                Func2SccMap::const_iterator sit = func2SccMap.find(callee);
+                if (sit == func2SccMap.end() || sit->second == scc)
+                    continue;
+                if (calleeSccs.insert(sit->second).second)
+                    scc->addCalleeScc(const_cast<SCC*>(sit->second));
+            }
+        }
+    }
 }
 
 
@@ -290,3 +606,5 @@ void TopoSccOrder::release() {
 TopoSccOrder InterproceduralAnalysisBaseStaticContainer::topoSccOrder;
 
 BVDataPTAImpl *InterproceduralAnalysisBaseStaticContainer::pta = NULL;
+
+u32_t InterproceduralAnalysisBaseStaticContainer::numOfThreads = 1;
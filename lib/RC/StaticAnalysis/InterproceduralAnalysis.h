@@ -14,9 +14,28 @@
 #include <llvm/Analysis/ScalarEvolution.h>
 #include <llvm/Analysis/TargetLibraryInfo.h>
 #include <llvm/Analysis/AssumptionCache.h>
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <list>
+#include <mutex>
+#include <thread>
 
 /*!
  * Storage of FunctionPass that can be reused by inter-procedural analysis.
+ * The pool may be queried from several threads.
+ *
+ * The analyses of a Function are kept in an LRU cache bounded by a memory
+ * budget. All analyses of the least recently used Function are evicted
+ * together and rebuilt when queried again. Functions with LoopInfo or
+ * ScalarEvolution are never evicted.
+ *
+ * Pinning contract: a reference returned by the pool stays valid until the
+ * end of the innermost PinScope of the querying thread. Every Function queried
+ * inside a PinScope is pinned until the scope ends; the inter-procedural
+ * analyses open one per visited Function. Outside of any PinScope a reference
+ * only stays valid until the thread queries RecentFunctions::Size other
+ * Functions, so it must not be kept across queries of other Functions.
  */
 class FunctionPassPool {
 public:
@@ -41,28 +60,104 @@ public:
     /// Set ModulePass
     static void setModulePass(llvm::ModulePass *modulePass);
 
+    /// Set the memory budget of the cache in bytes, 0 means unbounded
+    static void setBudget(size_t bytes);
+
     /// Clear all saved analysis and release the memory
     static void clear();
 
     /// Dump the Functions whose pass exists in this pool
     static void print();
 
+    /// Dump the hit/miss/eviction counters of the cache
+    static void printStat();
+
+    /*!
+     * Pin all Functions the current thread queries while the scope is alive.
+     * Scopes nest, the pins taken in a scope are released when it ends.
+     */
+    class PinScope {
+    public:
+        PinScope();
+        ~PinScope();
+    private:
+        size_t numOfOuterPins;  ///< pins taken by the enclosing scopes
+    };
+
 private:
+    typedef std::list<const llvm::Function*> FuncList;
+
+    /// Analyses of a Function, NULL if not built
+    struct FunctionAnalyses {
+        FunctionAnalyses() :
+                dt(NULL), df(NULL), pdt(NULL), li(NULL), se(NULL), bytes(0),
+                numOfPins(0) {
+        }
+        llvm::DominatorTree *dt;
+        DomFrontier *df;
+        llvm::PostDominatorTree *pdt;
+        llvm::LoopInfo *li;
+        llvm::ScalarEvolution *se;
+        size_t bytes;               ///< estimated memory of the analyses
+        u32_t numOfPins;            ///< number of threads which used it lately
+        FuncList::iterator lruPos;  ///< position in lruList
+    };
+
+    /*!
+     * The Functions pinned by a thread: the last ones it queried, and
+     * the ones it queried inside its open PinScopes.
+     */
+    struct RecentFunctions {
+        static const u32_t Size = 8;
+        RecentFunctions() : next(0), generation(0), depth(0) {
+            std::fill(funcs, funcs + Size, (const llvm::Function*) NULL);
+        }
+        ~RecentFunctions();
+        /// Drop the pins taken before the last clear()
+        void reset(u32_t gen);
+        const llvm::Function *funcs[Size];
+        u32_t next;
+        u32_t generation;   ///< the pool generation the pins belong to
+        std::vector<const llvm::Function*> scoped;  ///< Functions pinned by the open PinScopes
+        u32_t depth;        ///< number of open PinScopes
+    };
+
+    /// Get the analyses of F, mark F as recently used by the current thread
+    static FunctionAnalyses &getAnalyses(const llvm::Function *F);
+
+    /// Account for a new analysis of a Function and evict the LRU Functions over budget
+    static void addBytes(FunctionAnalyses &analyses, size_t bytes);
+
+    /// Unpin a Function
+    static void unpin(const llvm::Function *F);
+
+    /// Release the analyses of a Function
+    static void releaseAnalyses(FunctionAnalyses &analyses);
+
     /// Mapping from Function to the desired analysis result.
     //@{
-    static std::map<const llvm::Function*, llvm::DominatorTree> func2DtMap;
-    static std::map<const llvm::Function*, DomFrontier> func2DfMap;
-    static std::map<const llvm::Function*, llvm::PostDominatorTree> func2PdtMap;
-    static std::map<const llvm::Function*, llvm::LoopInfo*> func2LiMap;
+    static std::map<const llvm::Function*, FunctionAnalyses> func2AnalysesMap;
     static std::map<const llvm::Function*, const llvm::ReturnInst*> func2RetMap;
     //@}
 
-    /// Cache of relevant FuncionPass
+    /// Functions in func2AnalysesMap, most recently used first
+    static FuncList lruList;
+
+    static thread_local RecentFunctions recentFunctions;
+
+    /// Cache accounting
     //@{
-    static std::pair<const llvm::Function*, llvm::ScalarEvolution*> func2ScevCache;
-    static std::pair<const llvm::Function*, llvm::LoopInfo*> func2LiCache;
+    static size_t budget;
+    static size_t totalBytes;
+    static u32_t generation;
+    static u64_t numOfHits;
+    static u64_t numOfMisses;
+    static u64_t numOfEvictions;
     //@}
 
+    /// Guard of the maps, recursive since getSe() needs getDt() and getLi()
+    static std::recursive_mutex poolMutex;
+
     static llvm::ModulePass *modulePass;
 };
 
@@ -78,6 +173,7 @@ public:
     class SCC {
     public:
         typedef llvm::SmallVector<const llvm::Function*, 8> FuncVector;
+        typedef llvm::SmallVector<const SCC*, 8> SccVector;
         typedef FuncVector::const_iterator const_iterator;
         typedef FuncVector::iterator iterator;
 
@@ -87,7 +183,7 @@ public:
          * @param recursive whether this SCC is recursive
          */
         SCC(const llvm::Function *rep, bool recursive) :
-                rep(rep), recursive(recursive) {
+                rep(rep), recursive(recursive), numOfCalleeSccs(0) {
         }
 
         /// Iterators
@@ -130,6 +226,20 @@ public:
         }
         //@}
 
+        /// Dependencies between SCCs in the call graph
+        //@{
+        inline const SccVector &getCallerSccs() const {
+            return callerSccs;
+        }
+        inline u32_t getNumOfCalleeSccs() const {
+            return numOfCalleeSccs;
+        }
+        inline void addCalleeScc(SCC *callee) {
+            callee->callerSccs.push_back(this);
+            numOfCalleeSccs++;
+        }
+        //@}
+
         /// Collect all call site Instructions of all Functions in SCC.
         template<typename T>
         void collectCallSites(T &csInsts) const {
@@ -152,6 +262,8 @@ public:
         FuncVector scc;
         const llvm::Function *rep;
         bool recursive;
+        SccVector callerSccs;
+        u32_t numOfCalleeSccs;
     };
 
     typedef std::vector<SCC*> SCCS;
@@ -213,7 +325,15 @@ public:
         return !mainReachableFuncs.count(F);
     }
 
+    /// Number of SCCs
+    inline size_t size() const {
+        return topoSccs.size();
+    }
+
 private:
+    /// Record the callee SCCs of every SCC
+    void identifySccDependencies();
+
     PTACallGraph *cg;
     SCCS topoSccs;
     Func2SccMap func2SccMap;
@@ -239,9 +359,15 @@ public:
         return topoSccOrder.isDeadFunction(F);
     }
 
+    /// Number of threads summarizing SCCs in the bottom-up analysis
+    static inline void setNumOfThreads(u32_t n) {
+        numOfThreads = n == 0 ? 1 : n;
+    }
+
 protected:
     static TopoSccOrder topoSccOrder;
     static BVDataPTAImpl *pta;
+    static u32_t numOfThreads;
 };
 
 
@@ -287,6 +413,10 @@ public:
         // Bottom-up analysis
         switch(order) {
         case AO_BOTTOM_UP: {
+            if (numOfThreads > 1) {
+                analyzeBottomUpInParallel();
+                break;
+            }
             for (auto it = topoSccOrder.rbegin(), ie = topoSccOrder.rend();
                     it != ie; ++it) {
                 const SCC *scc = *it;
@@ -336,14 +466,18 @@ public:
     //@}
 
     /// Get the SCC's summary information.
+    /// Summaries are not moved once added, the map itself is guarded
+    /// since SCCs may be summarized in parallel.
     //@{
     inline SccSummary &getOrAddSccSummary(const SCC *scc) {
+        std::lock_guard<std::mutex> guard(summaryMapMutex);
         return scc2SummaryMap[scc];
     }
     inline SccSummary &getOrAddSccSummary(const llvm::Function *F) {
-        return scc2SummaryMap[getScc(F)];
+        return getOrAddSccSummary(getScc(F));
     }
     inline const SccSummary *getSccSummary(const SCC* scc) const {
+        std::lock_guard<std::mutex> guard(summaryMapMutex);
         typename Scc2SummaryMap::const_iterator it = scc2SummaryMap.find(scc);
         if (it != scc2SummaryMap.end())  return &it->second;
         return NULL;
@@ -352,6 +486,7 @@ public:
         return getSccSummary(getScc(F));
     }
     inline SccSummary *getSccSummary(const SCC* scc) {
+        std::lock_guard<std::mutex> guard(summaryMapMutex);
         typename Scc2SummaryMap::iterator it = scc2SummaryMap.find(scc);
         if (it != scc2SummaryMap.end())  return &it->second;
         return NULL;
@@ -361,6 +496,12 @@ public:
     }
     //@}
 
+    /// Guard of updates to the summaries of caller SCCs.
+    /// Callees of the same caller may be summarized at the same time.
+    inline std::mutex &getCallerSummaryMutex() {
+        return callerSummaryMutex;
+    }
+
 protected:
     /// Basic SCC visitor
     void visitScc(const SCC &scc) {
@@ -368,6 +509,8 @@ protected:
                 ++it) {
             const llvm::Function *F = *it;
             if (F->isDeclaration()) continue;
+            // Analyses queried while visiting F stay valid until F is done
+            FunctionPassPool::PinScope pins;
             static_cast<SubClass*>(this)->visitFunction(F);
         }
     }
@@ -401,11 +544,78 @@ protected:
     }
 
 private:
+    /*!
+     * Ready queue of the parallel bottom-up analysis.
+     * An SCC is ready once all of its callee SCCs are summarized.
+     */
+    struct BottomUpSchedule {
+        std::mutex mtx;
+        std::condition_variable cv;
+        std::deque<const SCC*> ready;
+        llvm::DenseMap<const SCC*, u32_t> numOfPendingCallees;
+        size_t numOfUnfinished;
+    };
+
+    /// Summarize the SCCs on numOfThreads workers, callees before callers
+    void analyzeBottomUpInParallel() {
+        BottomUpSchedule schedule;
+        schedule.numOfUnfinished = topoSccOrder.size();
+        for (auto it = topoSccOrder.rbegin(), ie = topoSccOrder.rend();
+                it != ie; ++it) {
+            const SCC *scc = *it;
+            u32_t n = scc->getNumOfCalleeSccs();
+            schedule.numOfPendingCallees[scc] = n;
+            if (n == 0)
+                schedule.ready.push_back(scc);
+        }
+
+        std::vector<std::thread> workers;
+        for (u32_t i = 0; i < numOfThreads; ++i)
+            workers.push_back(std::thread(&InterproceduralAnalysisBase::runBottomUpWorker, this, &schedule));
+        for (u32_t i = 0; i < numOfThreads; ++i)
+            workers[i].join();
+        setCurrentScc(NULL);
+    }
+
+    /// Take ready SCCs until all SCCs are summarized
+    void runBottomUpWorker(BottomUpSchedule *schedule) {
+        std::unique_lock<std::mutex> lock(schedule->mtx);
+        while (true) {
+            while (schedule->ready.empty() && schedule->numOfUnfinished > 0)
+                schedule->cv.wait(lock);
+            if (schedule->numOfUnfinished == 0)
+                break;
+
+            const SCC *scc = schedule->ready.front();
+            schedule->ready.pop_front();
+            lock.unlock();
+
+            setCurrentScc(scc);
+            visitScc(*scc);
+
+            lock.lock();
+            schedule->numOfUnfinished--;
+            for (auto it = scc->getCallerSccs().begin(), ie =
+                    scc->getCallerSccs().end(); it != ie; ++it) {
+                if (--schedule->numOfPendingCallees[*it] == 0)
+                    schedule->ready.push_back(*it);
+            }
+            schedule->cv.notify_all();
+        }
+    }
+
     Scc2SummaryMap scc2SummaryMap;
-    const SCC* currentScc;
+    mutable std::mutex summaryMapMutex;
+    std::mutex callerSummaryMutex;
+    /// SCC visited by the current thread
+    static thread_local const SCC* currentScc;
     AnalysisOrder currentAnalysisOrder;
 };
 
+template<typename SubClass, typename SccSummary>
+thread_local const TopoSccOrder::SCC*
+InterproceduralAnalysisBase<SubClass, SccSummary>::currentScc = NULL;
+
 
 
 #endif /* INTERPROCEDURALANALYSIS_H_ */
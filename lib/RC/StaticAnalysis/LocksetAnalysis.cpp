@@ -425,6 +425,7 @@ void LocksetAnalysis::BottomUpAnalyzer::identifyInterestingStuffsForScc() {
     }
 
     // Propagate reachableFuncs set to callers' SccSummary
+    std::lock_guard<std::mutex> guard(lsa->getCallerSummaryMutex());
     for (auto it = callerSccs.begin(), ie = callerSccs.end(); it != ie; ++it) {
         const SCC *callerScc = *it;
         LocksetSummary &callerSummary = lsa->getOrAddSccSummary(callerScc);
@@ -706,5 +707,7 @@ LocksetAnalysis::FunctionAnalyzerBase::universalLockSites;
 LocksetAnalysis::FunctionAnalyzerBase::UniversalInst2LocksetMap
 LocksetAnalysis::FunctionAnalyzerBase::universalUnlockSites;
 
+std::mutex LocksetAnalysis::FunctionAnalyzerBase::universalMutex;
+
 LocksetAnalysis::InstSet LocksetAnalysis::BottomUpAnalyzer::emptyInstSet;
 
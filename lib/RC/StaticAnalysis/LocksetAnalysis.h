@@ -278,8 +278,15 @@ private:
         /// Constructor
         FunctionAnalyzerBase(LocksetAnalysis *lsa,
                 const llvm::Function *F) :
-                lsa(lsa), F(F), lockSites(universalLockSites[F]),
-                unlockSites(universalUnlockSites[F]) {
+                lsa(lsa), F(F), lockSites(getOrAddSites(universalLockSites, F)),
+                unlockSites(getOrAddSites(universalUnlockSites, F)) {
+        }
+
+        /// Get the records of F, Functions may be analyzed in parallel
+        static inline Inst2LocksetMap &getOrAddSites(
+                UniversalInst2LocksetMap &sites, const llvm::Function *F) {
+            std::lock_guard<std::mutex> guard(universalMutex);
+            return sites[F];
         }
 
         /*!
@@ -301,6 +308,7 @@ private:
         //@{
         static UniversalInst2LocksetMap universalLockSites;
         static UniversalInst2LocksetMap universalUnlockSites;
+        static std::mutex universalMutex;
         //@}
     };
 
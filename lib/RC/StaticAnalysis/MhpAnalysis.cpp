@@ -349,6 +349,7 @@ void MhpAnalysis::bottomUpFunctionVisitor(const Function *F) {
             const Instruction *I = *it;
             const Function *caller = I->getParent()->getParent();
             MhpSummary &callerSummary = getOrAddSccSummary(caller);
+            std::lock_guard<std::mutex> guard(getCallerSummaryMutex());
             callerSummary.addAffectedSpawnSite(spawnSite, I);
         }
     }
@@ -16,6 +16,7 @@
 #include <llvm/Analysis/ScalarEvolution.h>
 #include <llvm/Analysis/ScalarEvolutionExpressions.h>
 #include <llvm/Transforms/Utils/Local.h>    // for FindAllocaDbgDeclare
+#include <mutex>
 #include <sstream>
 
 using namespace llvm;
@@ -728,6 +729,11 @@ bool rcUtil::areSignInsensitivelyEqualIcmpPredicate(CmpInst::Predicate p1,
  */
 AliasResult rcUtil::alias(NodeID node1, NodeID node2,
         PointerAnalysis *pta, bool considerFIObjs) {
+    // Points-to queries may add empty sets and move the iterators
+    // cached in the sets, hence they are serialized.
+    static std::mutex aliasMutex;
+    std::lock_guard<std::mutex> guard(aliasMutex);
+
     PointsTo& p1 = pta->getPts(node1);
     PointsTo& p2 = pta->getPts(node2);
     if (!considerFIObjs) {
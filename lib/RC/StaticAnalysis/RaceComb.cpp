@@ -21,6 +21,7 @@
 #include "RC/RCAnnotaton.h"
 #include "Util/ThreadCallGraph.h"
 #include "Util/RaceAnnotator.h"
+#include "Util/PhaseProfiler.h"
 #include <llvm/Support/CommandLine.h>
 
 using namespace llvm;
@@ -56,11 +57,18 @@ static cl::opt<bool> RcVGep("rc-vgep", cl::init(false),
 cl::opt<bool> RcHandleFree("rc-handle-free", cl::init(false),
                            cl::desc("Handle free() operation."));
 
+static cl::opt<unsigned> RcThreads("rc-threads", cl::init(1),
+                           cl::desc("Number of threads summarizing independent call graph SCCs in the bottom-up analyses"));
+
+static cl::opt<unsigned> RcPassCacheMB("rc-pass-cache-mb", cl::init(512),
+                           cl::desc("Memory budget (MB) of the cached dominator/loop/SCEV analyses, 0 for unbounded"));
+
 
 /*
  * Collect interested operations
  */
 void RaceComb::collectOperations() {
+    PhaseScope phase("RC operation collection");
 
     oc->init(M);
 
@@ -76,6 +84,7 @@ void RaceComb::collectOperations() {
  * Partition memory objects according to their access equivalence
  */
 void RaceComb::partitionMemory() {
+    PhaseScope phase("RC memory partitioning");
 
     mp->init(pta);
 
@@ -166,6 +175,7 @@ void RaceComb::annotateDataraceChecks() {
  * Perform May-Happen-in-Parallel analysis.
  */
 void RaceComb::mhpAnalysis() {
+    PhaseScope phase("RC MHP");
 
     // Basic MhpAnalysis
     mhp->init(cg, tcg, pta);
@@ -185,6 +195,7 @@ void RaceComb::mhpAnalysis() {
  * Perform lockset analysis.
  */
 void RaceComb::locksetAnalysis() {
+    PhaseScope phase("RC lockset");
 
     lsa->init(cg, tcg, pta, RcIntraproceduralLocksetAnalysis.getValue());
 
@@ -199,6 +210,7 @@ void RaceComb::locksetAnalysis() {
  * Perform barrier analysis.
  */
 void RaceComb::barrierAnalysis() {
+    PhaseScope phase("RC barrier");
 
     ba->init(cg, tcg, pta);
 
@@ -213,6 +225,7 @@ void RaceComb::barrierAnalysis() {
  * Perform thread escape analysis.
  */
 void RaceComb::threadEscapeAnalysis() {
+    PhaseScope phase("RC escape analysis");
 
     tea->init(tcg, pta, mp);
 
@@ -227,6 +240,7 @@ void RaceComb::threadEscapeAnalysis() {
  * Perform further refinement.
  */
 void RaceComb::furtherRefinement() {
+    PhaseScope phase("RC refinement");
 
     // HeapRefinement
     heapRefine->init(mhp, lsa, tea);
@@ -244,6 +258,7 @@ void RaceComb::furtherRefinement() {
  * Perform context-sensitive refinement.
  */
 void RaceComb::contextSensitiveRefinement() {
+    PhaseScope phase("RC context-sensitive refinement");
 
     if (!csaa)  return;
 
@@ -281,6 +296,8 @@ void RaceComb::init(Module *M, ModulePass *rcPass) {
 
     // Pass "this->rcPass" to InterproceduralAnalysisBase
     FunctionPassPool::setModulePass(rcPass);
+    FunctionPassPool::setBudget((size_t) RcPassCacheMB << 20);
+    InterproceduralAnalysisBaseStaticContainer::setNumOfThreads(RcThreads);
 
     // Initialize analysis instances
     oc = OperationCollector::getInstance();
@@ -341,6 +358,7 @@ void RaceComb::init(Module *M, ModulePass *rcPass) {
  * Perform RaceComb analysis.
  */
 void RaceComb::analyze() {
+    PhaseScope phase("RaceComb");
 
     stat->startTiming(RCStat::Stat_RcAnalysis);
 
@@ -383,6 +401,7 @@ void RaceComb::analyze() {
 
     if (RcStat) {
         stat->print();
+        FunctionPassPool::printStat();
     }
 
     settleDataRaceResults();
@@ -0,0 +1,302 @@
+/*
+ * TSAccessTable.cpp
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#include "TSAccessTable.h"
+
+#include <assert.h>
+#include <stdint.h>
+#include <string.h>
+
+namespace __ts {
+
+/*
+ * Check overlap of two addresses
+ */
+inline bool overlapAddr(void* addr1, size_t size1, void* addr2, size_t size2) {
+    assert(addr1&&addr2&&size1&&size2);
+    if (addr1==addr2)
+        return true;
+    return (((addr1 <= addr2) && (addr2 < (uint8_t *)addr1 + size1)) || ((addr2 <= addr1) && (addr1 < (uint8_t *)addr2 + size2)));
+}
+
+/*
+ * Constructor
+ */
+AccessTable::AccessTable() {
+    memset(records, 0, sizeof(records));
+    memset(buckets, 0, sizeof(buckets));
+    memset(used, 0, sizeof(used));
+    memset(wideSet, 0, sizeof(wideSet));
+    atomic_store(&numOfWide, 0, memory_order_relaxed);
+    atomic_store(&numOfPublished, 0, memory_order_relaxed);
+}
+
+/*
+ * Acquire a free record for thread tid
+ */
+u32 AccessTable::acquireRecord(uptr tid) {
+    for (u32 w = 0; w < NumOfWords; ++w) {
+        u64 bits = atomic_load(&used[w], memory_order_relaxed);
+        while (bits != ~0ull) {
+            u32 i = __builtin_ctzll(~bits);
+            if (!atomic_compare_exchange_strong(&used[w], &bits, bits | (1ull << i), memory_order_acq_rel))
+                continue;
+
+            u32 rec = w * 64 + i;
+            Record& r = records[rec];
+            r.numOfClaims = 0;
+            r.published = false;
+            r.wide = false;
+            atomic_store(&r.tid, tid, memory_order_relaxed);
+            return rec;
+        }
+    }
+    return NoRecord;
+}
+
+/*
+ * Release a record when its thread exits
+ */
+void AccessTable::releaseRecord(u32 rec) {
+    if (rec == NoRecord)
+        return;
+    unpublish(rec);
+    atomic_fetch_and(&used[rec / 64], ~(1ull << (rec % 64)), memory_order_release);
+}
+
+/*
+ * Publish the access of a record: write the record, then claim the buckets of its lines.
+ * Ranges which are empty or larger than MaxAccessSize are not checked.
+ */
+bool AccessTable::publish(u32 rec, void* waddr, uptr wsize, void* raddr, uptr rsize, uptr instID) {
+    if (rec == NoRecord)
+        return false;
+    Record& r = records[rec];
+    unpublish(rec);
+
+    if (waddr == NULL || wsize >= MaxAccessSize) {
+        waddr = NULL;
+        wsize = 0;
+    }
+    if (raddr == NULL || rsize >= MaxAccessSize) {
+        raddr = NULL;
+        rsize = 0;
+    }
+    if (wsize == 0 && rsize == 0)
+        return false;
+
+    u32 seq = atomic_load(&r.seq, memory_order_relaxed);
+    atomic_store(&r.seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    atomic_store(&r.waddr, (uptr)waddr, memory_order_relaxed);
+    atomic_store(&r.wsize, wsize, memory_order_relaxed);
+    atomic_store(&r.raddr, (uptr)raddr, memory_order_relaxed);
+    atomic_store(&r.rsize, rsize, memory_order_relaxed);
+    atomic_store(&r.instID, instID, memory_order_relaxed);
+    atomic_store(&r.seq, seq + 2, memory_order_release);
+
+    if (!claimRange(rec, waddr, wsize) || !claimRange(rec, raddr, rsize)) {
+        r.wide = true;
+        atomic_fetch_or(&wideSet[rec / 64], 1ull << (rec % 64), memory_order_seq_cst);
+        atomic_fetch_add(&numOfWide, 1, memory_order_seq_cst);
+    }
+    r.published = true;
+
+    /// The access is visible before the counter is bumped, so if no other access is counted,
+    /// any access published later will find this one.
+    return atomic_fetch_add(&numOfPublished, 1, memory_order_seq_cst) > 0;
+}
+
+/*
+ * Remove the access of a record from its buckets and clear the record
+ */
+void AccessTable::unpublish(u32 rec) {
+    if (rec == NoRecord)
+        return;
+    Record& r = records[rec];
+    if (!r.published)
+        return;
+
+    for (u32 i = 0; i < r.numOfClaims; ++i)
+        atomic_store(&buckets[r.claims[i] / SlotsPerBucket].slots[r.claims[i] % SlotsPerBucket], 0, memory_order_release);
+    r.numOfClaims = 0;
+    if (r.wide) {
+        atomic_fetch_and(&wideSet[rec / 64], ~(1ull << (rec % 64)), memory_order_seq_cst);
+        atomic_fetch_sub(&numOfWide, 1, memory_order_seq_cst);
+        r.wide = false;
+    }
+
+    u32 seq = atomic_load(&r.seq, memory_order_relaxed);
+    atomic_store(&r.seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    atomic_store(&r.wsize, 0, memory_order_relaxed);
+    atomic_store(&r.rsize, 0, memory_order_relaxed);
+    atomic_store(&r.seq, seq + 2, memory_order_release);
+
+    r.published = false;
+    atomic_fetch_sub(&numOfPublished, 1, memory_order_seq_cst);
+}
+
+/*
+ * Claim the buckets of all lines of a range, return false if the range is too wide or a bucket is full
+ */
+bool AccessTable::claimRange(u32 rec, void* addr, uptr size) {
+    if (size == 0)
+        return true;
+    uptr first = (uptr)addr >> LineShift;
+    uptr last = ((uptr)addr + size - 1) >> LineShift;
+    if (last - first >= MaxLinesPerAccess)
+        return false;
+    for (uptr line = first; line <= last; ++line) {
+        if (!claimBucket(rec, getBucket(line)))
+            return false;
+    }
+    return true;
+}
+
+/*
+ * Claim a slot of a bucket unless the record is already in it
+ */
+bool AccessTable::claimBucket(u32 rec, u32 bucket) {
+    Bucket& b = buckets[bucket];
+    u32 self = rec + 1;
+    for (u32 i = 0; i < SlotsPerBucket; ++i) {
+        if (atomic_load(&b.slots[i], memory_order_relaxed) == self)
+            return true;
+    }
+    for (u32 i = 0; i < SlotsPerBucket; ++i) {
+        u32 empty = 0;
+        if (atomic_compare_exchange_strong(&b.slots[i], &empty, self, memory_order_seq_cst)) {
+            Record& r = records[rec];
+            r.claims[r.numOfClaims++] = bucket * SlotsPerBucket + i;
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+ * Read a consistent copy of a record.
+ * A record being updated is skipped: its owner has either finished the access or not published it yet.
+ */
+bool AccessTable::snapshot(u32 rec, Access& access) {
+    Record& r = records[rec];
+    u32 seq = atomic_load(&r.seq, memory_order_acquire);
+    if (seq & 1)
+        return false;
+    access.tid = atomic_load(&r.tid, memory_order_relaxed);
+    access.waddr = (void*)atomic_load(&r.waddr, memory_order_relaxed);
+    access.wsize = atomic_load(&r.wsize, memory_order_relaxed);
+    access.raddr = (void*)atomic_load(&r.raddr, memory_order_relaxed);
+    access.rsize = atomic_load(&r.rsize, memory_order_relaxed);
+    access.instID = atomic_load(&r.instID, memory_order_relaxed);
+    atomic_thread_fence(memory_order_acquire);
+    if (atomic_load(&r.seq, memory_order_relaxed) != seq)
+        return false;
+    return access.wsize > 0 || access.rsize > 0;
+}
+
+/*
+ * Compare an access with the one of another record.
+ * Write-write, write-read and read-write overlaps are conflicts.
+ */
+bool AccessTable::compare(const Access& access, u32 other, bool selfcheck, Conflict& conflict) {
+    Access o;
+    if (!snapshot(other, o))
+        return false;
+    if (!selfcheck && access.instID == o.instID)
+        return false;
+
+    conflict.otherTid = o.tid;
+    if (access.wsize > 0) {
+        conflict.write = true;
+        conflict.addr = access.waddr;
+        conflict.size = access.wsize;
+        if (o.wsize > 0 && overlapAddr(access.waddr, access.wsize, o.waddr, o.wsize)) {
+            conflict.otherWrite = true;
+            conflict.otherAddr = o.waddr;
+            conflict.otherSize = o.wsize;
+            return true;
+        }
+        if (o.rsize > 0 && overlapAddr(access.waddr, access.wsize, o.raddr, o.rsize)) {
+            conflict.otherWrite = false;
+            conflict.otherAddr = o.raddr;
+            conflict.otherSize = o.rsize;
+            return true;
+        }
+    }
+    if (access.rsize > 0 && o.wsize > 0 && overlapAddr(access.raddr, access.rsize, o.waddr, o.wsize)) {
+        conflict.write = false;
+        conflict.addr = access.raddr;
+        conflict.size = access.rsize;
+        conflict.otherWrite = true;
+        conflict.otherAddr = o.waddr;
+        conflict.otherSize = o.wsize;
+        return true;
+    }
+    return false;
+}
+
+/*
+ * Compare an access with all records in the buckets of a range
+ */
+bool AccessTable::scanRange(const Access& access, u32 rec, void* addr, uptr size, bool selfcheck, Conflict& conflict) {
+    if (size == 0)
+        return false;
+    uptr first = (uptr)addr >> LineShift;
+    uptr last = ((uptr)addr + size - 1) >> LineShift;
+    for (uptr line = first; line <= last; ++line) {
+        Bucket& b = buckets[getBucket(line)];
+        for (u32 i = 0; i < SlotsPerBucket; ++i) {
+            u32 v = atomic_load(&b.slots[i], memory_order_seq_cst);
+            if (v == 0 || v == rec + 1)
+                continue;
+            if (compare(access, v - 1, selfcheck, conflict))
+                return true;
+        }
+    }
+    return false;
+}
+
+/*
+ * Compare an access with all records of a bitmap
+ */
+bool AccessTable::scanSet(const Access& access, u32 rec, atomic_uint64_t* set, bool selfcheck, Conflict& conflict) {
+    for (u32 w = 0; w < NumOfWords; ++w) {
+        u64 bits = atomic_load(&set[w], memory_order_seq_cst);
+        while (bits) {
+            u32 other = w * 64 + __builtin_ctzll(bits);
+            bits &= bits - 1;
+            if (other != rec && compare(access, other, selfcheck, conflict))
+                return true;
+        }
+    }
+    return false;
+}
+
+/*
+ * Find an in-flight access of another thread overlapping the published access of rec.
+ * A wide access is compared with all records, others only with their buckets and the wide set.
+ */
+bool AccessTable::findConflict(u32 rec, bool selfcheck, Conflict& conflict) {
+    if (rec == NoRecord)
+        return false;
+    Access access;
+    if (!snapshot(rec, access))
+        return false;
+
+    if (records[rec].wide)
+        return scanSet(access, rec, used, selfcheck, conflict);
+
+    if (scanRange(access, rec, access.waddr, access.wsize, selfcheck, conflict)
+            || scanRange(access, rec, access.raddr, access.rsize, selfcheck, conflict))
+        return true;
+    if (atomic_load(&numOfWide, memory_order_seq_cst) > 0)
+        return scanSet(access, rec, wideSet, selfcheck, conflict);
+    return false;
+}
+
+}
@@ -0,0 +1,140 @@
+/*
+ * TSAccessTable.h
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#ifndef TSACCESSTABLE_H_
+#define TSACCESSTABLE_H_
+
+#include "../RTLCommon/RTLAtomic.h"
+
+#include <stddef.h>
+
+namespace __ts {
+typedef unsigned long uptr;
+
+/*!
+ * Lock-free table of the in-flight (published but not yet finished) memory
+ * accesses of all threads.
+ *
+ * Every live thread owns a record holding its current access. The record is
+ * indexed from the buckets of the cache lines its access covers, so a check
+ * only looks at the buckets of its own lines. Accesses spanning too many lines,
+ * or hitting a full bucket, are kept in a wide set which every check scans.
+ *
+ * Records are updated under a sequence number, readers skip a record that is
+ * being updated since its owner has not published it yet and will do the check
+ * itself. A thread publishes its access before it looks for conflicts, hence of
+ * two overlapping accesses at least one sees the other.
+ */
+class AccessTable {
+
+public:
+    /// Sizes of the table
+    //@{
+    static const uptr LineShift = 6;
+    static const u32 NumOfBuckets = 1 << 12;
+    static const u32 SlotsPerBucket = 4;
+    static const u32 MaxLinesPerAccess = 16;
+    static const u32 MaxThreads = 1024;
+    static const u32 NoRecord = MaxThreads;
+    static const uptr MaxAccessSize = 1ull << 20;	///< larger ranges are not checked
+    //@}
+
+    /// A conflicting pair of accesses
+    struct Conflict {
+        bool write;			///< whether the access of the current thread is a write
+        void* addr;
+        uptr size;
+        uptr otherTid;		///< thread of the other access
+        bool otherWrite;
+        void* otherAddr;
+        uptr otherSize;
+    };
+
+    AccessTable();
+
+    /// Acquire a record for thread tid, return NoRecord if all records are in use
+    u32 acquireRecord(uptr tid);
+
+    /// Release a record when its thread exits
+    void releaseRecord(u32 rec);
+
+    /// Publish the access of a record.
+    /// Return true if accesses of other threads may be in flight, i.e., conflicts need to be looked up.
+    bool publish(u32 rec, void* waddr, uptr wsize, void* raddr, uptr rsize, uptr instID);
+
+    /// Remove the access of a record from the table
+    void unpublish(u32 rec);
+
+    /// Find an in-flight access of another thread which overlaps the access of rec
+    bool findConflict(u32 rec, bool selfcheck, Conflict& conflict);
+
+private:
+    /// Access of a record as seen by other threads
+    struct Access {
+        uptr tid;
+        void* waddr;
+        uptr wsize;
+        void* raddr;
+        uptr rsize;
+        uptr instID;
+    };
+
+    /// Record of a thread. The fields after seq are only accessed by the owner.
+    struct Record {
+        atomic_uint32_t seq;			///< odd while the access is being updated
+        atomic_uintptr_t tid;
+        atomic_uintptr_t waddr;
+        atomic_uintptr_t wsize;
+        atomic_uintptr_t raddr;
+        atomic_uintptr_t rsize;
+        atomic_uintptr_t instID;
+        u32 claims[2 * MaxLinesPerAccess];	///< bucket slots taken by the access
+        u32 numOfClaims;
+        bool published;
+        bool wide;
+    };
+
+    /// Slots of a bucket hold record+1, 0 is empty
+    struct Bucket {
+        atomic_uint32_t slots[SlotsPerBucket];
+    };
+
+    static const u32 NumOfWords = MaxThreads / 64;
+
+    /// Bucket of an address
+    static inline u32 getBucket(uptr line) {
+        return line & (NumOfBuckets - 1);
+    }
+
+    /// Add/remove a range of a record to/from its buckets
+    //@{
+    bool claimRange(u32 rec, void* addr, uptr size);
+    bool claimBucket(u32 rec, u32 bucket);
+    //@}
+
+    /// Read a consistent copy of a record, return false if it has no published access
+    bool snapshot(u32 rec, Access& access);
+
+    /// Compare the access of rec with the one of another record
+    bool compare(const Access& access, u32 other, bool selfcheck, Conflict& conflict);
+
+    /// Compare the access of rec with all accesses in the buckets of a range
+    bool scanRange(const Access& access, u32 rec, void* addr, uptr size, bool selfcheck, Conflict& conflict);
+
+    /// Compare the access of rec with all records of a bitmap
+    bool scanSet(const Access& access, u32 rec, atomic_uint64_t* set, bool selfcheck, Conflict& conflict);
+
+    Record records[MaxThreads];
+    Bucket buckets[NumOfBuckets];
+    atomic_uint64_t used[NumOfWords];		///< records owned by live threads
+    atomic_uint64_t wideSet[NumOfWords];	///< records whose access is not bucketed
+    atomic_uint32_t numOfWide;				///< size of wideSet
+    atomic_uint32_t numOfPublished;			///< number of in-flight accesses
+};
+
+}
+
+#endif /* TSACCESSTABLE_H_ */
@@ -22,8 +22,6 @@
 #include <set>
 #include <map>
 
-
-#define MAX_MALLOC_SIZE 1ull<<20
 namespace __ts {
 
 /// Stall breaker for thread scheduling
@@ -37,11 +35,28 @@ bool randomBool() {
     return rand() % 2 == 1;
 }
 
+/*
+ * Take the semaphore for a new thread.
+ */
+void Semaphore::reset(uptr _tid) {
+    atomic_store(&waitflag, 0, memory_order_relaxed);
+    tid = _tid;
+    waited = 0;
+}
+
+/*
+ * Whether the owner has used up its wait budget.
+ */
+bool Semaphore::exhausted() {
+    return waited >= (u64)stallbreaker->maxWaitNumber * stallbreaker->waitTime * 1000;
+}
+
 /*
  * Set the waiting flag.
  */
-void Semaphore::setwaitflag(uint8_t _wf) {
-    atomic_store(&waitflag, _wf, memory_order_relaxed);
+void Semaphore::prepare() {
+    parker.Prepare();
+    atomic_store(&waitflag, 1, memory_order_release);
 }
 
 /*
@@ -49,29 +64,22 @@ void Semaphore::setwaitflag(uint8_t _wf) {
  */
 void Semaphore::release() {
     atomic_store(&waitflag, 0, memory_order_relaxed);
+    parker.Unpark();
 }
 
 /*
  * Acquire the waiting flag.
+ * The owner is parked until it is released, e.g., when all enabled threads are
+ * postponed, or until its remaining wait budget runs out.
  */
 void Semaphore::acquire() {
-    while (atomic_load(&waitflag, memory_order_relaxed)) {
-
-        if (stallbreaker->thrToWaitTime[get_counter()]>stallbreaker->maxWaitNumber) {
-            DBPRINTF(2, std::cout<<"~~## tid:"<< get_counter()<< " wait time:" << stallbreaker->thrToWaitTime[get_counter()]<< "\n");
-            break;
-        }
-
-        usleep(stallbreaker->waitTime);
-        stallbreaker->thrToWaitTime[get_counter()]++;
-
-        if (stallbreaker->IsAllBlocked()) {
-            DBPRINTF(2, std::cout<<"~~## tid:"<< get_counter()
-                     << " total:" << atomic_load(&stallbreaker->total_thread, memory_order_relaxed) << " alive:" << stallbreaker->getAlive()
-                     << " enabled:" << stallbreaker->getEnabled()<< " postponed:" << stallbreaker->getPostponed()<<"\n");
-            break;
-        }
+    u64 budget = (u64)stallbreaker->maxWaitNumber * stallbreaker->waitTime * 1000;
+    u64 start = internal_monotonic_ns();
+    if (!parker.Park(start + budget - waited)) {
+        DBPRINTF(2, std::cout<<"~~## tid:"<< tid << " wait time:" << waited << "\n");
     }
+    atomic_store(&waitflag, 0, memory_order_relaxed);
+    waited += internal_monotonic_ns() - start;
 }
 
 /*
@@ -79,7 +87,11 @@ void Semaphore::acquire() {
  */
 ActiveChecker::ActiveChecker(): sem(NULL), waddr(NULL), wsize(0), raddr(NULL), rsize(0), instID(-1) {
     atomic_store(&isBlocked, 0, memory_order_relaxed);
-    sem = new Semaphore();
+    ordinal = stallbreaker->accessTable.acquireRecord(get_counter());
+    if (ordinal != AccessTable::NoRecord) {
+        sem = &stallbreaker->sems[ordinal];
+        sem->reset(get_counter());
+    }
 }
 
 /*
@@ -87,14 +99,18 @@ ActiveChecker::ActiveChecker(): sem(NULL), waddr(NULL), wsize(0), raddr(NULL), r
  */
 ActiveChecker::ActiveChecker(void* _waddr, size_t _wsize, void* _raddr, size_t _rsize, size_t _instID): sem(NULL), waddr(_waddr), wsize(_wsize), raddr(_raddr), rsize(_rsize), instID(_instID) {
     atomic_store(&isBlocked, 0, memory_order_relaxed);
-    sem = new Semaphore();
+    ordinal = stallbreaker->accessTable.acquireRecord(get_counter());
+    if (ordinal != AccessTable::NoRecord) {
+        sem = &stallbreaker->sems[ordinal];
+        sem->reset(get_counter());
+    }
 }
 
 /*
  * Destructor
  */
 ActiveChecker::~ActiveChecker() {
-    delete sem;
+    stallbreaker->accessTable.releaseRecord(ordinal);
 }
 
 /*
@@ -112,6 +128,7 @@ void ActiveChecker::setAddr(void* _waddr, size_t _wsize, void* _raddr, size_t _r
  * Reset address
  */
 void ActiveChecker::resetAddr() {
+    stallbreaker->accessTable.unpublish(ordinal);
     waddr = NULL;
     wsize = 0;
     raddr = NULL;
@@ -123,23 +140,18 @@ void ActiveChecker::resetAddr() {
  */
 void ActiveChecker::block() {
     DBPRINTF(2, std::cout<<"## block   tid:"<< get_counter()<< " waddr:" << ((waddr)?waddr:"null") <<"+"<<wsize << " raddr:"<< ((raddr)? raddr:"null") <<"+"<<rsize<< "\n");
-    if (stallbreaker->thrToWaitTime[get_counter()]>stallbreaker->maxWaitNumber) {
+    /// Threads without a semaphore are never postponed
+    if (sem == NULL || sem->exhausted()) {
         resetAddr();
-        stallbreaker->ac_mutex.Unlock();
         return;
     }
+    sem->prepare();
     stallbreaker->IncrementPostponed();
-    stallbreaker->ac_mutex.Unlock();
 
-    assert(sem);
     sem->acquire();
 
-    stallbreaker->ac_mutex.Lock();
     resetAddr();
-
-
     stallbreaker->DecrementPostponed();
-    stallbreaker->ac_mutex.Unlock();
 }
 
 /*
@@ -147,63 +159,25 @@ void ActiveChecker::block() {
  */
 void ActiveChecker::unblock() {
     DBPRINTF(2, std::cout<<"## unblock   tid:"<< get_counter()<< " waddr:" << ((waddr)?waddr:"null") <<"+"<<wsize << " raddr:"<< ((raddr)? raddr:"null") <<"+"<<rsize<< "\n");
-    assert(sem);
-    sem->release();
-}
-
-/*
- * Check overlap of two addresses
- */
-inline bool overlapAddr(void* addr1, size_t size1, void* addr2, size_t size2) {
-    assert(addr1&&addr2&&size1&&size2);
-    if (addr1==addr2)
-        return true;
-    return (((addr1 <= addr2) && (addr2 < (uint8_t *)addr1 + size1)) || ((addr2 <= addr1) && (addr1 < (uint8_t *)addr2 + size2)));
+    if (sem)
+        sem->release();
 }
 
 /*
  * Check if a risky pair exists.
+ * The access is published first, conflicts are only looked up in the buckets of its
+ * cache lines, and not at all if no other thread has an access in flight.
  */
 void ActiveChecker::check() {
     DBPRINTF(2, std::cout<<"## checking tid:"<< get_counter()<< " waddr:" << ((waddr)?waddr:"null") <<"+"<<wsize << " raddr:"<< ((raddr)? raddr:"null") <<"+"<<rsize<< "\n");
-    stallbreaker->ac_mutex.Lock();
-    for (UptrToChecker::iterator it = stallbreaker->thrToChecker.begin(),eit = stallbreaker->thrToChecker.end(); it!=eit; ++it) {
-        // Not itself
-        if(it->first == get_counter())
-            continue;
-        ActiveChecker* other = it->second;
-
-        if (wsize>0&&wsize<MAX_MALLOC_SIZE) {
-            if (other->wsize>0&&other->wsize<MAX_MALLOC_SIZE) {
-                if (overlapAddr(waddr, wsize, other->waddr, other->wsize)) {
-                    if (stallbreaker->selfcheck || instID != other->instID) {
-                        std::cout << "      ****** TS Race at t" << get_counter() << " writes " << waddr << "+" << wsize << " t"
-                                  << it->first << " writes " << other->waddr << "+" << other->wsize << " ******\n";
-                        exit(EXIT_FAILURE);
-                    }
-                }
-            }
-            if (other->rsize>0&&other->rsize<MAX_MALLOC_SIZE) {
-                if (overlapAddr(waddr, wsize, other->raddr, other->rsize)) {
-                    if (stallbreaker->selfcheck || instID != other->instID) {
-                        std::cout << "      ****** TS Race at t" << get_counter() << " writes " << waddr << "+" << wsize << " t"
-                                  << it->first << " reads " << other->raddr << "+" << other->rsize << " ******\n";
-                        exit(EXIT_FAILURE);
-                    }
-                }
-            }
-        }
-        if (rsize>0&&rsize<MAX_MALLOC_SIZE) {
-            if (other->wsize>0&&other->wsize<MAX_MALLOC_SIZE) {
-                if (overlapAddr(raddr, rsize, other->waddr, other->wsize)) {
-                    if (stallbreaker->selfcheck || instID != other->instID) {
-                        std::cout << "      ****** TS Race at t" << get_counter() << " reads " << raddr << "+" << rsize << " t"
-                                  << it->first << " writes " << other->waddr << "+" << other->wsize << " ******\n";
-                        exit(EXIT_FAILURE);
-                    }
-                }
-            }
-        }
+    AccessTable& table = stallbreaker->accessTable;
+    AccessTable::Conflict conflict;
+    if (table.publish(ordinal, waddr, wsize, raddr, rsize, instID)
+            && table.findConflict(ordinal, stallbreaker->selfcheck, conflict)) {
+        std::cout << "      ****** TS Race at t" << get_counter() << (conflict.write ? " writes " : " reads ")
+                  << conflict.addr << "+" << conflict.size << " t" << conflict.otherTid
+                  << (conflict.otherWrite ? " writes " : " reads ") << conflict.otherAddr << "+" << conflict.otherSize << " ******\n";
+        exit(EXIT_FAILURE);
     }
     block();
 }
@@ -10,6 +10,7 @@
 
 
 #include "../RTLCommon/RTLMutex.h"
+#include "TSAccessTable.h"
 
 #include <iostream>
 #include <map>
@@ -21,38 +22,59 @@ typedef unsigned long uptr;
 
 /*!
  * This semaphore is black flag to schedule threads.
+ * There is one semaphore per dense thread ordinal. A postponed thread parks on it
+ * until it is released, or its wait budget (maxWaitNumber * waitTime) runs out.
  */
 class Semaphore {
 public:
-    /// Atomic waiting flag.
-    atomic_uint16_t waitflag;
+    /// Parking spot of the owner
+    Parker parker;
+
+    /// Atomic waiting flag, set while the owner is postponed.
+    atomic_uint32_t waitflag;
+
+    /// Thread ID of the owner
+    uptr tid;
+
+    /// Time the owner has been postponed so far in ns, only accessed by the owner.
+    u64 waited;
 
 public:
 
     /*!
      * Constructor: initialize the waiting flag.
      */
-    Semaphore() {
-        atomic_store(&waitflag, 1, memory_order_relaxed);
+    Semaphore(): tid(0), waited(0) {
+        atomic_store(&waitflag, 0, memory_order_relaxed);
     }
 
     ~Semaphore() {
     }
 
     /*!
-     * Release the waiting flag.
+     * Take the semaphore for a new thread.
      */
-    void release();
+    void reset(uptr _tid);
 
     /*!
-     * Acquire the waiting flag.
+     * Whether the owner has used up its wait budget.
      */
-    void acquire();
+    bool exhausted();
+
+    /*!
+     * Set the waiting flag before the owner is postponed.
+     */
+    void prepare();
 
     /*!
-     * Set the waiting flag.
+     * Release the waiting flag and wake the owner.
      */
-    void setwaitflag(uint8_t _wf);
+    void release();
+
+    /*!
+     * Acquire the waiting flag, i.e., park until released or the wait budget runs out.
+     */
+    void acquire();
 };
 
 /*!
@@ -82,6 +104,9 @@ public:
     /// Block flag
     atomic_uint16_t isBlocked;
 
+    /// Dense ordinal of this thread, indexing its access record and semaphore
+    u32 ordinal;
+
 public:
 
     /*!
@@ -111,12 +136,12 @@ public:
     void setAddr(void* _waddr, size_t _wsize, void* _raddr, size_t _rsize, size_t _instID);
 
     /*!
-     * Reset the addresses and their size
+     * Reset the addresses and their size, and remove them from the access table
      */
     void resetAddr();
 
     /*!
-     * Check if a risky pair exists.
+     * Publish the addresses and check if a risky pair exists.
      */
     void check();
 };
@@ -22,6 +22,7 @@ namespace __ts {
 
 extern StallBreaker *stallbreaker;
 pthread_key_t counter;
+pthread_key_t checker;
 
 /*
  * Get current thread ID
@@ -37,6 +38,20 @@ int set_counter(uptr value) {
     return pthread_setspecific(counter, (void *) value);
 }
 
+/*
+ * Get the checker of current thread
+ */
+ActiveChecker* get_checker() {
+    return (ActiveChecker*) pthread_getspecific(checker);
+}
+
+/*
+ * Set the checker of current thread
+ */
+int set_checker(ActiveChecker* value) {
+    return pthread_setspecific(checker, (void *) value);
+}
+
 /*
  * Thread creation information
  */
@@ -67,8 +82,8 @@ void *__ts_thread_start_func(void *arg) {
     } else {
         stallbreaker->IncrementAlive();
         stallbreaker->IncrementEnabled("create\t");
-        assert(!stallbreaker->thrToChecker[get_counter()]);
-        stallbreaker->thrToChecker[get_counter()] = new ActiveChecker();
+        assert(!get_checker());
+        set_checker(new ActiveChecker());
     }
 
     /// Sync with parent thread
@@ -81,8 +96,9 @@ void *__ts_thread_start_func(void *arg) {
     assert(callback);
     void *res = callback(param);
 
-    assert(stallbreaker->thrToChecker[get_counter()]);
-    delete stallbreaker->thrToChecker[get_counter()];
+    assert(get_checker());
+    delete get_checker();
+    set_checker(NULL);
 
     stallbreaker->DecrementAlive();
     stallbreaker->DecrementEnabled("create\t");
@@ -281,7 +297,7 @@ INTERCEPTOR(int, pthread_barrier_wait, pthread_barrier_t *b) {
  */
 void InitializeInterceptors() {
 
-    if (pthread_key_create(&counter, NULL)) {
+    if (pthread_key_create(&counter, NULL) || pthread_key_create(&checker, NULL)) {
         std::cout<<"TS: failed to create thread key.\n";
     }
 
@@ -291,8 +307,8 @@ void InitializeInterceptors() {
     } else {
         stallbreaker->IncrementAlive("\tmain");
         stallbreaker->IncrementEnabled();
-        assert(!stallbreaker->thrToChecker[get_counter()]);
-        stallbreaker->thrToChecker[get_counter()] = new ActiveChecker();
+        assert(!get_checker());
+        set_checker(new ActiveChecker());
         DBPRINTF(1, std::cout<<"# Main thread: "<< get_counter()<<"\n");
     }
 
@@ -10,14 +10,20 @@
 
 #include "../RTLCommon/RTLInterception.h"
 
+#include <pthread.h>
+
 #include <map>
 
 namespace __ts {
 typedef unsigned long uptr;
+class ActiveChecker;
 
 /// Thread ID key
 extern pthread_key_t counter;
 
+/// Thread checker key
+extern pthread_key_t checker;
+
 #if SANITIZER_FREEBSD
 #define __libc_free __free
 #define __libc_malloc __malloc
@@ -33,6 +39,16 @@ uptr get_counter();
  */
 int set_counter(uptr value);
 
+/*!
+ * Get the checker of current thread
+ */
+ActiveChecker* get_checker();
+
+/*!
+ * Set the checker of current thread
+ */
+int set_checker(ActiveChecker* value);
+
 /*!
  * Initialize interceptor
  */
@@ -31,18 +31,18 @@ extern StallBreaker* __ts::stallbreaker;
  * TS function for memory read
  */
 void __ts_memory_read(void *addr, size_t size, size_t instID) {
-    assert(stallbreaker->thrToChecker[get_counter()]);
-    stallbreaker->thrToChecker[get_counter()]->setAddr(NULL, 0, addr, size, instID);
-    stallbreaker->thrToChecker[get_counter()]->check();
+    assert(get_checker());
+    get_checker()->setAddr(NULL, 0, addr, size, instID);
+    get_checker()->check();
 }
 
 /*
  * TS function for memory write
  */
 void __ts_memory_write(void *addr, size_t size, size_t instID) {
-    assert(stallbreaker->thrToChecker[get_counter()]);
-    stallbreaker->thrToChecker[get_counter()]->setAddr(addr, size, NULL, 0, instID);
-    stallbreaker->thrToChecker[get_counter()]->check();
+    assert(get_checker());
+    get_checker()->setAddr(addr, size, NULL, 0, instID);
+    get_checker()->check();
 }
 
 
@@ -64,43 +64,43 @@ void __ts_fini() {
 //@{
 void __ts_memmove(void *dst, void *src, int size, unsigned instID) {
     DBPRINTF(4, std::cout<<"@@ tid: " << get_counter()<<" call __ts_memmove at instID "<< instID<<"\n");
-    assert(stallbreaker->thrToChecker[get_counter()]);
-    stallbreaker->thrToChecker[get_counter()]->setAddr(dst, size, src, size, instID);
-    stallbreaker->thrToChecker[get_counter()]->check();
+    assert(get_checker());
+    get_checker()->setAddr(dst, size, src, size, instID);
+    get_checker()->check();
 }
 void __ts_memcpy(void *dst, void *src, int size, unsigned instID) {
     DBPRINTF(4, std::cout<<"@@ tid: " << get_counter()<<" call __ts_memcpy at instID "<< instID<<"\n");
-    assert(stallbreaker->thrToChecker[get_counter()]);
-    stallbreaker->thrToChecker[get_counter()]->setAddr(dst, size, src, size, instID);
-    stallbreaker->thrToChecker[get_counter()]->check();
+    assert(get_checker());
+    get_checker()->setAddr(dst, size, src, size, instID);
+    get_checker()->check();
 }
 void __ts_memset(void *dst, int size, unsigned instID) {
     DBPRINTF(4, std::cout<<"@@ tid: " << get_counter()<<" call __ts_memset at instID "<< instID<<"\n");
-    assert(stallbreaker->thrToChecker[get_counter()]);
-    stallbreaker->thrToChecker[get_counter()]->setAddr(dst, size, NULL, 0, instID);
-    stallbreaker->thrToChecker[get_counter()]->check();
+    assert(get_checker());
+    get_checker()->setAddr(dst, size, NULL, 0, instID);
+    get_checker()->check();
 }
 
 void __ts_self_memmove(void *dst, void *src, int size, unsigned instID) {
     DBPRINTF(4, std::cout<<"@@ tid: " << get_counter()<<" call __ts_self_memmove at instID "<< instID<<"\n");
     stallbreaker->selfcheck=true;
-    assert(stallbreaker->thrToChecker[get_counter()]);
-    stallbreaker->thrToChecker[get_counter()]->setAddr(dst, size, src, size, instID);
-    stallbreaker->thrToChecker[get_counter()]->check();
+    assert(get_checker());
+    get_checker()->setAddr(dst, size, src, size, instID);
+    get_checker()->check();
 }
 void __ts_self_memcpy(void *dst, void *src, int size, unsigned instID) {
     DBPRINTF(4, std::cout<<"@@ tid: " << get_counter()<<" call __ts_self_memcpy at instID "<< instID<<"\n");
     stallbreaker->selfcheck=true;
-    assert(stallbreaker->thrToChecker[get_counter()]);
-    stallbreaker->thrToChecker[get_counter()]->setAddr(dst, size, src, size, instID);
-    stallbreaker->thrToChecker[get_counter()]->check();
+    assert(get_checker());
+    get_checker()->setAddr(dst, size, src, size, instID);
+    get_checker()->check();
 }
 void __ts_self_memset(void *dst, int size, unsigned instID) {
     DBPRINTF(4, std::cout<<"@@ tid: " << get_counter()<<" call __ts_self_memset at instID "<< instID<<"\n");
     stallbreaker->selfcheck=true;
-    assert(stallbreaker->thrToChecker[get_counter()]);
-    stallbreaker->thrToChecker[get_counter()]->setAddr(dst, size, NULL, 0, instID);
-    stallbreaker->thrToChecker[get_counter()]->check();
+    assert(get_checker());
+    get_checker()->setAddr(dst, size, NULL, 0, instID);
+    get_checker()->check();
 }
 //@}
 
@@ -36,7 +36,6 @@ void Initialize() {
     stallbreaker->postponed_thread.clear();
     stallbreaker->enabled_thread.clear();
     stallbreaker->alive_thread.clear();
-    stallbreaker->thrToWaitTime.clear();
 
     FILE *pfile;
     if ((pfile = fopen("TSRTL_config.inc", "r")) == NULL) {
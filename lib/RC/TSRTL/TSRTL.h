@@ -37,11 +37,9 @@ extern BlockingMutex print_mtx;
 namespace __ts {
 
 typedef unsigned long uptr;
-typedef std::map<uptr, ActiveChecker*> UptrToChecker;
 typedef std::map<uptr, pthread_t*> UptrToThrMap;
 typedef std::map<uptr, pthread_mutex_t*> UptrToMtxMap;
 typedef std::set<uptr> ThrSet;
-typedef std::map<uptr, int> ThrToInt;
 typedef std::set<ActiveChecker*> CheckerSet;
 
 /*!
@@ -61,15 +59,17 @@ struct StallBreaker {
     /// Is self check
     bool selfcheck=false;
 
-    /// The map between thread to wait time
-    ThrToInt thrToWaitTime;
+    /// In-flight memory accesses of all threads
+    AccessTable accessTable;
 
-    /// The map between thread to checker
-    UptrToChecker thrToChecker;
+    /// Semaphores of live threads, indexed by their dense ordinals
+    Semaphore sems[AccessTable::MaxThreads];
+
+    /// Ordinal where the search for a postponed thread to wake starts
+    u32 wakeCursor=0;
 
     /// Locks
     BlockingMutex mtx_;
-    BlockingMutex ac_mutex;
 
     /// The number of total threads
     atomic_uint64_t total_thread;
@@ -168,6 +168,7 @@ struct StallBreaker {
         if(it!=enabled_thread.end()) {
             enabled_thread.erase(it);
         }
+        WakeIfAllBlocked();
 
         DBPRINTF(4, std::cout << s <<" tid: " << get_counter() << " enabled_thread-- has " << enabled_thread.size() << " elements:"; \
         for(ThrSet::iterator iter=enabled_thread.begin(); iter!=enabled_thread.end(); ++iter) {
@@ -197,6 +198,7 @@ struct StallBreaker {
     void IncrementPostponed(std::string s="\t") {
         BlockingMutexLock l(&mtx_);
         postponed_thread.insert(get_counter());
+        WakeIfAllBlocked();
 
         DBPRINTF(4, std::cout << s <<" tid: " << get_counter() << " postponed_thread++ has " << postponed_thread.size() << " elements:"; \
         for(ThrSet::iterator iter=postponed_thread.begin(); iter!=postponed_thread.end(); ++iter) {
@@ -224,6 +226,25 @@ struct StallBreaker {
             );
     }
 
+    /*!
+     * Wake one postponed thread if all enabled threads are postponed, so that a thread
+     * does not wait out its budget when no other thread can make progress.
+     * Postponed threads are picked in turn. The caller holds mtx_.
+     */
+    void WakeIfAllBlocked() {
+        if (postponed_thread.empty() || postponed_thread!=enabled_thread)
+            return;
+        for (u32 i = 0; i < AccessTable::MaxThreads; ++i) {
+            Semaphore& sem = sems[(wakeCursor + i) % AccessTable::MaxThreads];
+            if (atomic_load(&sem.waitflag, memory_order_acquire)) {
+                wakeCursor = (wakeCursor + i + 1) % AccessTable::MaxThreads;
+                postponed_thread.erase(sem.tid);
+                sem.release();
+                return;
+            }
+        }
+    }
+
     /*!
      * Check if all threads are blocked
      */
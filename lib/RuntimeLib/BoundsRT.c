@@ -25,17 +25,32 @@ static size_t __storeCounter = 0;
 static size_t __loadCounter = 0;
 static size_t __totalNumMDEntry = 0;
 
-/// Enlarge the memory if the arrays overflow
+/// Metadata entries are allocated in chunks on demand, up to __MaxNumMDEntry entries
 static const size_t  __MaxNumMDEntry=INT_MAX >> 6; // 33554432 (2^25 -1)
-static const size_t  __MaxNumPTRToMDEntry= INT_MAX >> 5; // 67108863 (2^26 - 1)
-static const size_t  __MaxNumPTRToPropInfoEntry= INT_MAX >> 5; // 67108863 (2^26 - 1)
+#define MD_CHUNK_BITS 12
+#define MD_CHUNK_SIZE (1 << MD_CHUNK_BITS)
+#define MD_MAX_CHUNKS ((INT_MAX >> 6) / MD_CHUNK_SIZE + 1)
+
+/// Shadow tables are indexed by bits 3-24 of a pointer, their pages are allocated on demand
+#define SHADOW_IDX_MASK 0x3fffff
+#define SHADOW_PAGE_BITS 12
+#define SHADOW_PAGE_SIZE (1 << SHADOW_PAGE_BITS)
+#define SHADOW_NUM_PAGES ((SHADOW_IDX_MASK >> SHADOW_PAGE_BITS) + 1)
 
 // TODO : __attribute__ ((__packed__)) ?
-typedef struct  {
+typedef struct MDEntry {
 	  void* base;
 	  void* bound;
 	  size_t key;
 	  void* lock;
+	  /// The allocation [start, end) recorded when the entry is created.
+	  /// base and bound may be overwritten by stores, the index uses start and end.
+	  void* start;
+	  void* end;
+	  /// AVL tree of allocations ordered by start, left also links the free list
+	  struct MDEntry* left;
+	  struct MDEntry* right;
+	  int height;
 }MDEntry;
 
 typedef struct  {
@@ -43,14 +58,24 @@ typedef struct  {
 	  void* bound;
 }PropInfo;
 
-/// MDTable contains all Metadata during runtime
-MDEntry* MDTable = NULL;
+/// MDTable contains all Metadata during runtime, chunk by chunk
+MDEntry* MDTable[MD_MAX_CHUNKS];
+
+/// Freed metadata entries to be reused
+static MDEntry* __freeMDEntry = NULL;
+
+/// Root of the allocation index of heap objects. Indexed allocations never overlap.
+/// Stack and global objects are not indexed, as only __dvf_free looks allocations up.
+static MDEntry* __MDIndexRoot = NULL;
 
 /// PTRToPropInfoTable associate ptr with metadata (MDEntry*) information during propagation
-PropInfo* PTRToPropInfoTable  = NULL;
+PropInfo* PTRToPropInfoTable[SHADOW_NUM_PAGES];
 
 /// PTRToMDTable associate ptr with metadata (MDEntry*) information during propagation
-MDEntry** PTRToMDTable  = NULL;
+MDEntry** PTRToMDTable[SHADOW_NUM_PAGES];
+
+__WEAK_INLINE MDEntry* __getMDEntryFromCPtr(void* ptr);
+__WEAK_INLINE void __setMDEntryFromCPtr(void* ptr, MDEntry* entry);
 
 extern int pseudo_main(int argc, char **argv);
 
@@ -64,60 +89,208 @@ __metadataLoadCounter(){
 	__loadCounter++;
 }
 
+/*
+ * AVL tree of allocations
+ */
+static int __mdHeight(MDEntry* n){
+	return n ? n->height : 0;
+}
+
+static void __mdUpdate(MDEntry* n){
+	int l = __mdHeight(n->left);
+	int r = __mdHeight(n->right);
+	n->height = (l > r ? l : r) + 1;
+}
+
+static MDEntry* __mdRotateRight(MDEntry* n){
+	MDEntry* l = n->left;
+	n->left = l->right;
+	l->right = n;
+	__mdUpdate(n);
+	__mdUpdate(l);
+	return l;
+}
+
+static MDEntry* __mdRotateLeft(MDEntry* n){
+	MDEntry* r = n->right;
+	n->right = r->left;
+	r->left = n;
+	__mdUpdate(n);
+	__mdUpdate(r);
+	return r;
+}
+
+static MDEntry* __mdBalance(MDEntry* n){
+	__mdUpdate(n);
+	int bf = __mdHeight(n->left) - __mdHeight(n->right);
+	if (bf > 1) {
+		if (__mdHeight(n->left->left) < __mdHeight(n->left->right))
+			n->left = __mdRotateLeft(n->left);
+		return __mdRotateRight(n);
+	}
+	if (bf < -1) {
+		if (__mdHeight(n->right->right) < __mdHeight(n->right->left))
+			n->right = __mdRotateRight(n->right);
+		return __mdRotateLeft(n);
+	}
+	return n;
+}
+
+static MDEntry* __mdInsert(MDEntry* n, MDEntry* e){
+	if (n == NULL) {
+		e->left = e->right = NULL;
+		e->height = 1;
+		return e;
+	}
+	if (e->start < n->start)
+		n->left = __mdInsert(n->left, e);
+	else
+		n->right = __mdInsert(n->right, e);
+	return __mdBalance(n);
+}
+
+static MDEntry* __mdRemoveMin(MDEntry* n, MDEntry** min){
+	if (n->left == NULL) {
+		*min = n;
+		return n->right;
+	}
+	n->left = __mdRemoveMin(n->left, min);
+	return __mdBalance(n);
+}
+
+static MDEntry* __mdRemove(MDEntry* n, void* start){
+	if (n == NULL)
+		return NULL;
+	if (start < n->start)
+		n->left = __mdRemove(n->left, start);
+	else if (start > n->start)
+		n->right = __mdRemove(n->right, start);
+	else {
+		MDEntry* l = n->left;
+		MDEntry* r = n->right;
+		if (r == NULL)
+			return l;
+		MDEntry* min;
+		r = __mdRemoveMin(r, &min);
+		min->left = l;
+		min->right = r;
+		return __mdBalance(min);
+	}
+	return __mdBalance(n);
+}
+
+/// The indexed allocation with the greatest start not above ptr
+static MDEntry* __mdFloor(void* ptr){
+	MDEntry* n = __MDIndexRoot;
+	MDEntry* res = NULL;
+	while (n) {
+		if (n->start <= ptr) {
+			res = n;
+			n = n->right;
+		}
+		else
+			n = n->left;
+	}
+	return res;
+}
+
+/*
+ * Remove an entry from the index, clear its shadow slot and put it on the free list
+ */
+static void __mdRelease(MDEntry* e){
+	__MDIndexRoot = __mdRemove(__MDIndexRoot, e->start);
+	if (__getMDEntryFromCPtr(e->start) == e)
+		__setMDEntryFromCPtr(e->start, NULL);
+	e->left = __freeMDEntry;
+	__freeMDEntry = e;
+}
+
+/*
+ * Index the allocation of a heap object. Indexed allocations overlapping it are stale
+ * (e.g. freed by a library without __dvf_free), they are dropped and their entries reused.
+ */
+static void __mdIndex(MDEntry* e){
+	if (e->start >= e->end)
+		return;
+	MDEntry* o;
+	while ((o = __mdFloor((char*)e->end - 1)) && o->end > e->start)
+		__mdRelease(o);
+	__MDIndexRoot = __mdInsert(__MDIndexRoot, e);
+}
+
+/*
+ * Get a metadata entry, reuse a freed one if any
+ */
+static MDEntry* __newMDEntry(){
+	MDEntry* e = __freeMDEntry;
+	if (e) {
+		__freeMDEntry = e->left;
+	}
+	else {
+		assert(__totalNumMDEntry < __MaxNumMDEntry && "out of max number of Metadata table limit");
+		size_t chunk = __totalNumMDEntry >> MD_CHUNK_BITS;
+		if (MDTable[chunk] == NULL)
+			MDTable[chunk] = malloc(sizeof(MDEntry) * MD_CHUNK_SIZE);
+		e = &MDTable[chunk][__totalNumMDEntry & (MD_CHUNK_SIZE - 1)];
+		__totalNumMDEntry++;
+	}
+	memset(e, 0, sizeof(MDEntry));
+	return e;
+}
+
+/*
+ * Find the metadata of the heap allocation containing ptr in O(log n)
+ */
 __WEAK_INLINE MDEntry*
 __findMetaData(void* ptr){
-	for (size_t id = 0; id < __totalNumMDEntry; ++id) {
-    	MDEntry* mdElem = &MDTable[id];
-        if (ptr >= mdElem->base && ptr < mdElem->bound) {
-            return mdElem;
-        }
-    }
-    return NULL;
+	MDEntry* mdElem = __mdFloor(ptr);
+	if (mdElem && ptr < mdElem->end)
+		return mdElem;
+	return NULL;
 }
 
 __WEAK_INLINE MDEntry*
 __getMDEntryFromCPtr(void* ptr){
 
 	size_t ptrIdx = (size_t)ptr;
-	size_t idx = ((ptrIdx >> 3) & 0x3fffff);
+	size_t idx = ((ptrIdx >> 3) & SHADOW_IDX_MASK);
 
-	assert(idx < __MaxNumPTRToMDEntry && "out of max number of PTRToMDEntry table limit");
-
-	return PTRToMDTable[idx];
+	MDEntry** page = PTRToMDTable[idx >> SHADOW_PAGE_BITS];
+	if (page == NULL)
+		return NULL;
+	return page[idx & (SHADOW_PAGE_SIZE - 1)];
 }
 
 __WEAK_INLINE void
 __setMDEntryFromCPtr(void* ptr, MDEntry* entry){
 
 	size_t ptrIdx = (size_t)ptr;
-	size_t idx = ((ptrIdx >> 3) & 0x3fffff);
-
-	assert(idx < __MaxNumPTRToMDEntry && "out of max number of PTRToMDEntry table limit");
+	size_t idx = ((ptrIdx >> 3) & SHADOW_IDX_MASK);
 
-	PTRToMDTable[idx] = entry;
+	MDEntry*** page = &PTRToMDTable[idx >> SHADOW_PAGE_BITS];
+	if (*page == NULL)
+		*page = calloc(SHADOW_PAGE_SIZE, sizeof(MDEntry*));
+	(*page)[idx & (SHADOW_PAGE_SIZE - 1)] = entry;
 }
 
 __WEAK_INLINE PropInfo*
 __getPropInfoFromCPtr(void* ptr){
 
 	size_t ptrIdx = (size_t)ptr;
-	size_t idx = ((ptrIdx >> 3) & 0x3fffff);
+	size_t idx = ((ptrIdx >> 3) & SHADOW_IDX_MASK);
 
-	assert(idx < __MaxNumPTRToPropInfoEntry && "out of max number of PTRToPropInfoEntry table limit");
-
-	return &PTRToPropInfoTable[idx];
+	PropInfo** page = &PTRToPropInfoTable[idx >> SHADOW_PAGE_BITS];
+	if (*page == NULL)
+		*page = calloc(SHADOW_PAGE_SIZE, sizeof(PropInfo));
+	return &(*page)[idx & (SHADOW_PAGE_SIZE - 1)];
 }
 
 __WEAK_INLINE void
 __setPropInfoFromCPtr(void* ptr, PropInfo* propInfoSrc ){
 
-	size_t ptrIdx = (size_t)ptr;
-	size_t idx = ((ptrIdx >> 3) & 0x3fffff);
-
-	assert(idx < __MaxNumPTRToPropInfoEntry && "out of max number of PTRToPropInfoEntry table limit");
-
-	PTRToPropInfoTable[idx].base = propInfoSrc->base;
-	PTRToPropInfoTable[idx].bound = propInfoSrc->bound;
+	PropInfo* propInfo = __getPropInfoFromCPtr(ptr);
+	propInfo->base = propInfoSrc->base;
+	propInfo->bound = propInfoSrc->bound;
 }
 
 __WEAK_INLINE void
@@ -183,17 +356,20 @@ __metadataPropagateInst(void* ptrSrc,void* ptrDst){
 
 }
 
-__WEAK_INLINE void
-__metadataInitialInst(void* ptr, void* ptrBase, void* ptrBound){
+/*
+ * Create the metadata of an object and associate it with ptr, the object is not indexed
+ */
+static MDEntry*
+__metadataInitial(void* ptr, void* ptrBase, void* ptrBound){
 
 	DBOUT(printf("ptr 0x%zx : base 0x%zx to bound 0x%zx\n", (size_t)ptr, (size_t)ptrBase, (size_t)ptrBound))
 
-	assert(__totalNumMDEntry < __MaxNumMDEntry && "out of max number of Metadata table limit");
-
-	MDEntry* mdElem = &MDTable[__totalNumMDEntry++];
+	MDEntry* mdElem = __newMDEntry();
 
 	mdElem->base = ptrBase;
 	mdElem->bound = ptrBound;
+	mdElem->start = ptrBase;
+	mdElem->end = ptrBound;
 
 	PropInfo* propInfo = __getPropInfoFromCPtr(ptr);
 
@@ -201,10 +377,16 @@ __metadataInitialInst(void* ptr, void* ptrBase, void* ptrBound){
 	propInfo->bound = ptrBound;
 
 	__setMDEntryFromCPtr(ptr, mdElem);
+	return mdElem;
+}
+
+__WEAK_INLINE void
+__metadataInitialInst(void* ptr, void* ptrBase, void* ptrBound){
+	__metadataInitial(ptr, ptrBase, ptrBound);
 }
 
 void sizeofTypePrint(){
-	DBOUT(printf("max PTR size = %zd \n", __MaxNumPTRToPropInfoEntry))
+	DBOUT(printf("max PTR size = %d \n", SHADOW_IDX_MASK + 1))
 	DBOUT(printf("max MD size = %zd \n", __MaxNumMDEntry))
 	DBOUT(printf("size_t = %ld,uint32_t = %ld, uint64_t = %ld, u long = %ld, void* = %ld\n", sizeof(size_t),sizeof(uint32_t),sizeof(uint64_t), sizeof(unsigned long), sizeof(void*)))
 }
@@ -215,13 +397,7 @@ void statisticsPrint(){
 }
 
 void MDInitialize(){
-	MDTable = malloc(sizeof(MDEntry) * __MaxNumMDEntry);
-    memset(MDTable, 0, sizeof(MDEntry) * __MaxNumMDEntry);
-    PTRToPropInfoTable = malloc(sizeof(PropInfo) * __MaxNumPTRToPropInfoEntry);
-	memset(PTRToPropInfoTable ,0 , sizeof(PropInfo) * __MaxNumPTRToPropInfoEntry);
-	PTRToMDTable = malloc(sizeof(MDEntry*) * __MaxNumPTRToMDEntry);
-	memset(PTRToMDTable ,0 , sizeof(MDEntry*) * __MaxNumPTRToMDEntry);
-
+	/// Tables are allocated on demand
 	sizeofTypePrint();
 }
 
@@ -235,11 +411,22 @@ __WEAK_INLINE void* __dvf_malloc(size_t size) {
   }
   else{
     char* ptrBound = ptr + size;
-    __metadataInitialInst(ptr,ptr,ptrBound);
+    /// index heap objects so that __dvf_free can release their metadata
+    __mdIndex(__metadataInitial(ptr,ptr,ptrBound));
   }
   return (void*)ptr;
 }
 
+__WEAK_INLINE void __dvf_free(void* ptr) {
+
+  if (ptr == NULL)
+    return;
+  MDEntry* mdElem = __findMetaData(ptr);
+  if (mdElem && mdElem->start == ptr)
+    __mdRelease(mdElem);
+  free(ptr);
+}
+
 int main(int argc, char **argv){
 
 	MDInitialize();
@@ -42,6 +42,7 @@
 #include <llvm/IR/CFG.h>		// for CFG
 #include "Util/Conditions.h"
 #include <sys/resource.h>		/// increase stack size
+#include <mutex>
 
 using namespace llvm;
 
@@ -336,6 +337,17 @@ std::string analysisUtil::getSourceLoc(const Value* val) {
     return rawstr.str();
 }
 
+/*!
+ * 64-bit FNV-1a hash of a string
+ */
+u64_t analysisUtil::getStableHash(llvm::StringRef str, u64_t hash) {
+    for (StringRef::iterator it = str.begin(), eit = str.end(); it != eit; ++it) {
+        hash ^= (unsigned char)*it;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
 /*!
  * print successful message by converting a string into green string output
  */
@@ -348,6 +360,9 @@ std::string analysisUtil::sucMsg(std::string msg) {
  */
 void analysisUtil::wrnMsg(std::string msg) {
     if(DisableWarn) return;
+    /// warnings may be issued by threads building memory SSA
+    static std::mutex wrnMutex;
+    std::lock_guard<std::mutex> lock(wrnMutex);
     outs() << KYEL + msg + KNRM << "\n";
 }
 
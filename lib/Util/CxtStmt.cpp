@@ -0,0 +1,32 @@
+//===- CxtStmt.cpp -- Context- and Thread-Sensitive Statement-----------------//
+//
+//                     SVF: Static Value-Flow Analysis
+//
+// Copyright (C) <2013-2017>  <Yulei Sui>
+//
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+
+/*
+ * CxtStmt.cpp
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#include "Util/CxtStmt.h"
+
+std::atomic<CallStrCxtTable*> CallStrCxtTable::table(NULL);
+std::mutex CallStrCxtTable::tableMutex;
@@ -856,3 +856,46 @@ void ExtAPI::init() {
     }
 }
 
+
+/*!
+ * Look up the type of a function declaration by its name.
+ * Intrinsics are looked up by their base name, e.g., llvm.memcpy for llvm.memcpy.p0i8.p0i8.i64.
+ */
+ExtAPI::extf_t ExtAPI::compute_type(const llvm::Function *F) const {
+    if(!F->isDeclaration())
+        return EFT_OTHER;
+    llvm::StringMap<extf_t>::const_iterator it;
+    if(F->isIntrinsic()) {
+        std::string funName = "llvm." + F->getName().split('.').second.split('.').first.str();
+        it= info.find(funName);
+    } else {
+        it= info.find(F->getName());
+    }
+    if(it == info.end())
+        return EFT_OTHER;
+    return it->second;
+}
+
+/*!
+ * Should (F) be considered "external"?
+ */
+bool ExtAPI::compute_is_ext(const llvm::Function *F) const {
+    if(F->isDeclaration() || F->isIntrinsic())
+        return true;
+    extf_t t= compute_type(F);
+    return t==EFT_ALLOC || t==EFT_REALLOC || t==EFT_NOSTRUCT_ALLOC
+           || t==EFT_NOOP || t==EFT_FREE;
+}
+
+/*!
+ * Classify all functions of a module
+ */
+void ExtAPI::classifyModule(const llvm::Module &M) {
+    for(llvm::Module::const_iterator it= M.begin(), eit= M.end(); it != eit; ++it) {
+        const llvm::Function *F= &*it;
+        FunKind kind;
+        kind.type= compute_type(F);
+        kind.isExt= compute_is_ext(F);
+        funKinds[F]= kind;
+    }
+}
@@ -0,0 +1,242 @@
+/*
+ * PhaseProfiler.cpp
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#include "Util/PhaseProfiler.h"
+
+#include <llvm/Support/CommandLine.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/Format.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <stdio.h>
+#include <sys/resource.h>
+#include <time.h>
+#include <unistd.h>
+
+using namespace llvm;
+
+static cl::opt<std::string> PhaseProfile("phase-profile", cl::init(""),
+        cl::desc("Write wall time, CPU time and memory of analysis phases to a Chrome trace file"));
+
+static cl::opt<bool> PhaseProfileSummary("phase-profile-summary", cl::init(false),
+        cl::desc("Print the tree of analysis phases recorded by -phase-profile"));
+
+namespace {
+
+/// Recorded phases, they are declared after the options so that they are destroyed first
+std::mutex phaseMutex;
+std::vector<PhaseProfiler::Phase> phases;
+const double traceOrigin = PhaseProfiler::getWallUs();
+
+std::atomic<u32_t> numOfThreads(0);
+
+/// Profiler's number of a thread and its open phases
+thread_local u32_t threadNo = numOfThreads++;
+thread_local std::vector<const char*> openPhases;
+
+/// Dump the phases at exit
+struct PhaseProfilerAtExit {
+    ~PhaseProfilerAtExit() {
+        PhaseProfiler::dump();
+    }
+} atExit;
+
+/// Escape a string for JSON
+std::string escape(const std::string& str) {
+    std::string res;
+    for (std::string::const_iterator it = str.begin(), eit = str.end(); it != eit; ++it) {
+        if (*it == '"' || *it == '\\')
+            res += '\\';
+        res += *it;
+    }
+    return res;
+}
+
+}
+
+/*!
+ * Whether -phase-profile is given
+ */
+bool PhaseProfiler::isEnabled() {
+    return !PhaseProfile.empty();
+}
+
+/*!
+ * Record a finished phase
+ */
+void PhaseProfiler::addPhase(const Phase& phase) {
+    std::lock_guard<std::mutex> lock(phaseMutex);
+    phases.push_back(phase);
+}
+
+/*!
+ * Write the phases recorded so far
+ */
+void PhaseProfiler::dump() {
+    if (!isEnabled())
+        return;
+    std::vector<Phase> snapshot;
+    {
+        std::lock_guard<std::mutex> lock(phaseMutex);
+        snapshot = phases;
+    }
+    writeTrace(snapshot, PhaseProfile);
+    if (PhaseProfileSummary)
+        printSummary(snapshot);
+}
+
+/*!
+ * Write phases as complete ("X") events of the Chrome trace event format.
+ * Times are in microseconds, the measurements are in the args of each event.
+ */
+void PhaseProfiler::writeTrace(const std::vector<Phase>& phases, const std::string& filename) {
+    std::error_code err;
+    raw_fd_ostream out(filename, err, sys::fs::F_Text);
+    if (err) {
+        fprintf(stderr, "Cannot write phase profile to %s: %s\n", filename.c_str(), err.message().c_str());
+        return;
+    }
+
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    for (u32_t i = 0; i < phases.size(); ++i) {
+        const Phase& phase = phases[i];
+        if (i > 0)
+            out << ",";
+        out << "\n{\"name\":\"" << escape(phase.name) << "\",\"cat\":\"phase\",\"ph\":\"X\""
+            << ",\"pid\":" << getpid() << ",\"tid\":" << phase.tid;
+        out << format(",\"ts\":%.0f,\"dur\":%.0f", phase.startUs, phase.wallUs);
+        out << ",\"args\":{\"path\":\"" << escape(phase.path) << "\""
+            << format(",\"cpu_ms\":%.3f", phase.cpuUs / 1000)
+            << ",\"rss_delta_kb\":" << phase.rssDeltaKB
+            << ",\"peak_rss_delta_kb\":" << phase.peakDeltaKB
+            << ",\"peak_rss_kb\":" << phase.peakKB << "}}";
+    }
+    out << "\n]}\n";
+}
+
+/*!
+ * Print the phases aggregated by path, children below their parents.
+ * It writes to its own stream of stdout since outs() may be destroyed when the phases are dumped at exit.
+ */
+void PhaseProfiler::printSummary(const std::vector<Phase>& phases) {
+    struct Total {
+        u32_t count;
+        u32_t depth;
+        double wallUs;
+        double cpuUs;
+        s64_t peakDeltaKB;
+        Total() : count(0), depth(0), wallUs(0), cpuUs(0), peakDeltaKB(0) {}
+    };
+    std::map<std::string, Total> totals;
+    for (std::vector<Phase>::const_iterator it = phases.begin(), eit = phases.end(); it != eit; ++it) {
+        Total& total = totals[it->path];
+        total.count++;
+        total.depth = it->depth;
+        total.wallUs += it->wallUs;
+        total.cpuUs += it->cpuUs;
+        total.peakDeltaKB += it->peakDeltaKB;
+    }
+
+    raw_fd_ostream out(STDOUT_FILENO, false);
+    out << "\n****Phase Profile****\n";
+    const char* columns[] = {"Phase", "Count", "Wall(s)", "CPU(s)", "PeakRSS+(KB)"};
+    out << format("%-48s %8s %12s %12s %14s\n", columns[0], columns[1], columns[2], columns[3], columns[4]);
+    for (std::map<std::string, Total>::const_iterator it = totals.begin(), eit = totals.end(); it != eit; ++it) {
+        std::string::size_type slash = it->first.rfind('/');
+        std::string name = std::string(2 * it->second.depth, ' ')
+                           + (slash == std::string::npos ? it->first : it->first.substr(slash + 1));
+        out << format("%-48s %8u %12.3f %12.3f %14lld\n", name.c_str(), it->second.count,
+                         it->second.wallUs / 1000000, it->second.cpuUs / 1000000, it->second.peakDeltaKB);
+    }
+    out << "#######################################################\n";
+}
+
+/*!
+ * Wall-clock time in microseconds
+ */
+double PhaseProfiler::getWallUs() {
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/*!
+ * CPU time of the calling thread in microseconds
+ */
+double PhaseProfiler::getThreadCpuUs() {
+    struct timespec ts;
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != 0)
+        return 0;
+    return ts.tv_sec * 1000000.0 + ts.tv_nsec / 1000.0;
+}
+
+/*!
+ * Current resident set size, read from /proc/self/statm
+ */
+u64_t PhaseProfiler::getRssKB() {
+    FILE* statm = fopen("/proc/self/statm", "r");
+    if (statm == NULL)
+        return 0;
+    unsigned long size = 0, resident = 0;
+    if (fscanf(statm, "%lu %lu", &size, &resident) != 2)
+        resident = 0;
+    fclose(statm);
+    return (u64_t)resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+/*!
+ * Peak resident set size of the process
+ */
+u64_t PhaseProfiler::getPeakRssKB() {
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0;
+    return usage.ru_maxrss;
+}
+
+/*!
+ * Open a phase in the calling thread
+ */
+PhaseScope::PhaseScope(const char* n) : name(n), enabled(PhaseProfiler::isEnabled()),
+    wallStart(0), cpuStart(0), rssStart(0), peakStart(0) {
+    if (!enabled)
+        return;
+    openPhases.push_back(name);
+    rssStart = PhaseProfiler::getRssKB();
+    peakStart = PhaseProfiler::getPeakRssKB();
+    cpuStart = PhaseProfiler::getThreadCpuUs();
+    wallStart = PhaseProfiler::getWallUs();
+}
+
+/*!
+ * Close the phase and record it
+ */
+PhaseScope::~PhaseScope() {
+    if (!enabled)
+        return;
+    double wallEnd = PhaseProfiler::getWallUs();
+    double cpuEnd = PhaseProfiler::getThreadCpuUs();
+
+    PhaseProfiler::Phase phase;
+    for (u32_t i = 0; i < openPhases.size(); ++i) {
+        if (i > 0)
+            phase.path += '/';
+        phase.path += openPhases[i];
+    }
+    openPhases.pop_back();
+
+    phase.name = name;
+    phase.tid = threadNo;
+    phase.depth = openPhases.size();
+    phase.startUs = wallStart - traceOrigin;
+    phase.wallUs = wallEnd - wallStart;
+    phase.cpuUs = cpuEnd - cpuStart;
+    phase.rssDeltaKB = (s64_t)PhaseProfiler::getRssKB() - (s64_t)rssStart;
+    phase.peakKB = PhaseProfiler::getPeakRssKB();
+    phase.peakDeltaKB = (s64_t)phase.peakKB - (s64_t)peakStart;
+    PhaseProfiler::addPhase(phase);
+}
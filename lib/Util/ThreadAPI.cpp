@@ -118,6 +118,17 @@ void ThreadAPI::init() {
     }
 }
 
+/*!
+ * Classify all functions of a module
+ */
+void ThreadAPI::classifyModule(const Module& module) {
+    for (Module::const_iterator it = module.begin(), eit = module.end(); it != eit; ++it) {
+        const Function* fun = &*it;
+        TDAPIMap::const_iterator tit = tdAPIMap.find(fun->getName());
+        funToTypeMap[fun] = tit != tdAPIMap.end() ? tit->second : TD_DUMMY;
+    }
+}
+
 /*!
  *
  */
@@ -30,6 +30,7 @@
 #include "MemoryModel/PAG.h"
 #include "WPA/Andersen.h"
 #include "Util/AnalysisUtil.h"
+#include "Util/PhaseProfiler.h"
 
 #include <llvm/Support/CommandLine.h> // for tool output file
 
@@ -75,6 +76,8 @@ bool Andersen::runOnModule(llvm::Module& module) {
  * Andersen analysis
  */
 void Andersen::analyze(llvm::Module& module) {
+    PhaseScope phase("Andersen");
+
     /// Initialization for the Solver
     initialize(module);
 
@@ -97,11 +100,17 @@ void Andersen::analyze(llvm::Module& module) {
             reanalyze = false;
 
             /// Start solving constraints
-            solve();
+            {
+                PhaseScope solvePhase("Andersen solve");
+                solve();
+            }
 
             double cgUpdateStart = stat->getClk();
-            if (updateCallGraph(getIndirectCallsites()))
-                reanalyze = true;
+            {
+                PhaseScope cgPhase("Andersen call graph update");
+                if (updateCallGraph(getIndirectCallsites()))
+                    reanalyze = true;
+            }
             double cgUpdateEnd = stat->getClk();
             timeOfUpdateCallGraph += (cgUpdateEnd - cgUpdateStart) / TIMEINTERVAL;
 
@@ -131,7 +140,7 @@ void Andersen::processNode(NodeID nodeId) {
 
     ConstraintNode* node = consCG->getConstraintNode(nodeId);
 
-    for (ConstraintNode::const_iterator it = node->outgoingAddrsBegin(), eit =
+    for (ConstraintNode::const_edge_iterator it = node->outgoingAddrsBegin(), eit =
                 node->outgoingAddrsEnd(); it != eit; ++it) {
         processAddr(cast<AddrCGEdge>(*it));
     }
@@ -140,14 +149,14 @@ void Andersen::processNode(NodeID nodeId) {
                 getPts(nodeId).end(); piter != epiter; ++piter) {
         NodeID ptd = *piter;
         // handle load
-        for (ConstraintNode::const_iterator it = node->outgoingLoadsBegin(),
+        for (ConstraintNode::const_edge_iterator it = node->outgoingLoadsBegin(),
                 eit = node->outgoingLoadsEnd(); it != eit; ++it) {
             if (processLoad(ptd, *it))
                 pushIntoWorklist(ptd);
         }
 
         // handle store
-        for (ConstraintNode::const_iterator it = node->incomingStoresBegin(),
+        for (ConstraintNode::const_edge_iterator it = node->incomingStoresBegin(),
                 eit = node->incomingStoresEnd(); it != eit; ++it) {
             if (processStore(ptd, *it))
                 pushIntoWorklist((*it)->getSrcID());
@@ -171,7 +180,7 @@ void Andersen::processAllAddr()
 {
     for (ConstraintGraph::const_iterator nodeIt = consCG->begin(), nodeEit = consCG->end(); nodeIt != nodeEit; nodeIt++) {
         ConstraintNode * cgNode = nodeIt->second;
-        for (ConstraintNode::const_iterator it = cgNode->incomingAddrsBegin(), eit = cgNode->incomingAddrsEnd();
+        for (ConstraintNode::const_edge_iterator it = cgNode->incomingAddrsBegin(), eit = cgNode->incomingAddrsEnd();
                 it != eit; ++it)
             processAddr(cast<AddrCGEdge>(*it));
     }
@@ -265,6 +274,18 @@ void Andersen::processGepPts(PointsTo& pts, const GepCGEdge* edge)
     numOfProcessedGep++;
 
     PointsTo tmpDstPts;
+    computeGepPts(pts, edge, tmpDstPts);
+
+    NodeID dstId = edge->getDstID();
+    if (unionPts(dstId, tmpDstPts))
+        pushIntoWorklist(dstId);
+}
+
+/*!
+ * Compute the objects a gep edge derives from pts into tmpDstPts
+ */
+void Andersen::computeGepPts(PointsTo& pts, const GepCGEdge* edge, PointsTo& tmpDstPts)
+{
     for (PointsTo::iterator piter = pts.begin(), epiter = pts.end(); piter != epiter; ++piter) {
         /// get the object
         NodeID ptd = *piter;
@@ -299,10 +320,6 @@ void Andersen::processGepPts(PointsTo& pts, const GepCGEdge* edge)
             }
         }
     }
-
-    NodeID dstId = edge->getDstID();
-    if (unionPts(dstId, tmpDstPts))
-        pushIntoWorklist(dstId);
 }
 
 /*
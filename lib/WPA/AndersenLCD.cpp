@@ -49,7 +49,7 @@ void AndersenLCD::processNode(NodeID nodeId) {
 
     ConstraintNode* node = consCG->getConstraintNode(nodeId);
 
-    for (ConstraintNode::const_iterator it = node->outgoingAddrsBegin(), eit =  node->outgoingAddrsEnd(); it != eit;
+    for (ConstraintNode::const_edge_iterator it = node->outgoingAddrsBegin(), eit =  node->outgoingAddrsEnd(); it != eit;
             ++it) {
         processAddr(cast<AddrCGEdge>(*it));
     }
@@ -58,14 +58,14 @@ void AndersenLCD::processNode(NodeID nodeId) {
                 nodeId).end(); piter != epiter; ++piter) {
         NodeID ptd = *piter;
         // handle load
-        for (ConstraintNode::const_iterator it = node->outgoingLoadsBegin(), eit = node->outgoingLoadsEnd(); it != eit;
+        for (ConstraintNode::const_edge_iterator it = node->outgoingLoadsBegin(), eit = node->outgoingLoadsEnd(); it != eit;
                 ++it) {
             if(processLoad(ptd, *it))
                 pushIntoWorklist(ptd);
         }
 
         // handle store
-        for (ConstraintNode::const_iterator it = node->incomingStoresBegin(), eit =  node->incomingStoresEnd(); it != eit;
+        for (ConstraintNode::const_edge_iterator it = node->incomingStoresBegin(), eit =  node->incomingStoresEnd(); it != eit;
                 ++it) {
             if(processStore(ptd, *it))
                 pushIntoWorklist((*it)->getSrcID());
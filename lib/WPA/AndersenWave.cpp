@@ -80,13 +80,13 @@ void AndersenWave::postProcessNode(NodeID nodeId)
     ConstraintNode* node = consCG->getConstraintNode(nodeId);
 
     // handle load
-    for (ConstraintNode::const_iterator it = node->outgoingLoadsBegin(), eit = node->outgoingLoadsEnd();
+    for (ConstraintNode::const_edge_iterator it = node->outgoingLoadsBegin(), eit = node->outgoingLoadsEnd();
             it != eit; ++it) {
         if (handleLoad(nodeId, *it))
             reanalyze = true;
     }
     // handle store
-    for (ConstraintNode::const_iterator it = node->incomingStoresBegin(), eit =  node->incomingStoresEnd();
+    for (ConstraintNode::const_edge_iterator it = node->incomingStoresBegin(), eit =  node->incomingStoresEnd();
             it != eit; ++it) {
         if (handleStore(nodeId, *it))
             reanalyze = true;
@@ -30,10 +30,317 @@
 #include "WPA/Andersen.h"
 #include <llvm/Support/CommandLine.h> // for tool output file
 
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
 using namespace llvm;
 using namespace analysisUtil;
 
+/// Experimental: equivalence with the sequential solver and the speedup are not yet
+/// established on real programs, see tests/scripts/checkwpathreads.sh
+static cl::opt<unsigned> AnderThreads("ander-threads", cl::init(1),
+                                      cl::desc("Number of threads used to propagate points-to sets in AndersenWaveDiff (experimental)"));
+
+/// Batches with fewer unions are propagated by the calling thread
+static cl::opt<unsigned> MinParallelBatchSize("ander-min-batch", cl::init(64), cl::Hidden,
+        cl::desc("Minimum number of unions propagated by multiple threads in AndersenWaveDiff"));
+
 AndersenWaveDiff* AndersenWaveDiff::diffWave = NULL;
+u32_t AndersenWaveDiff::numOfThreads = 0;
+
+/*!
+ * Work shared by the threads propagating a batch.
+ * Contributions are grouped by destination, each group is unioned by one thread in the original order.
+ * Reverse points-to sets are split into ranges of objects, one range per thread.
+ */
+struct AndersenWaveDiff::BatchSchedule {
+    std::vector<u32_t> order;	///< contributions sorted by destination, stable
+    std::vector<u32_t> groups;	///< start of each destination in order, plus the end
+    std::vector<PointsTo*> groupPts;	///< points-to set of each destination
+    std::atomic<u32_t> nextGroup;
+    std::vector<NodeID> objs;	///< all objects of the contributions, sorted
+    std::vector<PointsTo*> revPts;	///< reverse points-to set of each object
+    u32_t numOfWorkers;
+};
+
+/*!
+ * Helper threads waiting for batches to propagate.
+ * They are started once and reused by every batch, the calling thread works on each batch as worker 0.
+ */
+struct AndersenWaveDiff::BatchWorkers {
+    std::mutex mtx;
+    std::condition_variable posted;	///< a batch is posted or the helpers are stopped
+    std::condition_variable finished;	///< all helpers are done with the batch
+    BatchSchedule* schedule;	///< the batch being propagated
+    u32_t round;	///< number of batches posted so far
+    u32_t numOfBusy;	///< helpers still working on the batch
+    bool stop;
+    std::vector<std::thread> threads;
+};
+
+/*!
+ * Constraint solving.
+ * With multiple threads, the topological pass propagates batches of independent nodes in parallel.
+ * The type-filtered variant handles casts while propagating, so it is always solved sequentially.
+ */
+void AndersenWaveDiff::solve()
+{
+    if (numOfThreads == 0)
+        numOfThreads = AnderThreads;
+
+    if (numOfThreads <= 1 || getAnalysisTy() != AndersenWaveDiff_WPA) {
+        AndersenWave::solve();
+        return;
+    }
+
+    if (workers == NULL)
+        startBatchWorkers();
+
+    NodeStack& nodeStack = SCCDetect();
+    while (!nodeStack.empty()) {
+        NodeID nodeId = nodeStack.top();
+        nodeStack.pop();
+        processNodeInBatch(nodeId);
+    }
+    propagateBatch();
+
+    while (!isWorklistEmpty()) {
+        NodeID nodeId = popFromWorklist();
+        postProcessNode(nodeId);
+    }
+}
+
+/*!
+ * Same as processNode, except that unions over copy/gep edges are added to the batch.
+ * The batch is propagated first whenever the node may read a points-to set it changes,
+ * i.e., the node is a destination of the batch or is going to be collapsed.
+ */
+void AndersenWaveDiff::processNodeInBatch(NodeID nodeId)
+{
+    double propStart = stat->getClk();
+
+    if (consCG->isPWCNode(nodeId)) {
+        propagateBatch();
+        if (collapseNodePts(nodeId))
+            reanalyze = true;
+    }
+
+    if (sccRepNode(nodeId) != nodeId)
+        return;
+
+    if (batch.dsts.test(nodeId))
+        propagateBatch();
+
+    ConstraintNode* node = consCG->getConstraintNode(nodeId);
+    computeDiffPts(nodeId);
+    PointsTo& diffPts = getDiffPts(nodeId);
+    if (!diffPts.empty()) {
+        for (ConstraintNode::const_iterator it = node->directOutEdgeBegin(), eit = node->directOutEdgeEnd(); it != eit;
+                ++it) {
+            if (isa<CopyCGEdge>(*it)) {
+                numOfProcessedCopy++;
+                addToBatch((*it)->getDstID(), &diffPts);
+            }
+            else if (GepCGEdge* gepEdge = dyn_cast<GepCGEdge>(*it)) {
+                numOfProcessedGep++;
+                PointsTo* gepPts = new PointsTo();
+                computeGepPts(diffPts, gepEdge, *gepPts);
+                batch.gepPts.push_back(gepPts);
+                addToBatch(gepEdge->getDstID(), gepPts);
+            }
+        }
+    }
+
+    if (consCG->hasNodesToBeCollapsed()) {
+        propagateBatch();
+        while (consCG->hasNodesToBeCollapsed()) {
+            NodeID collapseId = consCG->getNextCollapseNode();
+            if (collapseField(collapseId))
+                reanalyze = true;
+        }
+    }
+
+    double propEnd = stat->getClk();
+    timeOfProcessCopyGep += (propEnd - propStart) / TIMEINTERVAL;
+}
+
+/*!
+ * Add a union into dst to the batch
+ */
+void AndersenWaveDiff::addToBatch(NodeID dst, const PointsTo* pts)
+{
+    PtsBatch::Contribution contribution;
+    contribution.dst = dst;
+    contribution.pts = pts;
+    contribution.changed = false;
+    batch.contributions.push_back(contribution);
+    batch.dsts.set(dst);
+}
+
+/*!
+ * Union all contributions of the batch into their destinations,
+ * then push the changed destinations into the worklist in the sequential order.
+ * Map entries are created beforehand, threads only update points-to sets they own.
+ */
+void AndersenWaveDiff::propagateBatch()
+{
+    std::vector<PtsBatch::Contribution>& contributions = batch.contributions;
+    if (contributions.empty())
+        return;
+
+    if (contributions.size() < MinParallelBatchSize) {
+        for (u32_t i = 0; i < contributions.size(); ++i)
+            contributions[i].changed = unionPts(contributions[i].dst, *contributions[i].pts);
+    }
+    else {
+        PTDataTy* ptd = getPTDataTy();
+        BatchSchedule schedule;
+        schedule.order.resize(contributions.size());
+        for (u32_t i = 0; i < contributions.size(); ++i)
+            schedule.order[i] = i;
+        std::stable_sort(schedule.order.begin(), schedule.order.end(), [&contributions](u32_t a, u32_t b) {
+            return contributions[a].dst < contributions[b].dst;
+        });
+        PointsTo objs;
+        for (u32_t i = 0; i < schedule.order.size(); ++i) {
+            const PtsBatch::Contribution& contribution = contributions[schedule.order[i]];
+            if (i == 0 || contributions[schedule.order[i - 1]].dst != contribution.dst) {
+                schedule.groups.push_back(i);
+                schedule.groupPts.push_back(&ptd->getPts(contribution.dst));
+            }
+            objs |= *contribution.pts;
+        }
+        schedule.groups.push_back(schedule.order.size());
+        for (PointsTo::iterator it = objs.begin(), eit = objs.end(); it != eit; ++it) {
+            schedule.objs.push_back(*it);
+            schedule.revPts.push_back(&ptd->getRevPts(*it));
+        }
+        schedule.nextGroup = 0;
+        schedule.numOfWorkers = numOfThreads;
+
+        {
+            std::lock_guard<std::mutex> lock(workers->mtx);
+            workers->schedule = &schedule;
+            workers->numOfBusy = workers->threads.size();
+            workers->round++;
+        }
+        workers->posted.notify_all();
+        propagateBatchInThread(&schedule, 0);
+        std::unique_lock<std::mutex> lock(workers->mtx);
+        while (workers->numOfBusy > 0)
+            workers->finished.wait(lock);
+    }
+
+    for (u32_t i = 0; i < contributions.size(); ++i) {
+        if (contributions[i].changed)
+            pushIntoWorklist(contributions[i].dst);
+    }
+
+    for (u32_t i = 0; i < batch.gepPts.size(); ++i)
+        delete batch.gepPts[i];
+    batch.gepPts.clear();
+    contributions.clear();
+    batch.dsts.clear();
+}
+
+/*!
+ * Union destinations taken from the schedule, then add the destinations
+ * to the reverse points-to sets of this worker's range of objects.
+ */
+void AndersenWaveDiff::propagateBatchInThread(BatchSchedule* schedule, u32_t worker)
+{
+    std::vector<PtsBatch::Contribution>& contributions = batch.contributions;
+    u32_t numOfGroups = schedule->groupPts.size();
+    for (u32_t group = schedule->nextGroup++; group < numOfGroups; group = schedule->nextGroup++) {
+        PointsTo& dstPts = *schedule->groupPts[group];
+        for (u32_t i = schedule->groups[group]; i < schedule->groups[group + 1]; ++i) {
+            PtsBatch::Contribution& contribution = contributions[schedule->order[i]];
+            contribution.changed = (dstPts |= *contribution.pts);
+        }
+    }
+
+    u32_t numOfObjs = schedule->objs.size();
+    u32_t begin = (u64_t)numOfObjs * worker / schedule->numOfWorkers;
+    u32_t end = (u64_t)numOfObjs * (worker + 1) / schedule->numOfWorkers;
+    if (begin == end)
+        return;
+    NodeID lo = schedule->objs[begin];
+    NodeID hi = schedule->objs[end - 1];
+    for (u32_t i = 0; i < contributions.size(); ++i) {
+        const PointsTo& pts = *contributions[i].pts;
+        u32_t k = begin;
+        for (PointsTo::iterator it = pts.begin(), eit = pts.end(); it != eit; ++it) {
+            NodeID obj = *it;
+            if (obj < lo)
+                continue;
+            if (obj > hi)
+                break;
+            while (schedule->objs[k] < obj)
+                ++k;
+            schedule->revPts[k]->test_and_set(contributions[i].dst);
+        }
+    }
+}
+
+
+/*!
+ * Start numOfThreads - 1 helper threads, the calling thread is the remaining worker
+ */
+void AndersenWaveDiff::startBatchWorkers()
+{
+    workers = new BatchWorkers();
+    workers->schedule = NULL;
+    workers->round = 0;
+    workers->numOfBusy = 0;
+    workers->stop = false;
+    for (u32_t i = 1; i < numOfThreads; ++i)
+        workers->threads.push_back(std::thread(&AndersenWaveDiff::runBatchWorker, this, i));
+}
+
+/*!
+ * Stop and join the helper threads
+ */
+void AndersenWaveDiff::stopBatchWorkers()
+{
+    if (workers == NULL)
+        return;
+    {
+        std::lock_guard<std::mutex> lock(workers->mtx);
+        workers->stop = true;
+    }
+    workers->posted.notify_all();
+    for (u32_t i = 0; i < workers->threads.size(); ++i)
+        workers->threads[i].join();
+    delete workers;
+    workers = NULL;
+}
+
+/*!
+ * Work on every posted batch as the given worker until the helpers are stopped
+ */
+void AndersenWaveDiff::runBatchWorker(u32_t worker)
+{
+    u32_t done = 0;
+    std::unique_lock<std::mutex> lock(workers->mtx);
+    while (true) {
+        while (workers->round == done && !workers->stop)
+            workers->posted.wait(lock);
+        if (workers->stop)
+            break;
+        done = workers->round;
+        BatchSchedule* schedule = workers->schedule;
+        lock.unlock();
+
+        propagateBatchInThread(schedule, worker);
+
+        lock.lock();
+        if (--workers->numOfBusy == 0)
+            workers->finished.notify_one();
+    }
+}
 
 
 /*!
@@ -0,0 +1,123 @@
+/*
+ * worklist_bench.cpp
+ *
+ *  Micro-benchmark of the FIFO worklists in Util/WorkList.h against the
+ *  previous std::deque + std::set implementation.
+ *
+ *  Build and run from the root of the repository:
+ *    g++ -O2 -std=c++11 -Iinclude tests/micro-benchmarks/worklist/worklist_bench.cpp -o worklist_bench
+ *    ./worklist_bench [#nodes] [#pushes]
+ *
+ *  The workload mimics a solver: a node popped from the worklist pushes a few
+ *  successors, many of which are already in the list.
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#include "Util/WorkList.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+
+/// The FIFO worklist before membership sets were chosen by WorkListTraits
+template<class Data>
+class LegacyFIFOWorkList {
+    typedef std::set<Data> DataSet;
+    typedef std::deque<Data> DataDeque;
+public:
+    inline bool empty() const {
+        return data_list.empty();
+    }
+    inline bool push(Data data) {
+        if (data_set.find(data) == data_set.end()) {
+            data_list.push_back(data);
+            data_set.insert(data);
+            return true;
+        }
+        else
+            return false;
+    }
+    inline Data pop() {
+        Data data = data_list.front();
+        data_list.pop_front();
+        data_set.erase(data);
+        return data;
+    }
+private:
+    DataSet data_set;
+    DataDeque data_list;
+};
+
+/// A composite key, like the context-sensitive statements of MTA
+struct CxtKey {
+    unsigned tid;
+    unsigned stmt;
+    CxtKey(unsigned t, unsigned s) : tid(t), stmt(s) {}
+    inline bool operator<(const CxtKey& rhs) const {
+        return tid < rhs.tid || (tid == rhs.tid && stmt < rhs.stmt);
+    }
+    inline bool operator==(const CxtKey& rhs) const {
+        return tid == rhs.tid && stmt == rhs.stmt;
+    }
+};
+
+struct CxtKeyHash {
+    inline size_t operator()(const CxtKey& key) const {
+        return std::hash<unsigned long long>()(((unsigned long long)key.tid << 32) | key.stmt);
+    }
+};
+
+inline CxtKey makeKey(unsigned id, CxtKey*) {
+    return CxtKey(id % 8, id / 8);
+}
+inline unsigned makeKey(unsigned id, unsigned*) {
+    return id;
+}
+
+/*!
+ * Run the workload, return the number of pops and set the elapsed time in ms
+ */
+template<class WorkList, class Data>
+unsigned long long run(unsigned numOfNodes, unsigned long long numOfPushes, double& ms) {
+    std::mt19937 rng(17);
+    std::uniform_int_distribution<unsigned> node(0, numOfNodes - 1);
+    std::uniform_int_distribution<unsigned> fanout(1, 4);
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    WorkList worklist;
+    unsigned long long pushes = 0, pops = 0;
+    for (unsigned i = 0; i < numOfNodes; i += 16)
+        worklist.push(makeKey(i, (Data*)0));
+    while (!worklist.empty()) {
+        worklist.pop();
+        pops++;
+        for (unsigned i = 0, e = fanout(rng); i < e && pushes < numOfPushes; ++i, ++pushes)
+            worklist.push(makeKey(node(rng), (Data*)0));
+    }
+    ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return pops;
+}
+
+template<class WorkList, class Data>
+void report(const char* name, unsigned numOfNodes, unsigned long long numOfPushes) {
+    double ms = 0;
+    unsigned long long pops = run<WorkList, Data>(numOfNodes, numOfPushes, ms);
+    std::printf("%-44s %12llu pops %10.1f ms\n", name, pops, ms);
+}
+
+int main(int argc, char** argv) {
+    unsigned numOfNodes = argc > 1 ? std::strtoul(argv[1], NULL, 10) : 100000;
+    unsigned long long numOfPushes = argc > 2 ? std::strtoull(argv[2], NULL, 10) : 5000000;
+    std::printf("%u nodes, %llu pushes\n", numOfNodes, numOfPushes);
+
+    report<LegacyFIFOWorkList<unsigned>, unsigned>("NodeID   deque + std::set", numOfNodes, numOfPushes);
+    report<FIFOWorkList<unsigned, OrderedMemberSet<unsigned> >, unsigned>("NodeID   ring buffer + std::set", numOfNodes, numOfPushes);
+    report<FIFOWorkList<unsigned, HashMemberSet<unsigned> >, unsigned>("NodeID   ring buffer + hash set", numOfNodes, numOfPushes);
+    report<FIFOWorkList<unsigned>, unsigned>("NodeID   ring buffer + bitmap (default)", numOfNodes, numOfPushes);
+
+    report<LegacyFIFOWorkList<CxtKey>, CxtKey>("CxtKey   deque + std::set", numOfNodes, numOfPushes);
+    report<FIFOWorkList<CxtKey>, CxtKey>("CxtKey   ring buffer + std::set (default)", numOfNodes, numOfPushes);
+    report<FIFOWorkList<CxtKey, HashMemberSet<CxtKey, CxtKeyHash> >, CxtKey>("CxtKey   ring buffer + hash set", numOfNodes, numOfPushes);
+    return 0;
+}
@@ -0,0 +1,26 @@
+/*
+ * Self race check: a store run by two threads races with itself
+ * Date: 17/10/2026
+ */
+#include "pthread.h"
+#include "aliascheck.h"
+
+int Global;
+
+void *foo(void *x) {
+  Global = 42; /* EXPECTED-RACE: 11 11 */
+  RC_ACCESS(1, RC_ALIAS | RC_MHP | RC_RACE);
+  RC_ACCESS(1, RC_ALIAS | RC_MHP | RC_RACE);
+  return x;
+}
+
+int main() {
+  pthread_t t1, t2;
+
+  pthread_create(&t1, NULL, foo, NULL);
+  pthread_create(&t2, NULL, foo, NULL);
+  pthread_join(t1, NULL);
+  pthread_join(t2, NULL);
+
+  return Global;
+}
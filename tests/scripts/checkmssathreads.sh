@@ -0,0 +1,83 @@
+#/bin/bash
+###############################
+#
+# Script to check that building memory SSA with multiple threads gives the IDs of the sequential build
+# Parameters:
+# 1st parameter($1) : number of threads to compare with the sequential build (default: 4)
+# other parameters  : folders of c files to analyze (default: fs_tests mta)
+#
+# The flow-sensitive analysis is run with -mssa-threads=1 and with the given number
+# of threads. The IDs of all memory SSA versions (-dump-mrver-ids) and the SVFG
+# dumped before solving (FS_SVFG.dot, -dump-svfg) must be identical. Dot nodes are
+# named after their addresses, which differ between runs, so they are renamed
+# after their SVFG node IDs before comparing. The script exits with 1 otherwise
+#
+##############################
+
+THREADS=${1:-4}
+shift
+TestFolders=${@:-"fs_tests mta"}
+EXEFILE=$PTABIN/wpa
+FLAGS="-fspta -stat=false -dump-mrver-ids -dump-svfg"
+CLANGFLAG='-g -c -emit-llvm -I.'
+LLVMOPTFLAG='-mem2reg'
+COMPILELOG="compile.log"
+WORKDIR=`mktemp -d`
+
+### rename dot nodes "Node0x..." after the "NodeID: <id>" of their labels
+normalizedot()
+{
+    awk 'NR == FNR {
+             if (match($0, /^[ \t]*Node0x[0-9a-f]+ \[/)) {
+                 node = $1
+                 if (match($0, /NodeID: [0-9]+/))
+                     id[node] = substr($0, RSTART + 8, RLENGTH - 8)
+             }
+             next
+         }
+         {
+             line = $0
+             out = ""
+             while (match(line, /Node0x[0-9a-f]+/)) {
+                 out = out substr(line, 1, RSTART - 1) "N" id[substr(line, RSTART, RLENGTH)]
+                 line = substr(line, RSTART + RLENGTH)
+             }
+             print out line
+         }' $1 $1
+}
+
+### run the analysis in its own directory, keep the dumped IDs and the normalized SVFG
+runmssa()
+{
+    rm -rf $WORKDIR/$2
+    mkdir -p $WORKDIR/$2
+    (cd $WORKDIR/$2 && $EXEFILE $FLAGS -mssa-threads=$3 $1 > ids 2>&1)
+    normalizedot $WORKDIR/$2/FS_SVFG.dot > $WORKDIR/$2/svfg 2>/dev/null
+}
+
+rm -rf $COMPILELOG
+numOfFiles=0
+numOfMismatches=0
+for folder in $TestFolders
+do
+    for i in `find $PTATEST/$folder -name '*.c'`
+    do
+        FileName=${i%.*}
+        $CLANG -I$PTATEST $CLANGFLAG $i -o $FileName.bc >>$COMPILELOG 2>&1 || continue
+        $LLVMOPT $LLVMOPTFLAG $FileName.bc -o $FileName.opt
+        Input=`readlink -f $FileName.opt`
+        runmssa $Input seq 1
+        runmssa $Input par $THREADS
+        numOfFiles=$((numOfFiles + 1))
+        if ! cmp -s $WORKDIR/seq/ids $WORKDIR/par/ids || ! cmp -s $WORKDIR/seq/svfg $WORKDIR/par/svfg; then
+            echo "memory SSA or SVFG IDs differ: ${i#$PTATEST/}"
+            numOfMismatches=$((numOfMismatches + 1))
+        fi
+    done
+done
+rm -rf $WORKDIR
+
+echo "$numOfMismatches of $numOfFiles files differ with $THREADS threads"
+if [ $numOfMismatches -ne 0 ]; then
+    exit 1
+fi
@@ -0,0 +1,45 @@
+#/bin/bash
+###############################
+#
+# Script to check that MHP and lock analysis give the same results with and without -mta-region
+# Parameters:
+# parameters : folders of c files to analyze (default: mta)
+#
+# Both runs must print the same RC_ACCESS validation results and write the same
+# sorted race report, whose pairs are checked by MHP and lockset queries. The
+# script exits with 1 if any file differs
+#
+##############################
+
+TestFolders=${@:-"mta"}
+EXEFILE=$PTABIN/mta
+FLAGS="-stat=false -mhp -race-report=/dev/null -race-report-format=text"
+CLANGFLAG='-g -c -emit-llvm -I.'
+LLVMOPTFLAG='-mem2reg'
+COMPILELOG="compile.log"
+
+rm -rf $COMPILELOG
+numOfFiles=0
+numOfMismatches=0
+for folder in $TestFolders
+do
+    for i in `find $PTATEST/$folder -name '*.c'`
+    do
+        FileName=${i%.*}
+        $CLANG -I$PTATEST $CLANGFLAG $i -o $FileName.bc >>$COMPILELOG 2>&1 || continue
+        $LLVMOPT $LLVMOPTFLAG $FileName.bc -o $FileName.opt
+        $EXEFILE $FLAGS -mta-region=false -race-report-sorted=$FileName.races.inst $FileName.opt > $FileName.out.inst 2>&1
+        $EXEFILE $FLAGS -mta-region=true -race-report-sorted=$FileName.races.region $FileName.opt > $FileName.out.region 2>&1
+        numOfFiles=$((numOfFiles + 1))
+        if ! cmp -s $FileName.out.inst $FileName.out.region || ! cmp -s $FileName.races.inst $FileName.races.region; then
+            echo "results differ with -mta-region: ${i#$PTATEST/}"
+            numOfMismatches=$((numOfMismatches + 1))
+        fi
+        rm -f $FileName.out.inst $FileName.out.region $FileName.races.inst $FileName.races.region
+    done
+done
+
+echo "$numOfMismatches of $numOfFiles files differ with -mta-region"
+if [ $numOfMismatches -ne 0 ]; then
+    exit 1
+fi
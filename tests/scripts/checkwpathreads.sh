@@ -0,0 +1,48 @@
+#/bin/bash
+###############################
+#
+# Script to check that the multi-threaded AndersenWaveDiff gives the points-to sets of the sequential one
+# Parameters:
+# 1st parameter($1) : number of threads to compare with the sequential solver (default: 4)
+# other parameters  : folders of c files to analyze (default: fi_tests cs_tests complex_tests mta)
+#
+# Every batch is propagated by the threads (-ander-min-batch=1), so that the
+# small test programs exercise the parallel path. The -print-pts outputs of
+# both runs must be identical, the script exits with 1 otherwise
+#
+##############################
+
+THREADS=${1:-4}
+shift
+TestFolders=${@:-"fi_tests cs_tests complex_tests mta"}
+EXEFILE=$PTABIN/wpa
+FLAGS="-ander -print-pts -stat=false"
+CLANGFLAG='-g -c -emit-llvm -I.'
+LLVMOPTFLAG='-mem2reg -mergereturn'
+COMPILELOG="compile.log"
+
+rm -rf $COMPILELOG
+numOfFiles=0
+numOfMismatches=0
+for folder in $TestFolders
+do
+    for i in `find $PTATEST/$folder -name '*.c'`
+    do
+        FileName=${i%.*}
+        $CLANG -I$PTATEST $CLANGFLAG $i -o $FileName.bc >>$COMPILELOG 2>&1 || continue
+        $LLVMOPT $LLVMOPTFLAG $FileName.bc -o $FileName.opt
+        $EXEFILE $FLAGS -ander-threads=1 $FileName.opt > $FileName.pts.seq 2>&1
+        $EXEFILE $FLAGS -ander-threads=$THREADS -ander-min-batch=1 $FileName.opt > $FileName.pts.par 2>&1
+        numOfFiles=$((numOfFiles + 1))
+        if ! cmp -s $FileName.pts.seq $FileName.pts.par; then
+            echo "points-to sets differ: ${i#$PTATEST/}"
+            numOfMismatches=$((numOfMismatches + 1))
+        fi
+        rm -f $FileName.pts.seq $FileName.pts.par
+    done
+done
+
+echo "$numOfMismatches of $numOfFiles files differ with $THREADS threads"
+if [ $numOfMismatches -ne 0 ]; then
+    exit 1
+fi
@@ -0,0 +1,47 @@
+#/bin/bash
+###############################
+#
+# Script to check the race report of MTA against the races expected by a test program
+# Parameters:
+# 1st parameter($1) : bitcode file with .opt file extension (e.g. test.opt), its source is test.c
+#
+# Every "EXPECTED-RACE: <line1> <line2>" comment in the source, with line1 <= line2,
+# must be reported as a race between those lines of the source file. The races go
+# through pair generation and checking (RacePairChecker), unlike the RC_ACCESS
+# validators, which only query MHP and lockset results.
+#
+##############################
+
+TNAME=mta
+EXEFILE=$PTABIN/mta
+FileName=${1%.opt}
+Source=$FileName.c
+Report=$FileName.races
+FLAGS="-stat=false -race-report=$Report -race-report-format=text"
+
+if [ ! -f $Source ]; then
+    echo "no source file $Source"
+    exit 1
+fi
+
+rm -f $Report
+$EXEFILE $FLAGS $1 > /dev/null 2>&1
+
+### the text report has four lines per race: line and file of both accesses
+reported=`awk 'NR % 4 == 1 { l1 = $0 } NR % 4 == 3 { l2 = $0; if (l1 + 0 > l2 + 0) { t = l1; l1 = l2; l2 = t } print l1 " " l2 }' $Report 2>/dev/null`
+
+missing=0
+while read -r l1 l2
+do
+    [ -z "$l1" ] && continue
+    if ! echo "$reported" | grep -qx "$l1 $l2"; then
+        echo "race between lines $l1 and $l2 of $Source is not reported"
+        missing=$((missing + 1))
+    fi
+done <<< "`sed -n 's/.*EXPECTED-RACE: *\([0-9]*\) *\([0-9]*\).*/\1 \2/p' $Source`"
+
+rm -f $Report
+if [ $missing -ne 0 ]; then
+    exit 1
+fi
+echo "all expected races of $Source are reported"
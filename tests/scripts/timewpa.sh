@@ -0,0 +1,67 @@
+#/bin/bash
+###############################
+#
+# Script to compare the solve time of two WPA builds on the test folders
+# Parameters:
+# 1st parameter($1) : wpa command before the change (e.g. "$OLDBIN/wpa -ander")
+# 2nd parameter($2) : wpa command after the change (e.g. "$PTABIN/wpa -ander")
+# other parameters  : folders of c files to analyze (default: fi_tests cs_tests complex_tests mta)
+# Set REPEAT to run each command several times, the fastest run is kept
+#
+# The TotalTime of -stat is reported in seconds for every file, and summed
+# over all files at the end
+#
+##############################
+
+if [ $# -lt 2 ]
+  then
+      echo "usage: timewpa.sh \"<wpa before>\" \"<wpa after>\" [folders]"
+      exit 1
+fi
+
+BEFORE=$1
+AFTER=$2
+shift 2
+TestFolders=${@:-"fi_tests cs_tests complex_tests mta"}
+REPEAT=${REPEAT:-3}
+CLANGFLAG='-g -c -emit-llvm -I.'
+LLVMOPTFLAG='-mem2reg -mergereturn'
+COMPILELOG="compile.log"
+
+### fastest TotalTime of REPEAT runs of a command on a bitcode file
+solvetime()
+{
+    best=""
+    for ((r = 0; r < REPEAT; r++))
+    do
+        t=`$1 -stat=true $2 2>/dev/null | awk '$1 == "TotalTime" { print $2; exit }'`
+        if [[ -z $t ]]; then
+            echo "NA"
+            return
+        fi
+        best=`awk -v a="$best" -v b="$t" 'BEGIN { print (a == "" || b < a) ? b : a }'`
+    done
+    echo $best
+}
+
+rm -rf $COMPILELOG
+printf "%-50s %12s %12s\n" "file" "before(s)" "after(s)"
+totalBefore=0
+totalAfter=0
+for folder in $TestFolders
+do
+    for i in `find $PTATEST/$folder -name '*.c'`
+    do
+        FileName=${i%.*}
+        $CLANG -I$PTATEST $CLANGFLAG $i -o $FileName.bc >>$COMPILELOG 2>&1 || continue
+        $LLVMOPT $LLVMOPTFLAG $FileName.bc -o $FileName.opt
+        before=`solvetime "$BEFORE" $FileName.opt`
+        after=`solvetime "$AFTER" $FileName.opt`
+        printf "%-50s %12s %12s\n" ${i#$PTATEST/} $before $after
+        if [[ $before != "NA" && $after != "NA" ]]; then
+            totalBefore=`awk -v a=$totalBefore -v b=$before 'BEGIN { print a + b }'`
+            totalAfter=`awk -v a=$totalAfter -v b=$after 'BEGIN { print a + b }'`
+        fi
+    done
+done
+printf "%-50s %12s %12s\n" "total" $totalBefore $totalAfter